@@ -0,0 +1,86 @@
+/*
+    ALLOCATORS.C - Arenas and pools against glibc malloc
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <ports/memory/allocators.h>
+
+#include <stdlib.h>
+
+#include "bench.h"
+
+/* Objects are freed (or the arena reset) in batches of this many */
+#define BATCH 256
+
+typedef struct {
+    uint64_t    key;
+    uint64_t    value;
+    void*       next;
+} Node;
+
+static void* objects[BATCH];
+
+int main(void)
+{
+    long iterations = bench_iterations(20000000);
+
+    BENCH_RUN("malloc + free", iterations, {
+        objects[i % BATCH] = malloc(sizeof(Node));
+        BENCH_KEEP(objects[i % BATCH]);
+
+        if (i % BATCH == BATCH - 1)
+            for (int j = 0; j < BATCH; j++) free(objects[j]);
+    });
+
+    BENCH_RUN("memory_malloc + free", iterations, {
+        objects[i % BATCH] = unwrap(void_ptr, memory_malloc(sizeof(Node)));
+        BENCH_KEEP(objects[i % BATCH]);
+
+        if (i % BATCH == BATCH - 1)
+            for (int j = 0; j < BATCH; j++) free(objects[j]);
+    });
+
+    MemoryArena arena;
+    memory_arena_init(&arena, 0, 0);
+
+    BENCH_RUN("memory_arena_new + reset", iterations, {
+        Result(void_ptr) node = memory_arena_new(&arena, Node);
+        if (is_err(node)) abort();
+        BENCH_KEEP(node.value);
+
+        if (i % BATCH == BATCH - 1) memory_arena_reset(&arena);
+    });
+
+    memory_arena_free(&arena);
+
+    MemoryPool pool;
+    memory_pool_init(&pool, sizeof(Node), 0, 0);
+
+    BENCH_RUN("memory_pool_alloc + release", iterations, {
+        Result(void_ptr) node = memory_pool_alloc(&pool);
+        if (is_err(node)) abort();
+        objects[i % BATCH] = node.value;
+        BENCH_KEEP(node.value);
+
+        if (i % BATCH == BATCH - 1)
+            for (int j = 0; j < BATCH; j++)
+                memory_pool_release(&pool, objects[j]);
+    });
+
+    memory_pool_free(&pool);
+
+    return 0;
+}
@@ -0,0 +1,82 @@
+/*
+    BENCH.H - Timing shared by the benchmark programs
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__BENCH___
+#define ___RESULT__BENCH___
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <time.h>
+
+/* Every benchmark is run this many times, the fastest run is reported */
+#define BENCH_REPEATS 5
+
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+/* Keeps the compiler from dropping a computed scalar */
+#define BENCH_KEEP(value) __asm__ __volatile__("" : : "g"(value) : "memory")
+
+static inline void bench_report(const char* name, double ns)
+{
+    printf("%-48s %10.2f ns\n", name, ns);
+}
+
+/*
+    Runs the body iterations times, with i counting them, and reports the
+    time of a single iteration. The body is expanded inline, so only what it
+    does is measured, not a call through a pointer.
+*/
+#define BENCH_RUN(name, iterations, body)                                       \
+    do {                                                                        \
+        double ___best = 0;                                                     \
+                                                                                \
+        for (int ___repeat = 0; ___repeat < BENCH_REPEATS; ___repeat++) {       \
+            uint64_t ___start = bench_now_ns();                                 \
+                                                                                \
+            for (long i = 0; i < (long) (iterations); i++) {                    \
+                body;                                                           \
+            }                                                                   \
+                                                                                \
+            double ___ns = (double) (bench_now_ns() - ___start)                 \
+                           / (double) (iterations);                             \
+            if (___repeat == 0 || ___ns < ___best) ___best = ___ns;             \
+        }                                                                       \
+                                                                                \
+        bench_report(name, ___best);                                            \
+    } while (0)
+
+/* The iterations can be scaled down with BENCH_SCALE=0.1 for quick runs */
+static inline long bench_iterations(long iterations)
+{
+    const char* scale = getenv("BENCH_SCALE");
+
+    if (scale == NULL) return iterations;
+
+    long scaled = (long) ((double) iterations * atof(scale));
+    return scaled > 0 ? scaled : 1;
+}
+
+#endif
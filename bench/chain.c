@@ -0,0 +1,117 @@
+/*
+    CHAIN.C - result_chain against hand-written early returns
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <result.h>
+
+#include "bench.h"
+
+ERROR_DEFINE(BenchFailure, OtherErrorExitCode, "The benchmark failed on purpose.")
+
+/* Stages building their results inline, as small parsers and validators do */
+#define STAGE_OK(x) ((Result(int)) { .value = (x) })
+#define STAGE_ERR ((Result(int)) { .error = &___ERROR__BenchFailure })
+
+static inline Result(int) add_one(int x) { return STAGE_OK(x + 1); }
+static inline Result(int) twice(int x) { return STAGE_OK(x * 2); }
+
+static inline Result(int) below(int x)
+{
+    return x < 100000 ? STAGE_OK(x) : STAGE_ERR;
+}
+
+static inline Result(int) minus_three(int x) { return STAGE_OK(x - 3); }
+
+/* The same stages with result_OK and result_ERR, calls into the library */
+static inline Result(int) add_one_lib(int x) { return result_OK(int, x + 1); }
+static inline Result(int) twice_lib(int x) { return result_OK(int, x * 2); }
+
+static inline Result(int) below_lib(int x)
+{
+    return x < 100000 ? result_OK(int, x) : result_ERR(int, BenchFailure);
+}
+
+static inline Result(int) minus_three_lib(int x)
+{
+    return result_OK(int, x - 3);
+}
+
+#define PIPELINES(suffix)                                                       \
+    __attribute__((noinline))                                                   \
+    static Result(int) by_hand ## suffix(int x)                                 \
+    {                                                                           \
+        Result(int) r = add_one ## suffix(x);                                   \
+        if (result_is_err(r)) return r;                                         \
+        r = twice ## suffix(r.value);                                           \
+        if (result_is_err(r)) return r;                                         \
+        r = below ## suffix(r.value);                                           \
+        if (result_is_err(r)) return r;                                         \
+        return minus_three ## suffix(r.value);                                  \
+    }                                                                           \
+                                                                                \
+    __attribute__((noinline))                                                   \
+    static Result(int) by_chain ## suffix(int x)                                \
+    {                                                                           \
+        return result_chain(int, add_one ## suffix(x), twice ## suffix,         \
+                            below ## suffix, minus_three ## suffix);            \
+    }                                                                           \
+                                                                                \
+    __attribute__((noinline))                                                   \
+    static Result(int) by_and_then ## suffix(int x)                             \
+    {                                                                           \
+        return result_and_then(int,                                             \
+                   result_and_then(int,                                         \
+                       result_and_then(int, add_one ## suffix(x),               \
+                                       twice ## suffix),                        \
+                       below ## suffix),                                        \
+                   minus_three ## suffix);                                      \
+    }
+
+PIPELINES()
+PIPELINES(_lib)
+
+/* The inputs of the error runs fail at the third stage */
+#define INPUT(i) ((int) ((i) & 1023) + (error ? 100000 : 0))
+
+#define BENCH_PIPELINE(name, pipeline)                                          \
+    BENCH_RUN(name, iterations, {                                               \
+        Result(int) result = pipeline(INPUT(i));                                \
+        if (result_is_err(result) != error) abort();                            \
+        BENCH_KEEP(result.value);                                               \
+    })
+
+int main(void)
+{
+    long iterations = bench_iterations(20000000);
+
+    for (int error = 0; error <= 1; error++) {
+        printf("%s\n", error ? "error at the third stage:" : "ok:");
+
+        BENCH_PIPELINE("4 inline stages, hand-written early returns",
+                       by_hand);
+        BENCH_PIPELINE("4 inline stages, result_chain", by_chain);
+        BENCH_PIPELINE("4 inline stages, nested result_and_then",
+                       by_and_then);
+        BENCH_PIPELINE("4 result_OK stages, hand-written early returns",
+                       by_hand_lib);
+        BENCH_PIPELINE("4 result_OK stages, result_chain", by_chain_lib);
+        BENCH_PIPELINE("4 result_OK stages, nested result_and_then",
+                       by_and_then_lib);
+    }
+
+    return 0;
+}
@@ -0,0 +1,284 @@
+/*
+    CHANNEL.C - Channels against a queue behind a mutex
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <channel.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#define CAPACITY 1024
+#define MAX_THREADS 64
+#define BATCH 32
+
+CHANNEL_DECLARE(int64_t)
+
+/* The baseline, a ring of the same results behind a mutex and two conditions */
+typedef struct {
+    pthread_mutex_t     lock;
+    pthread_cond_t      not_empty;
+    pthread_cond_t      not_full;
+    Result(int64_t)     items[CAPACITY];
+    size_t              head;
+    size_t              count;
+    bool                closed;
+} Queue;
+
+static void queue_push(Queue* queue, Result(int64_t) item)
+{
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == CAPACITY)
+        pthread_cond_wait(&queue->not_full, &queue->lock);
+
+    queue->items[(queue->head + queue->count++) % CAPACITY] = item;
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+static bool queue_pop(Queue* queue, Result(int64_t)* item)
+{
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0 && !queue->closed)
+        pthread_cond_wait(&queue->not_empty, &queue->lock);
+
+    bool popped = queue->count != 0;
+    if (popped) {
+        *item = queue->items[queue->head];
+        queue->head = (queue->head + 1) % CAPACITY;
+        queue->count--;
+        pthread_cond_signal(&queue->not_full);
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+    return popped;
+}
+
+static void queue_close(Queue* queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    queue->closed = true;
+    pthread_cond_broadcast(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+static Channel(int64_t) channel;
+static Queue queue;
+static long items_per_producer;
+
+static void* channel_produce(void* context)
+{
+    (void) context;
+
+    for (long i = 0; i < items_per_producer; i++)
+        if (is_err(channel_push(int64_t, &channel, result_OK(int64_t, i),
+                                RESULT_WAIT_FOREVER)))
+            abort();
+
+    return NULL;
+}
+
+static void* channel_consume(void* context)
+{
+    Result(int64_t) item = result_OK(int64_t, 0);
+    int64_t sum = 0;
+
+    (void) context;
+
+    while (is_ok(channel_pop(int64_t, &channel, &item, RESULT_WAIT_FOREVER)))
+        sum += item.value;
+
+    BENCH_KEEP(sum);
+    return NULL;
+}
+
+static void* channel_produce_batch(void* context)
+{
+    Result(int64_t) items[BATCH];
+
+    (void) context;
+
+    for (long i = 0; i < items_per_producer; i += BATCH) {
+        size_t count = items_per_producer - i < BATCH
+                           ? (size_t) (items_per_producer - i) : BATCH;
+
+        for (size_t j = 0; j < count; j++)
+            items[j] = result_OK(int64_t, i + (long) j);
+
+        if (is_err(channel_push_batch(int64_t, &channel, items, count,
+                                      RESULT_WAIT_FOREVER)))
+            abort();
+    }
+
+    return NULL;
+}
+
+static void* channel_consume_batch(void* context)
+{
+    Result(int64_t) items[BATCH];
+    int64_t sum = 0;
+
+    (void) context;
+
+    for (;;) {
+        Result(size_t) popped = channel_pop_batch(int64_t, &channel, items,
+                                                  BATCH, RESULT_WAIT_FOREVER);
+
+        for (size_t j = 0; j < popped.value; j++) sum += items[j].value;
+        if (is_err(popped)) break;
+    }
+
+    BENCH_KEEP(sum);
+    return NULL;
+}
+
+static void* queue_produce(void* context)
+{
+    (void) context;
+
+    for (long i = 0; i < items_per_producer; i++)
+        queue_push(&queue, result_OK(int64_t, i));
+
+    return NULL;
+}
+
+static void* queue_consume(void* context)
+{
+    Result(int64_t) item = result_OK(int64_t, 0);
+    int64_t sum = 0;
+
+    (void) context;
+
+    while (queue_pop(&queue, &item)) sum += item.value;
+
+    BENCH_KEEP(sum);
+    return NULL;
+}
+
+typedef enum { MUTEX_QUEUE, CHANNEL, CHANNEL_BATCH } Kind;
+
+static void* (*const producers_of[])(void*) = {
+    [MUTEX_QUEUE] = &queue_produce,
+    [CHANNEL] = &channel_produce,
+    [CHANNEL_BATCH] = &channel_produce_batch,
+};
+
+static void* (*const consumers_of[])(void*) = {
+    [MUTEX_QUEUE] = &queue_consume,
+    [CHANNEL] = &channel_consume,
+    [CHANNEL_BATCH] = &channel_consume_batch,
+};
+
+/* A single thread pushes and pops in turns, one item or one batch at a time */
+static void run_alone(Kind kind, long items)
+{
+    Result(int64_t) batch[BATCH];
+    Result(int64_t) item = result_OK(int64_t, 0);
+
+    for (long i = 0; i < items; i++) {
+        switch (kind) {
+        case MUTEX_QUEUE:
+            queue_push(&queue, result_OK(int64_t, i));
+            queue_pop(&queue, &item);
+            break;
+        case CHANNEL:
+            channel_push(int64_t, &channel, result_OK(int64_t, i), 0);
+            channel_pop(int64_t, &channel, &item, 0);
+            break;
+        case CHANNEL_BATCH:
+            batch[i % BATCH] = result_OK(int64_t, i);
+            if (i % BATCH != BATCH - 1 && i != items - 1) continue;
+
+            size_t count = (size_t) (i % BATCH) + 1;
+            channel_push_batch(int64_t, &channel, batch, count, 0);
+            channel_pop_batch(int64_t, &channel, batch, count, 0);
+            item = batch[count - 1];
+            break;
+        }
+
+        BENCH_KEEP(item.value);
+    }
+}
+
+/*
+    Half of the threads produce and half consume, a single thread pushes and
+    pops in turns. Reports the time per item of the fastest run.
+*/
+static void run(const char* name, Kind kind, int threads, long items)
+{
+    pthread_t producers[MAX_THREADS / 2];
+    pthread_t consumers[MAX_THREADS / 2];
+    int pairs = threads / 2;
+    double best = 0;
+
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        if (kind != MUTEX_QUEUE) {
+            if (is_err(channel_init(int64_t, &channel, CAPACITY))) abort();
+        } else {
+            queue = (Queue) {
+                .lock = PTHREAD_MUTEX_INITIALIZER,
+                .not_empty = PTHREAD_COND_INITIALIZER,
+                .not_full = PTHREAD_COND_INITIALIZER,
+            };
+        }
+
+        uint64_t start = bench_now_ns();
+
+        if (pairs == 0) {
+            run_alone(kind, items);
+        } else {
+            items_per_producer = items / pairs;
+
+            for (int i = 0; i < pairs; i++) {
+                pthread_create(&producers[i], NULL, producers_of[kind], NULL);
+                pthread_create(&consumers[i], NULL, consumers_of[kind], NULL);
+            }
+
+            for (int i = 0; i < pairs; i++) pthread_join(producers[i], NULL);
+
+            if (kind != MUTEX_QUEUE) channel_close(int64_t, &channel);
+            else queue_close(&queue);
+
+            for (int i = 0; i < pairs; i++) pthread_join(consumers[i], NULL);
+        }
+
+        double ns = (double) (bench_now_ns() - start) / (double) items;
+        if (repeat == 0 || ns < best) best = ns;
+
+        if (kind != MUTEX_QUEUE) channel_destroy(int64_t, &channel);
+    }
+
+    char label[64];
+    snprintf(label, sizeof(label), "%s, %d thread%s", name, threads,
+             threads == 1 ? "" : "s");
+    bench_report(label, best);
+}
+
+int main(void)
+{
+    long items = bench_iterations(2000000);
+
+    for (int threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        run("channel", CHANNEL, threads, items);
+        run("channel batch 32", CHANNEL_BATCH, threads, items);
+        run("mutex queue", MUTEX_QUEUE, threads, items);
+    }
+
+    return 0;
+}
@@ -0,0 +1,27 @@
+#!/bin/sh
+# Prints the code size of the library: the sections, the dynamic symbols and
+# relocations, and the methods of a single result type.
+# usage: codegen-size.sh <libresult.so or libresult.a>
+
+library="$1"
+
+if [ -z "$library" ] || [ ! -f "$library" ]; then
+    echo "usage: $0 <library>" >&2
+    exit 2
+fi
+
+echo "Sections of $library:"
+size -A "$library" | awk '$1 ~ /^\.(text|text\.unlikely|text\.hot|dynsym|dynstr|rela\.dyn|rela\.plt|data\.rel\.ro|rodata)$/ {
+    sizes[$1] += $2 }
+    END { for (name in sizes) printf "    %-20s %10d bytes\n", name, sizes[name] }' | sort
+
+case "$library" in
+    *.so*)
+        echo "Dynamic symbols:     $(nm -D --defined-only "$library" | wc -l)"
+        echo "Dynamic relocations: $(readelf -r "$library" | grep -c '^[0-9a-f]')"
+        ;;
+esac
+
+echo "Methods of Result(int):"
+nm -S -t d --size-sort "$library" 2>/dev/null | awk '$4 ~ /^___RESULT_(int|panic)_/ && $4 !~ /_(fast|least)[0-9]/ {
+    printf "    %-40s %6d bytes\n", $4, $2 }'
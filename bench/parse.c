@@ -0,0 +1,93 @@
+/*
+    PARSE.C - Number parsers against strtol and strtod
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <ports/parse/numbers.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+#define NUMBERS 1024
+
+static char integers[NUMBERS][24];
+static char decimals[NUMBERS][32];
+static size_t integer_lengths[NUMBERS];
+static size_t decimal_lengths[NUMBERS];
+
+static void prepare(void)
+{
+    uint64_t state = 0x9E3779B97F4A7C15u;
+
+    for (int i = 0; i < NUMBERS; i++) {
+        state = state * 6364136223846793005u + 1442695040888963407u;
+
+        /* Numbers of every length, from 1 to 19 digits */
+        int64_t integer = (int64_t) (state >> 1) >> (state % 61);
+        if (state & 1) integer = -integer;
+
+        integer_lengths[i] = (size_t) snprintf(integers[i], sizeof(integers[i]),
+                                               "%lld", (long long) integer);
+        decimal_lengths[i] = (size_t) snprintf(decimals[i], sizeof(decimals[i]),
+                                               "%.*f", (int) (state % 7),
+                                               (double) integer / 1e9);
+    }
+}
+
+int main(void)
+{
+    long iterations = bench_iterations(10000000);
+
+    prepare();
+
+    BENCH_RUN("strtol", iterations, {
+        char* end;
+        long value = strtol(integers[i % NUMBERS], &end, 10);
+        BENCH_KEEP(value);
+        BENCH_KEEP(end);
+    });
+
+    BENCH_RUN("parse_int64_t", iterations, {
+        size_t consumed;
+        Result(int64_t) value = parse_int64_t(integers[i % NUMBERS],
+                                              integer_lengths[i % NUMBERS],
+                                              &consumed);
+        BENCH_KEEP(value.value);
+        BENCH_KEEP(value.error);
+        BENCH_KEEP(consumed);
+    });
+
+    BENCH_RUN("strtod", iterations, {
+        char* end;
+        double value = strtod(decimals[i % NUMBERS], &end);
+        BENCH_KEEP(value);
+        BENCH_KEEP(end);
+    });
+
+    BENCH_RUN("parse_double", iterations, {
+        size_t consumed;
+        Result(double) value = parse_double(decimals[i % NUMBERS],
+                                            decimal_lengths[i % NUMBERS],
+                                            &consumed);
+        BENCH_KEEP(value.value);
+        BENCH_KEEP(value.error);
+        BENCH_KEEP(consumed);
+    });
+
+    return 0;
+}
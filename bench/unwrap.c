@@ -0,0 +1,62 @@
+/*
+    UNWRAP.C - Cost of the happy and error paths of results
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <result.h>
+
+#include "bench.h"
+
+ERROR_DEFINE(BenchFailure, OtherErrorExitCode, "The benchmark failed on purpose.")
+
+__attribute__((noinline))
+static Result(int) produce(int value)
+{
+    if (value < 0) return result_ERR(int, BenchFailure);
+
+    return result_OK(int, value);
+}
+
+int main(void)
+{
+    long iterations = bench_iterations(20000000);
+
+    BENCH_RUN("produce ok, check the error by hand", iterations, {
+        Result(int) result = produce((int) i & 1023);
+        if (result.error != NULL) abort();
+        BENCH_KEEP(result.value);
+    });
+
+    BENCH_RUN("produce ok, is_ok", iterations, {
+        Result(int) result = produce((int) i & 1023);
+        if (!is_ok(result)) abort();
+        BENCH_KEEP(result.value);
+    });
+
+    BENCH_RUN("produce ok, unwrap", iterations, {
+        BENCH_KEEP(unwrap(int, produce((int) i & 1023)));
+    });
+
+    BENCH_RUN("produce ok, expect", iterations, {
+        BENCH_KEEP(expect(int, produce((int) i & 1023), "a number"));
+    });
+
+    BENCH_RUN("produce error, unwrap_or", iterations, {
+        BENCH_KEEP(unwrap_or(int, produce(-1), 0));
+    });
+
+    return 0;
+}
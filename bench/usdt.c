@@ -0,0 +1,72 @@
+/*
+    USDT.C - Cost of the USDT probes while no tracer is attached
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+    Build it once with -Dusdt=enabled and once without, and compare. With
+    the probes compiled in and no tracer attached, creating an error adds a
+    load of the semaphore and a not taken branch, the rest is unchanged.
+*/
+
+#include <result.h>
+#include <catch.h>
+
+#include "bench.h"
+
+ERROR_DEFINE(BenchFailure, OtherErrorExitCode, "The benchmark failed on purpose.")
+
+#ifdef RESULT_USDT
+#define PROBES " (usdt on, untraced)"
+#else
+#define PROBES " (usdt off)"
+#endif
+
+__attribute__((noinline))
+static Result(int) produce(int value)
+{
+    if (value < 0) return result_ERR(int, BenchFailure);
+
+    return result_OK(int, value);
+}
+
+static Result(void) unwrap_error(void* context)
+{
+    (void) context;
+
+    unwrap(int, produce(-1));
+    return result_OK();
+}
+
+int main(void)
+{
+    long iterations = bench_iterations(20000000);
+
+    BENCH_RUN("create an ok result" PROBES, iterations, {
+        BENCH_KEEP(produce((int) i & 1023).value);
+    });
+
+    BENCH_RUN("create an error" PROBES, iterations, {
+        BENCH_KEEP(produce(-1).error);
+    });
+
+    /* The failed unwrap probe sits on the panic path, behind a boundary */
+    BENCH_RUN("catch a failed unwrap" PROBES, iterations / 100, {
+        BENCH_KEEP(result_catch_panic(&unwrap_error, NULL).error);
+    });
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+/*
+    VALIDATE.C - Throughput of the text validators
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <ports/text/validate.h>
+
+#include <string.h>
+
+#include "bench.h"
+
+/* Large enough to be measured in bytes per nanosecond, small enough for L2 */
+#define TEXT_SIZE (64 * 1024)
+
+static char ascii[TEXT_SIZE];
+static char mixed[TEXT_SIZE];
+
+static void prepare(void)
+{
+    /* Latin, Cyrillic, CJK and emoji, between runs of ASCII */
+    static const char* const words[] = {
+        "result ", "za\xC5\xBC\xC3\xB3\xC5\x82\xC4\x87 ",
+        "\xD0\xBF\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82 ",
+        "\xE6\x96\x87\xE5\xAD\x97 ", "\xF0\x9F\x98\x80 ", "error handling ",
+    };
+    uint64_t state = 0x9E3779B97F4A7C15u;
+    size_t length = 0;
+
+    for (size_t i = 0; i < TEXT_SIZE; i++)
+        ascii[i] = (char) ('a' + i % 26);
+
+    while (length < TEXT_SIZE) {
+        state = state * 6364136223846793005u + 1442695040888963407u;
+        const char* word = words[(state >> 33) % (sizeof(words) /
+                                                  sizeof(*words))];
+        size_t size = strlen(word);
+
+        if (length + size > TEXT_SIZE) size = TEXT_SIZE - length;
+        memset(mixed + length, ' ', size);
+        if (size == strlen(word)) memcpy(mixed + length, word, size);
+        length += size;
+    }
+}
+
+int main(void)
+{
+    long iterations = bench_iterations(20000);
+
+    prepare();
+
+    BENCH_RUN("text_validate_utf8 64 KiB ascii", iterations, {
+        Result(size_t) valid = text_validate_utf8(ascii, TEXT_SIZE);
+        BENCH_KEEP(valid.value);
+        BENCH_KEEP(valid.error);
+    });
+
+    BENCH_RUN("text_validate_utf8 64 KiB mixed", iterations, {
+        Result(size_t) valid = text_validate_utf8(mixed, TEXT_SIZE);
+        BENCH_KEEP(valid.value);
+        BENCH_KEEP(valid.error);
+    });
+
+    BENCH_RUN("text_validate_ascii 64 KiB", iterations, {
+        Result(size_t) valid = text_validate_ascii(ascii, TEXT_SIZE);
+        BENCH_KEEP(valid.value);
+        BENCH_KEEP(valid.error);
+    });
+
+    BENCH_RUN("text_validate_no_nul 64 KiB", iterations, {
+        Result(size_t) valid = text_validate_no_nul(ascii, TEXT_SIZE);
+        BENCH_KEEP(valid.value);
+        BENCH_KEEP(valid.error);
+    });
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+/*
+    BACKTRACE.H - Raw backtraces of errors and panics
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__BACKTRACE___
+#define ___RESULT__BACKTRACE___
+
+#include <stdio.h>
+
+#include "result.h"
+
+#ifdef RESULT_BACKTRACE
+
+/* Return addresses kept per backtrace, the outer frames are cut off */
+#define RESULT_BACKTRACE_DEPTH 32
+
+typedef struct {
+    unsigned int    count;
+    void*           frames[RESULT_BACKTRACE_DEPTH];
+} ResultBacktrace;
+
+/*
+    Only the return addresses are captured, nothing is symbolized in the
+    process. They are printed with the module they belong to, the offset in
+    it and its build-id, result-symbolize turns them into functions and
+    lines later, on any machine with the same binaries.
+*/
+unsigned int result_backtrace_capture(ResultBacktrace* backtrace,
+                                      unsigned int skip);
+
+void result_backtrace_print(FILE* file, const ResultBacktrace* backtrace);
+
+/*
+    Captures the backtrace of every error created, until stopped. Every
+    thread keeps the backtrace of its last error, a panic prints it with its
+    own one.
+*/
+void result_backtrace_start(void);
+
+void result_backtrace_stop(void);
+
+/* The backtrace of the last error created by the thread, NULL without one */
+const ResultBacktrace* result_backtrace_last_error(const Error** error);
+
+void ___result_backtrace_error(const Error* error);
+
+/* The error an unwrap or an expect is about to panic on, for the next panic */
+void ___result_backtrace_panicking(const Error* error);
+
+void ___result_backtrace_panic(FILE* file);
+
+#endif
+
+#endif
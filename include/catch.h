@@ -0,0 +1,68 @@
+/*
+    CATCH.H - Recovering from panics at boundaries
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__CATCH___
+#define ___RESULT__CATCH___
+
+#include "result.h"
+
+ERROR_DECLARE(Panicked)
+
+/* Longer messages of caught panics are truncated */
+#define RESULT_PANIC_MESSAGE_SIZE 512
+
+/*
+    Calls call(context) behind a panic boundary. A panic inside the call jumps
+    back to the boundary, instead of exiting, and the boundary returns the
+    Panicked error, located where the panic happened. Otherwise the result of
+    the call is returned.
+
+    Panics of panicf and of the result methods are caught whatever the panic
+    function is, the panic function is only called outside of boundaries.
+    Calling panic_function directly bypasses them.
+
+    The jump skips the rest of the call, so whatever it held (locks, memory)
+    is not released. Boundaries nest, a panic returns from the innermost one.
+    Threads with no boundary keep exiting on panics.
+*/
+Result(void) result_catch_panic(Result(void) (*call)(void*), void* context);
+
+typedef struct {
+    int             exit_code;
+    const char*     message;
+} PanicInfo;
+
+/*
+    The last panic caught by the calling thread. The message stays in a
+    thread-local buffer, which the next caught panic overwrites.
+*/
+PanicInfo result_last_panic(void);
+
+typedef struct {
+    int             exit_code;
+    char            message[RESULT_PANIC_MESSAGE_SIZE];
+} PanicRecord;
+
+/*
+    Like result_catch_panic, and a caught panic is also copied to the record
+    (if not NULL), which belongs to the caller and outlives later panics.
+*/
+Result(void) result_catch_panic_record(Result(void) (*call)(void*),
+                                       void* context, PanicRecord* record);
+
+#endif
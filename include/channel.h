@@ -0,0 +1,408 @@
+/*
+    CHANNEL.H - Bounded queues of results between threads
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__CHANNEL___
+#define ___RESULT__CHANNEL___
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "result.h"
+#include "wait.h"
+
+ERROR_DECLARE(ChannelClosed)
+
+#define Channel(type) ___CHANNEL_## type
+
+/*
+    A ring of cells with sequence numbers (Vyukov's bounded MPMC queue).
+    Producers and consumers claim a cell with a CAS on the tail or the head,
+    and publish it through the sequence of the cell, so neither side locks.
+    Closing sets the top bit of the tail, so no push can claim a cell after
+    the channel was closed.
+
+    Blocked threads wait on the not_empty and not_full counters, and the
+    other side only bumps them, with a system call, when someone waits.
+*/
+#define ___CHANNEL_CLOSED ((size_t) 1 << (sizeof(size_t) * 8 - 1))
+
+typedef struct {
+    _Alignas(64) _Atomic size_t tail;
+    _Alignas(64) _Atomic size_t head;
+    _Alignas(64) _Atomic uint32_t not_empty;
+    _Atomic uint32_t waiting_consumers;
+    _Alignas(64) _Atomic uint32_t not_full;
+    _Atomic uint32_t waiting_producers;
+    size_t mask;
+} ___RESULT_CHANNEL;
+
+Result(void) ___result_channel_init(int src_line, char* src_file,
+                                    const char* src_function,
+                                    ___RESULT_CHANNEL* core, void** cells,
+                                    size_t cell_size, size_t capacity);
+
+void ___result_channel_destroy(___RESULT_CHANNEL* core, void** cells);
+
+void ___result_channel_close(___RESULT_CHANNEL* core);
+
+/*
+    Bumps the counter and wakes all of the waiters on it, if there are any.
+    Taking the waiters resets them, so the next notifies don't make system
+    calls until someone blocks again. A waiter that didn't sleep in the end
+    leaves a stale count, that costs one spurious wake.
+*/
+static inline void ___result_channel_notify(_Atomic uint32_t* counter,
+                                            _Atomic uint32_t* waiting)
+{
+    /* Orders the published cells before the check of the waiters */
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if (___RESULT_UNLIKELY(atomic_load_explicit(waiting,
+                                                memory_order_relaxed) != 0
+                           && atomic_exchange_explicit(waiting, 0,
+                                                       memory_order_relaxed))) {
+        atomic_fetch_add_explicit(counter, 1, memory_order_release);
+        ___result_wake(counter);
+    }
+}
+
+/* Registers as a waiter, so a notify after this point is not missed */
+#define ___CHANNEL_WAIT(counter, waiting, seen)                                 \
+    seen = atomic_load_explicit(counter, memory_order_acquire);                 \
+    atomic_fetch_add_explicit(waiting, 1, memory_order_seq_cst);                \
+
+#define ___CHANNEL_OK()                                                         \
+    (Result(void)) {                                                            \
+        .error = NULL,                                                          \
+        .src_file = src_file,                                                   \
+        .src_line = src_line,                                                   \
+        .src_function = src_function,                                           \
+    }                                                                           \
+
+#define ___CHANNEL_ERR(error)                                                   \
+    ___RESULT_void_declare(ERR(error), src_line, src_file, src_function)        \
+
+/* The cores of the operations, nothing is notified here */
+enum {
+    ___CHANNEL_DONE,
+    ___CHANNEL_AGAIN,
+    ___CHANNEL_SHUT,
+};
+
+#define CHANNEL_DECLARE(type)                                                   \
+    typedef struct {                                                            \
+        _Atomic size_t      sequence;                                           \
+        Result(type)        item;                                               \
+    } ___CHANNEL_## type ##_CELL;                                               \
+                                                                                \
+    typedef struct {                                                            \
+        ___RESULT_CHANNEL           core;                                       \
+        ___CHANNEL_## type ##_CELL* cells;                                      \
+    } Channel(type);                                                            \
+                                                                                \
+    static inline int ___CHANNEL_## type ##_push_one(Channel(type)* self,       \
+                                                     Result(type) item)         \
+    {                                                                           \
+        ___RESULT_CHANNEL* core = &self->core;                                  \
+        size_t position = atomic_load_explicit(&core->tail,                     \
+                                               memory_order_relaxed);           \
+                                                                                \
+        for (;;) {                                                              \
+            if (___RESULT_UNLIKELY(position & ___CHANNEL_CLOSED))               \
+                return ___CHANNEL_SHUT;                                         \
+                                                                                \
+            ___CHANNEL_## type ##_CELL* cell =                                  \
+                &self->cells[position & core->mask];                            \
+            size_t sequence = atomic_load_explicit(&cell->sequence,             \
+                                                   memory_order_acquire);       \
+            intptr_t difference = (intptr_t) sequence - (intptr_t) position;    \
+                                                                                \
+            if (difference == 0) {                                              \
+                if (atomic_compare_exchange_weak_explicit(                      \
+                        &core->tail, &position, position + 1,                   \
+                        memory_order_relaxed, memory_order_relaxed)) {          \
+                    cell->item = item;                                          \
+                    atomic_store_explicit(&cell->sequence, position + 1,        \
+                                          memory_order_release);                \
+                    return ___CHANNEL_DONE;                                     \
+                }                                                               \
+            } else if (difference < 0) {                                        \
+                return ___CHANNEL_AGAIN;                                        \
+            } else {                                                            \
+                position = atomic_load_explicit(&core->tail,                    \
+                                                memory_order_relaxed);          \
+            }                                                                   \
+        }                                                                       \
+    }                                                                           \
+                                                                                \
+    static inline int ___CHANNEL_## type ##_pop_one(Channel(type)* self,        \
+                                                    Result(type)* item)         \
+    {                                                                           \
+        ___RESULT_CHANNEL* core = &self->core;                                  \
+        size_t position = atomic_load_explicit(&core->head,                     \
+                                               memory_order_relaxed);           \
+                                                                                \
+        for (;;) {                                                              \
+            ___CHANNEL_## type ##_CELL* cell =                                  \
+                &self->cells[position & core->mask];                            \
+            size_t sequence = atomic_load_explicit(&cell->sequence,             \
+                                                   memory_order_acquire);       \
+            intptr_t difference = (intptr_t) sequence                           \
+                                  - (intptr_t) (position + 1);                  \
+                                                                                \
+            if (difference == 0) {                                              \
+                if (atomic_compare_exchange_weak_explicit(                      \
+                        &core->head, &position, position + 1,                   \
+                        memory_order_relaxed, memory_order_relaxed)) {          \
+                    *item = cell->item;                                         \
+                    atomic_store_explicit(&cell->sequence,                      \
+                                          position + core->mask + 1,            \
+                                          memory_order_release);                \
+                    return ___CHANNEL_DONE;                                     \
+                }                                                               \
+            } else if (difference < 0) {                                        \
+                /* Empty, and closed once every claimed cell was taken */       \
+                size_t tail = atomic_load_explicit(&core->tail,                 \
+                                                   memory_order_acquire);       \
+                                                                                \
+                if ((tail & ___CHANNEL_CLOSED)                                  \
+                    && (tail & ~___CHANNEL_CLOSED) == position)                 \
+                    return ___CHANNEL_SHUT;                                     \
+                                                                                \
+                return ___CHANNEL_AGAIN;                                        \
+            } else {                                                            \
+                position = atomic_load_explicit(&core->head,                    \
+                                                memory_order_relaxed);          \
+            }                                                                   \
+        }                                                                       \
+    }                                                                           \
+                                                                                \
+    static inline Result(void) ___CHANNEL_## type ##_init(                      \
+        int src_line, char* src_file, const char* src_function,                 \
+        Channel(type)* self, size_t capacity)                                   \
+    {                                                                           \
+        return ___result_channel_init(src_line, src_file, src_function,         \
+                                      &self->core, (void**) &self->cells,       \
+                                      sizeof(___CHANNEL_## type ##_CELL),       \
+                                      capacity);                                \
+    }                                                                           \
+                                                                                \
+    static inline void ___CHANNEL_## type ##_destroy(Channel(type)* self)       \
+    {                                                                           \
+        ___result_channel_destroy(&self->core, (void**) &self->cells);          \
+    }                                                                           \
+                                                                                \
+    static inline Result(size_t) ___CHANNEL_## type ##_push_batch(              \
+        int src_line, char* src_file, const char* src_function,                 \
+        Channel(type)* self, const Result(type)* items, size_t count,           \
+        uint64_t timeout_ns)                                                    \
+    {                                                                           \
+        ___RESULT_CHANNEL* core = &self->core;                                  \
+        uint64_t deadline = 0;                                                  \
+        bool started = false;                                                   \
+        size_t pushed = 0;                                                      \
+        const Error* error = NULL;                                              \
+                                                                                \
+        while (pushed < count) {                                                \
+            int state = ___CHANNEL_## type ##_push_one(self, items[pushed]);    \
+                                                                                \
+            if (___RESULT_LIKELY(state == ___CHANNEL_DONE)) {                   \
+                pushed++;                                                       \
+                continue;                                                       \
+            }                                                                   \
+                                                                                \
+            if (state == ___CHANNEL_SHUT) {                                     \
+                error = ERR(ChannelClosed);                                     \
+                break;                                                          \
+            }                                                                   \
+                                                                                \
+            if (timeout_ns == 0) {                                              \
+                error = ERR(ResourceUnavailable);                               \
+                break;                                                          \
+            }                                                                   \
+                                                                                \
+            /* Let the consumers at what was pushed before blocking */          \
+            if (pushed != 0)                                                    \
+                ___result_channel_notify(&core->not_empty,                      \
+                                         &core->waiting_consumers);             \
+                                                                                \
+            if (!started) {                                                     \
+                deadline = ___result_deadline(timeout_ns);                      \
+                started = true;                                                 \
+            }                                                                   \
+                                                                                \
+            uint32_t seen;                                                      \
+            ___CHANNEL_WAIT(&core->not_full, &core->waiting_producers, seen)    \
+            state = ___CHANNEL_## type ##_push_one(self, items[pushed]);        \
+                                                                                \
+            if (state == ___CHANNEL_AGAIN                                       \
+                && !___result_wait(&core->not_full, seen, deadline)             \
+                && (state = ___CHANNEL_## type ##_push_one(                     \
+                        self, items[pushed])) == ___CHANNEL_AGAIN) {            \
+                error = ERR(TimerExpired);                                      \
+                break;                                                          \
+            }                                                                   \
+                                                                                \
+            if (state == ___CHANNEL_DONE) pushed++;                             \
+        }                                                                       \
+                                                                                \
+        if (pushed != 0)                                                        \
+            ___result_channel_notify(&core->not_empty,                          \
+                                     &core->waiting_consumers);                 \
+                                                                                \
+        return ___RESULT_size_t_declare(error, src_line, src_file,              \
+                                        src_function, pushed);                  \
+    }                                                                           \
+                                                                                \
+    static inline Result(size_t) ___CHANNEL_## type ##_pop_batch(               \
+        int src_line, char* src_file, const char* src_function,                 \
+        Channel(type)* self, Result(type)* items, size_t count,                 \
+        uint64_t timeout_ns)                                                    \
+    {                                                                           \
+        ___RESULT_CHANNEL* core = &self->core;                                  \
+        uint64_t deadline = 0;                                                  \
+        bool started = false;                                                   \
+        size_t popped = 0;                                                      \
+        const Error* error = NULL;                                              \
+                                                                                \
+        while (popped < count) {                                                \
+            int state = ___CHANNEL_## type ##_pop_one(self, &items[popped]);    \
+                                                                                \
+            if (___RESULT_LIKELY(state == ___CHANNEL_DONE)) {                   \
+                popped++;                                                       \
+                continue;                                                       \
+            }                                                                   \
+                                                                                \
+            /* A batch takes what is there, and blocks only for the first */    \
+            if (popped != 0) break;                                             \
+                                                                                \
+            if (state == ___CHANNEL_SHUT) {                                     \
+                error = ERR(ChannelClosed);                                     \
+                break;                                                          \
+            }                                                                   \
+                                                                                \
+            if (timeout_ns == 0) {                                              \
+                error = ERR(ResourceUnavailable);                               \
+                break;                                                          \
+            }                                                                   \
+                                                                                \
+            if (!started) {                                                     \
+                deadline = ___result_deadline(timeout_ns);                      \
+                started = true;                                                 \
+            }                                                                   \
+                                                                                \
+            uint32_t seen;                                                      \
+            ___CHANNEL_WAIT(&core->not_empty, &core->waiting_consumers, seen)   \
+            state = ___CHANNEL_## type ##_pop_one(self, &items[popped]);        \
+                                                                                \
+            if (state == ___CHANNEL_AGAIN                                       \
+                && !___result_wait(&core->not_empty, seen, deadline)            \
+                && (state = ___CHANNEL_## type ##_pop_one(                      \
+                        self, &items[popped])) == ___CHANNEL_AGAIN) {           \
+                error = ERR(TimerExpired);                                      \
+                break;                                                          \
+            }                                                                   \
+                                                                                \
+            if (state == ___CHANNEL_DONE) popped++;                             \
+        }                                                                       \
+                                                                                \
+        if (popped != 0)                                                        \
+            ___result_channel_notify(&core->not_full,                           \
+                                     &core->waiting_producers);                 \
+                                                                                \
+        return ___RESULT_size_t_declare(error, src_line, src_file,              \
+                                        src_function, popped);                  \
+    }                                                                           \
+                                                                                \
+    static inline Result(void) ___CHANNEL_## type ##_push(                      \
+        int src_line, char* src_file, const char* src_function,                 \
+        Channel(type)* self, Result(type) item, uint64_t timeout_ns)            \
+    {                                                                           \
+        Result(size_t) pushed = ___CHANNEL_## type ##_push_batch(               \
+            src_line, src_file, src_function, self, &item, 1, timeout_ns);      \
+                                                                                \
+        if (___RESULT_UNLIKELY(pushed.error != NULL))                           \
+            return ___RESULT_void_declare(pushed.error, src_line, src_file,     \
+                                          src_function);                        \
+                                                                                \
+        return ___CHANNEL_OK();                                                 \
+    }                                                                           \
+                                                                                \
+    static inline Result(void) ___CHANNEL_## type ##_pop(                       \
+        int src_line, char* src_file, const char* src_function,                 \
+        Channel(type)* self, Result(type)* item, uint64_t timeout_ns)           \
+    {                                                                           \
+        Result(size_t) popped = ___CHANNEL_## type ##_pop_batch(                \
+            src_line, src_file, src_function, self, item, 1, timeout_ns);       \
+                                                                                \
+        if (___RESULT_UNLIKELY(popped.error != NULL))                           \
+            return ___RESULT_void_declare(popped.error, src_line, src_file,     \
+                                          src_function);                        \
+                                                                                \
+        return ___CHANNEL_OK();                                                 \
+    }                                                                           \
+
+/* The capacity is rounded up to a power of two, fails with NotEnoughMemory */
+#define channel_init(type, channel, capacity)                                   \
+    ___CHANNEL_## type ##_init(__LINE__, __FILE__, __func__, channel, capacity)
+
+/* No thread may use the channel anymore */
+#define channel_destroy(type, channel) ___CHANNEL_## type ##_destroy(channel)
+
+/*
+    Pushes fail with ChannelClosed after the channel was closed. Pops return
+    the items pushed before, and then fail with ChannelClosed.
+*/
+#define channel_close(type, channel) ___result_channel_close(&(channel)->core)
+
+/*
+    The item is a result, errors travel through the channel like values. The
+    timeout is in nanoseconds, RESULT_WAIT_FOREVER blocks without a limit and
+    0 doesn't block. Full (or empty) channels fail with TimerExpired after the
+    timeout, and with ResourceUnavailable when not blocking.
+*/
+#define channel_push(type, channel, item, timeout_ns)                           \
+    ___CHANNEL_## type ##_push(__LINE__, __FILE__, __func__, channel, item,     \
+                               timeout_ns)                                      \
+
+#define channel_pop(type, channel, item, timeout_ns)                            \
+    ___CHANNEL_## type ##_pop(__LINE__, __FILE__, __func__, channel, item,      \
+                              timeout_ns)                                       \
+
+#define channel_try_push(type, channel, item)                                   \
+    channel_push(type, channel, item, 0)
+
+#define channel_try_pop(type, channel, item)                                    \
+    channel_pop(type, channel, item, 0)
+
+/*
+    Batches wake the other side once. The value is the number of items moved,
+    on an error too. A push batch blocks until all of the items are in, a pop
+    batch blocks only until the first item, and takes up to count of them.
+*/
+#define channel_push_batch(type, channel, items, count, timeout_ns)             \
+    ___CHANNEL_## type ##_push_batch(__LINE__, __FILE__, __func__, channel,     \
+                                     items, count, timeout_ns)                  \
+
+#define channel_pop_batch(type, channel, items, count, timeout_ns)              \
+    ___CHANNEL_## type ##_pop_batch(__LINE__, __FILE__, __func__, channel,      \
+                                    items, count, timeout_ns)                   \
+
+#endif
@@ -0,0 +1,284 @@
+/*
+    CHECKED.H - Integer arithmetic and conversions checked for overflow
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__CHECKED___
+#define ___RESULT__CHECKED___
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "result.h"
+
+ERROR_DECLARE(IntegerOverflow)
+
+/* The checks are built on the overflow builtins of GCC and Clang */
+#if defined(__GNUC__)
+
+/*
+    The functions are inline, so the happy path is the arithmetic and a single
+    branch. Only overflows go through the out of line declare (and the hooks).
+*/
+#define ___RESULT_CHECKED_OK(type, result_value)                                \
+    (Result(type)) {                                                            \
+        .value = (result_value),                                                \
+        .error = NULL,                                                          \
+        .src_file = src_file,                                                   \
+        .src_line = src_line,                                                   \
+        .src_function = src_function,                                           \
+    }                                                                           \
+
+#define ___RESULT_CHECKED_ERR(type, result_value)                               \
+    ___RESULT_## type ##_declare(ERR(IntegerOverflow), src_line, src_file,      \
+                                 src_function, result_value)                    \
+
+#define ___RESULT_CHECKED_OP(type, op)                                          \
+    static inline Result(type) ___RESULT_## type ##_checked_## op(              \
+        int src_line, char* src_file, const char* src_function, type a, type b) \
+    {                                                                           \
+        type value;                                                             \
+                                                                                \
+        if (___RESULT_UNLIKELY(__builtin_## op ##_overflow(a, b, &value)))      \
+            return ___RESULT_CHECKED_ERR(type, value);                          \
+                                                                                \
+        return ___RESULT_CHECKED_OK(type, value);                               \
+    }                                                                           \
+
+/*
+    The array versions work on blocks. The overflows of a whole block are ORed
+    together without branches, so the loops can be vectorized, and only a block
+    with an overflow is scanned again for the first failing index.
+
+    Additions and subtractions wrap in the width of the type, an overflow sets
+    the sign bit of the accumulator. Vector multiplications checked through 64
+    bits were not faster than the builtin, so products use the builtin.
+*/
+#define ___RESULT_CHECKED_BLOCK 256
+
+#define ___RESULT_CHECKED_SIGNED(type) ((type) -1 < (type) 1)
+
+/* All bits set, so the sign bit is set for the unsigned types too */
+#define ___RESULT_CHECKED_FLAG(type, condition) ((type) -(type) (condition))
+
+#define ___RESULT_CHECKED_OVERFLOWED(type, overflow)                            \
+    (((overflow) >> (sizeof(type) * CHAR_BIT - 1)) & 1)
+
+#define ___RESULT_checked_add_step(type, a, b, r, overflow)                     \
+    r = (type) ((uint64_t) (a) + (uint64_t) (b));                               \
+    overflow |= ___RESULT_CHECKED_SIGNED(type)                                  \
+                ? (type) (((a) ^ r) & ((b) ^ r))                                \
+                : ___RESULT_CHECKED_FLAG(type, r < (a));                        \
+
+#define ___RESULT_checked_sub_step(type, a, b, r, overflow)                     \
+    r = (type) ((uint64_t) (a) - (uint64_t) (b));                               \
+    overflow |= ___RESULT_CHECKED_SIGNED(type)                                  \
+                ? (type) (((a) ^ (b)) & ((a) ^ r))                              \
+                : ___RESULT_CHECKED_FLAG(type, (a) < (b));                      \
+
+#define ___RESULT_checked_mul_step(type, a, b, r, overflow)                     \
+    overflow |= ___RESULT_CHECKED_FLAG(type, __builtin_mul_overflow(a, b, &r)); \
+
+#define ___RESULT_CHECKED_ARRAY(type, op)                                       \
+    __attribute__((always_inline))                                              \
+    static inline bool ___RESULT_## type ##_checked_## op ##_block(             \
+        type* block, const type* a, const type* b, size_t size)                 \
+    {                                                                           \
+        type overflow = 0;                                                      \
+                                                                                \
+        for (size_t i = 0; i < size; i++) {                                     \
+            type r;                                                             \
+                                                                                \
+            ___RESULT_checked_## op ##_step(type, a[i], b[i], r, overflow)      \
+            block[i] = r;                                                       \
+        }                                                                       \
+                                                                                \
+        return ___RESULT_CHECKED_OVERFLOWED(type, overflow);                    \
+    }                                                                           \
+                                                                                \
+    static inline Result(size_t) ___RESULT_## type ##_checked_## op ##_array(   \
+        int src_line, char* src_file, const char* src_function, type* out,      \
+        const type* a, const type* b, size_t count)                             \
+    {                                                                           \
+        type block[___RESULT_CHECKED_BLOCK];                                    \
+                                                                                \
+        for (size_t start = 0; start < count;) {                                \
+            size_t size = count - start;                                        \
+            bool overflow;                                                      \
+                                                                                \
+            if (size >= ___RESULT_CHECKED_BLOCK) {                              \
+                size = ___RESULT_CHECKED_BLOCK;                                 \
+                overflow = ___RESULT_## type ##_checked_## op ##_block(         \
+                    block, a + start, b + start, ___RESULT_CHECKED_BLOCK);      \
+            } else {                                                            \
+                overflow = ___RESULT_## type ##_checked_## op ##_block(         \
+                    block, a + start, b + start, size);                         \
+            }                                                                   \
+                                                                                \
+            if (___RESULT_UNLIKELY(overflow)) {                                 \
+                size_t i = 0;                                                   \
+                type scratch;                                                   \
+                                                                                \
+                while (!___RESULT_## type ##_checked_## op ##_block(            \
+                           &scratch, a + start + i, b + start + i, 1))          \
+                    i++;                                                        \
+                                                                                \
+                memcpy(out + start, block, i * sizeof(type));                   \
+                return ___RESULT_CHECKED_ERR(size_t, start + i);                \
+            }                                                                   \
+                                                                                \
+            /* out can be one of the inputs, so it's written last */            \
+            memcpy(out + start, block, size * sizeof(type));                    \
+            start += size;                                                      \
+        }                                                                       \
+                                                                                \
+        return ___RESULT_CHECKED_OK(size_t, count);                             \
+    }                                                                           \
+
+/*
+    Defines the checked operations for an integer type, they are static inline
+    so there is nothing to define in a source file.
+*/
+#define RESULT_CHECKED_DECLARE(type)                                            \
+    ___RESULT_CHECKED_OP(type, add)                                             \
+    ___RESULT_CHECKED_OP(type, sub)                                             \
+    ___RESULT_CHECKED_OP(type, mul)                                             \
+                                                                                \
+    static inline Result(type) ___RESULT_## type ##_checked_shl(                \
+        int src_line, char* src_file, const char* src_function, type a,         \
+        unsigned int shift)                                                     \
+    {                                                                           \
+        type value = 0;                                                         \
+        bool overflow = shift >= sizeof(type) * CHAR_BIT                        \
+                        ? a != 0                                                \
+                        : __builtin_mul_overflow(a, (uintmax_t) 1 << shift,     \
+                                                 &value);                       \
+                                                                                \
+        if (___RESULT_UNLIKELY(overflow))                                       \
+            return ___RESULT_CHECKED_ERR(type, value);                          \
+                                                                                \
+        return ___RESULT_CHECKED_OK(type, value);                               \
+    }                                                                           \
+                                                                                \
+    static inline Result(type) ___RESULT_## type ##_checked_cast(               \
+        int src_line, char* src_file, const char* src_function, intmax_t from)  \
+    {                                                                           \
+        type value;                                                             \
+                                                                                \
+        if (___RESULT_UNLIKELY(__builtin_add_overflow(from, 0, &value)))        \
+            return ___RESULT_CHECKED_ERR(type, value);                          \
+                                                                                \
+        return ___RESULT_CHECKED_OK(type, value);                               \
+    }                                                                           \
+                                                                                \
+    static inline Result(type) ___RESULT_## type ##_checked_ucast(              \
+        int src_line, char* src_file, const char* src_function, uintmax_t from) \
+    {                                                                           \
+        type value;                                                             \
+                                                                                \
+        if (___RESULT_UNLIKELY(__builtin_add_overflow(from, 0, &value)))        \
+            return ___RESULT_CHECKED_ERR(type, value);                          \
+                                                                                \
+        return ___RESULT_CHECKED_OK(type, value);                               \
+    }                                                                           \
+                                                                                \
+    ___RESULT_CHECKED_ARRAY(type, add)                                          \
+    ___RESULT_CHECKED_ARRAY(type, sub)                                          \
+    ___RESULT_CHECKED_ARRAY(type, mul)                                          \
+
+#define result_checked_add(type, a, b)                                          \
+    ___RESULT_## type ##_checked_add(__LINE__, __FILE__, __func__, a, b)
+
+#define result_checked_sub(type, a, b)                                          \
+    ___RESULT_## type ##_checked_sub(__LINE__, __FILE__, __func__, a, b)
+
+#define result_checked_mul(type, a, b)                                          \
+    ___RESULT_## type ##_checked_mul(__LINE__, __FILE__, __func__, a, b)
+
+#define result_checked_shl(type, a, shift)                                      \
+    ___RESULT_## type ##_checked_shl(__LINE__, __FILE__, __func__, a, shift)
+
+/* Unsigned values are widened to uintmax_t, so the large ones stay positive */
+#define result_checked_cast(type, from)                                         \
+    _Generic((from),                                                            \
+        unsigned char: ___RESULT_## type ##_checked_ucast,                      \
+        unsigned short: ___RESULT_## type ##_checked_ucast,                     \
+        unsigned int: ___RESULT_## type ##_checked_ucast,                       \
+        unsigned long: ___RESULT_## type ##_checked_ucast,                      \
+        unsigned long long: ___RESULT_## type ##_checked_ucast,                 \
+        default: ___RESULT_## type ##_checked_cast                              \
+    )(__LINE__, __FILE__, __func__, from)
+
+#define result_checked_add_array(type, out, a, b, count)                        \
+    ___RESULT_## type ##_checked_add_array(__LINE__, __FILE__, __func__,        \
+                                           out, a, b, count)
+
+#define result_checked_sub_array(type, out, a, b, count)                        \
+    ___RESULT_## type ##_checked_sub_array(__LINE__, __FILE__, __func__,        \
+                                           out, a, b, count)
+
+#define result_checked_mul_array(type, out, a, b, count)                        \
+    ___RESULT_## type ##_checked_mul_array(__LINE__, __FILE__, __func__,        \
+                                           out, a, b, count)
+
+RESULT_CHECKED_DECLARE(char)
+RESULT_CHECKED_DECLARE(int8_t)
+RESULT_CHECKED_DECLARE(int16_t)
+RESULT_CHECKED_DECLARE(int32_t)
+RESULT_CHECKED_DECLARE(int64_t)
+RESULT_CHECKED_DECLARE(int_fast8_t)
+RESULT_CHECKED_DECLARE(int_fast16_t)
+RESULT_CHECKED_DECLARE(int_fast32_t)
+RESULT_CHECKED_DECLARE(int_fast64_t)
+RESULT_CHECKED_DECLARE(int_least8_t)
+RESULT_CHECKED_DECLARE(int_least16_t)
+RESULT_CHECKED_DECLARE(int_least32_t)
+RESULT_CHECKED_DECLARE(int_least64_t)
+RESULT_CHECKED_DECLARE(intmax_t)
+RESULT_CHECKED_DECLARE(intptr_t)
+RESULT_CHECKED_DECLARE(uint8_t)
+RESULT_CHECKED_DECLARE(uint16_t)
+RESULT_CHECKED_DECLARE(uint32_t)
+RESULT_CHECKED_DECLARE(uint64_t)
+RESULT_CHECKED_DECLARE(uint_fast8_t)
+RESULT_CHECKED_DECLARE(uint_fast16_t)
+RESULT_CHECKED_DECLARE(uint_fast32_t)
+RESULT_CHECKED_DECLARE(uint_fast64_t)
+RESULT_CHECKED_DECLARE(uint_least8_t)
+RESULT_CHECKED_DECLARE(uint_least16_t)
+RESULT_CHECKED_DECLARE(uint_least32_t)
+RESULT_CHECKED_DECLARE(uint_least64_t)
+RESULT_CHECKED_DECLARE(uintmax_t)
+RESULT_CHECKED_DECLARE(uintptr_t)
+RESULT_CHECKED_DECLARE(int)
+RESULT_CHECKED_DECLARE(short)
+RESULT_CHECKED_DECLARE(size_t)
+RESULT_CHECKED_DECLARE(ptrdiff_t)
+RESULT_CHECKED_DECLARE(long)
+RESULT_CHECKED_DECLARE(long_long)
+RESULT_CHECKED_DECLARE(unsigned_char)
+RESULT_CHECKED_DECLARE(unsigned_short)
+RESULT_CHECKED_DECLARE(unsigned_int)
+RESULT_CHECKED_DECLARE(unsigned_long)
+RESULT_CHECKED_DECLARE(unsigned_long_long)
+RESULT_CHECKED_DECLARE(wchar_t)
+
+#endif
+
+#endif
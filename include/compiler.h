@@ -0,0 +1,71 @@
+/*
+    COMPILER.H - Compiler specific hints used by the library
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__COMPILER___
+#define ___RESULT__COMPILER___
+
+#include "config.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+
+#define ___RESULT_LIKELY(x)     __builtin_expect(!!(x), 1)
+#define ___RESULT_UNLIKELY(x)   __builtin_expect(!!(x), 0)
+#define ___RESULT_COLD          __attribute__((cold, noinline))
+#define ___RESULT_NORETURN      __attribute__((noreturn))
+
+#elif defined(_MSC_VER)
+
+#define ___RESULT_LIKELY(x)     (x)
+#define ___RESULT_UNLIKELY(x)   (x)
+#define ___RESULT_COLD          __declspec(noinline)
+#define ___RESULT_NORETURN      __declspec(noreturn)
+
+#else
+
+#define ___RESULT_LIKELY(x)     (x)
+#define ___RESULT_UNLIKELY(x)   (x)
+#define ___RESULT_COLD
+#define ___RESULT_NORETURN
+
+#endif
+
+/* Racy reads of flags, that are only ever set as a whole */
+#if defined(__GNUC__) || defined(__clang__)
+#define ___RESULT_LOAD_RELAXED(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#else
+#define ___RESULT_LOAD_RELAXED(x) (x)
+#endif
+
+/* Hint for the cpu, that the thread is busy waiting */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ___RESULT_CPU_RELAX() __builtin_ia32_pause()
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+#define ___RESULT_CPU_RELAX() __asm__ __volatile__("yield")
+#else
+#define ___RESULT_CPU_RELAX() ((void) 0)
+#endif
+
+/* Panic paths can only be marked as non-returning, when the library was built
+   with the panic_noreturn option (panics always exit the program). */
+#ifdef RESULT_PANIC_NORETURN
+#define ___RESULT_PANIC_NORETURN ___RESULT_NORETURN
+#else
+#define ___RESULT_PANIC_NORETURN
+#endif
+
+#endif
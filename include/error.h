@@ -19,22 +19,92 @@
 #ifndef ___RESULT__ERROR___
 #define ___RESULT__ERROR___
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define ___RESULT_USE(x) 
 
+/*
+    The layout is the one of the first releases, kinds sits in what used to
+    be the tail padding. In a shared library every message pointer is a load
+    time relocation, the library is linked with packed relative relocations
+    where the linker has them, which store them in a few bitmap words.
+*/
 typedef struct {
-    char* message;
+    const char* message;
     int exit_code;
+    unsigned int kinds;
 } Error;
 
 #define ERR(id) &___ERROR_##_##id
 
 #define ERROR_DECLARE(id) extern const Error ___ERROR_##_##id;
 
-#define ERROR_DEFINE(id, _exit_code, _message)                                  \
+/*
+    Error kinds form a hierarchy of categories. Every kind owns a single bit,
+    and its mask holds its own bit, and the bits of all of its parents. An error
+    carries the masks of its kinds, so checking if it belongs to a kind (or to
+    any of its children) is a single AND.
+
+    Bits 0-15 are reserved by the library, bits 16-30 are free for your kinds.
+*/
+#define ERROR_KIND(id) ___ERROR_KIND_##id
+
+#define ERROR_KIND_DEFINE(id, bit, parents)                                     \
+    enum {                                                                      \
+        ___ERROR_KIND_BIT_##id = 1 << (bit),                                    \
+        ___ERROR_KIND_##id = (1 << (bit)) | (parents)                           \
+    };
+
+#define error_is_kind(error, kind)                                              \
+    (((error)->kinds & ___ERROR_KIND_BIT_##kind) != 0)
+
+/* The operation can be repeated */
+ERROR_KIND_DEFINE(Retryable,                0,  0)
+/* The error is caused by a temporary condition, repeat after a while */
+ERROR_KIND_DEFINE(Transient,                1,  ERROR_KIND(Retryable))
+
+#define FileOperationFailedExitCode -1
+#define InvalidRequestExitCode -2
+#define PermissionErrorExitCode -3
+#define MemoryRelatedErrorExitCode -4
+#define MathRelatedErrorExitCode -5
+#define NetworkConectionErrorExitCode -6
+#define OtherErrorExitCode -7
+
+/* Kinds of the exit code groups, errors join them by their exit code */
+ERROR_KIND_DEFINE(FileOperationFailed,      2,  0)
+ERROR_KIND_DEFINE(InvalidRequest,           3,  0)
+ERROR_KIND_DEFINE(PermissionError,          4,  0)
+ERROR_KIND_DEFINE(MemoryRelatedError,       5,  0)
+ERROR_KIND_DEFINE(MathRelatedError,         6,  0)
+ERROR_KIND_DEFINE(NetworkConnectionError,   7,  0)
+ERROR_KIND_DEFINE(OtherError,               8,  0)
+
+#define ___ERROR_EXIT_CODE_KIND(code)                                           \
+    ((code) == FileOperationFailedExitCode ? ERROR_KIND(FileOperationFailed) :  \
+     (code) == InvalidRequestExitCode ? ERROR_KIND(InvalidRequest) :            \
+     (code) == PermissionErrorExitCode ? ERROR_KIND(PermissionError) :          \
+     (code) == MemoryRelatedErrorExitCode ? ERROR_KIND(MemoryRelatedError) :    \
+     (code) == MathRelatedErrorExitCode ? ERROR_KIND(MathRelatedError) :        \
+     (code) == NetworkConectionErrorExitCode ?                                  \
+        ERROR_KIND(NetworkConnectionError) :                                    \
+     (code) == OtherErrorExitCode ? ERROR_KIND(OtherError) : 0)
+
+#define ERROR_DEFINE_WITH_KIND(id, kind, _exit_code, _message)                  \
     const Error ___ERROR_##_##id = {                                            \
         .message = _message,                                                    \
-        .exit_code = _exit_code                                                 \
+        .exit_code = _exit_code,                                                \
+        .kinds = (kind) | ___ERROR_EXIT_CODE_KIND(_exit_code)                   \
     };                                                                          \
     ___RESULT_USE(___ERROR_##_##id)
 
+#define ERROR_DEFINE(id, _exit_code, _message)                                  \
+    ERROR_DEFINE_WITH_KIND(id, 0, _exit_code, _message)
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
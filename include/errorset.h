@@ -0,0 +1,193 @@
+/*
+    ERRORSET.H - Collecting many errors without allocations
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__ERRORSET___
+#define ___RESULT__ERRORSET___
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "result.h"
+
+ERROR_DECLARE(MultipleErrors)
+
+typedef struct {
+    const Error*    error;
+    size_t          index;
+    char*           src_file;
+    int             src_line;
+    const char*     src_function;
+} ErrorSetEntry;
+
+/*
+    The set keeps up to capacity entries, the errors after them are only
+    counted. The capacity is a field, not a compile time size, so every
+    translation unit sees the same layout. Sets are meant to be filled by one
+    thread, and folded into a single result.
+*/
+typedef struct {
+    size_t          count;
+    size_t          overflow;
+    size_t          capacity;
+    ErrorSetEntry*  entries;
+} ErrorSet;
+
+typedef ErrorSet* ErrorSet_ptr;
+RESULT_DECLARE(ErrorSet_ptr)
+
+/*
+    A set with size (a constant) entries in a compound literal, that lives as
+    long as the enclosing block, so a set on the stack needs no allocation.
+*/
+#define ERROR_SET_INIT(size)                                                    \
+    {                                                                           \
+        .count = 0,                                                             \
+        .overflow = 0,                                                          \
+        .capacity = (size),                                                     \
+        .entries = (ErrorSetEntry[size]) { { 0 } },                             \
+    }                                                                           \
+
+/* A set over entries the caller owns */
+static inline void error_set_init(ErrorSet* set, ErrorSetEntry* entries,
+                                  size_t capacity)
+{
+    set->count = 0;
+    set->overflow = 0;
+    set->capacity = capacity;
+    set->entries = entries;
+}
+
+static inline bool error_set_is_empty(const ErrorSet* set)
+{
+    return set->count == 0 && set->overflow == 0;
+}
+
+/* Every error seen, the dropped ones included */
+static inline size_t error_set_total(const ErrorSet* set)
+{
+    return set->count + set->overflow;
+}
+
+static inline void error_set_add(ErrorSet* set, size_t index,
+                                 const Error* error, char* src_file,
+                                 int src_line, const char* src_function)
+{
+    if (___RESULT_UNLIKELY(set->count == set->capacity)) {
+        set->overflow++;
+        return;
+    }
+
+    set->entries[set->count++] = (ErrorSetEntry) {
+        .error = error,
+        .index = index,
+        .src_file = src_file,
+        .src_line = src_line,
+        .src_function = src_function,
+    };
+}
+
+/*
+    The origin points at the error field of a result, all result types share
+    the layout of Result(void) from there on (like the panic paths).
+*/
+static inline bool ___error_set_collect(ErrorSet* set, size_t index,
+                                        const void* origin)
+{
+    Result(void) self;
+    memcpy(&self, origin, sizeof(self));
+
+    if (___RESULT_LIKELY(self.error == NULL)) return true;
+
+    error_set_add(set, index, self.error, self.src_file, self.src_line,
+                  self.src_function);
+    return false;
+}
+
+/* Adds the error of the result (evaluated once), false when there was one */
+#define error_set_collect(type, set, index, result)                             \
+    ___error_set_collect(set, index, &((Result(type)[1]) { result })[0].error)
+
+static inline void error_set_merge(ErrorSet* set, const ErrorSet* other)
+{
+    for (size_t i = 0; i < other->count; i++)
+        error_set_add(set, other->entries[i].index, other->entries[i].error,
+                      other->entries[i].src_file, other->entries[i].src_line,
+                      other->entries[i].src_function);
+
+    set->overflow += other->overflow;
+}
+
+/*
+    Folds the set into one result, with the set as the value. An empty set
+    is ok, a single error is returned as it is, with its location, and more
+    of them are MultipleErrors, with the set holding the details. So is a
+    single error the set had no room for, there is no location to return.
+*/
+static inline Result(ErrorSet_ptr) ___error_set_result(int src_line,
+                                                       char* src_file,
+                                                       const char* src_function,
+                                                       ErrorSet* set)
+{
+    if (___RESULT_LIKELY(error_set_is_empty(set)))
+        return (Result(ErrorSet_ptr)) {
+            .value = set,
+            .error = NULL,
+            .src_file = src_file,
+            .src_line = src_line,
+            .src_function = src_function,
+        };
+
+    if (set->count == 1 && set->overflow == 0)
+        return ___RESULT_ErrorSet_ptr_declare(set->entries[0].error,
+                                              set->entries[0].src_line,
+                                              set->entries[0].src_file,
+                                              set->entries[0].src_function,
+                                              set);
+
+    return ___RESULT_ErrorSet_ptr_declare(ERR(MultipleErrors), src_line,
+                                          src_file, src_function, set);
+}
+
+#define error_set_result(set)                                                   \
+    ___error_set_result(__LINE__, __FILE__, __func__, set)
+
+static inline Result(ErrorSet_ptr) ___error_set_fold(int src_line,
+                                                     char* src_file,
+                                                     const char* src_function,
+                                                     ErrorSet* set,
+                                                     const char* results,
+                                                     size_t count, size_t size,
+                                                     size_t offset)
+{
+    for (size_t i = 0; i < count; i++)
+        ___error_set_collect(set, i, results + i * size + offset);
+
+    return ___error_set_result(src_line, src_file, src_function, set);
+}
+
+/*
+    Collects the errors of an array of results, with their indexes, and
+    folds the set like error_set_result.
+*/
+#define result_all(type, set, results, count)                                   \
+    ___error_set_fold(__LINE__, __FILE__, __func__, set,                        \
+                      (const char*) (results), count, sizeof(Result(type)),     \
+                      offsetof(Result(type), error))                            \
+
+#endif
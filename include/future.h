@@ -0,0 +1,169 @@
+/*
+    FUTURE.H - Handing results between threads
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__FUTURE___
+#define ___RESULT__FUTURE___
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "result.h"
+#include "wait.h"
+
+ERROR_DECLARE(PromiseAlreadySet)
+
+#define Future(type) ___FUTURE_## type
+#define Promise(type) ___PROMISE_## type
+
+/*
+    The whole handoff is a single state word. The promise claims it, writes
+    the result and publishes it with a release, a consumer that finds it ready
+    reads the result with a single acquire load. Only a consumer that has to
+    block sets the waiters bit, and only then the promise makes a system call.
+*/
+#define ___FUTURE_CLAIMED   (1u << 0)
+#define ___FUTURE_READY     (1u << 1)
+#define ___FUTURE_WAITERS   (1u << 2)
+
+#define FUTURE_INIT { .state = 0 }
+
+#define FUTURE_DECLARE(type)                                                    \
+    typedef struct {                                                            \
+        _Atomic uint32_t    state;                                              \
+        Result(type)        result;                                             \
+    } Future(type);                                                             \
+                                                                                \
+    typedef struct {                                                            \
+        Future(type)*       future;                                             \
+    } Promise(type);                                                            \
+                                                                                \
+    static inline void ___FUTURE_## type ##_init(Future(type)* self)            \
+    {                                                                           \
+        atomic_init(&self->state, 0);                                           \
+    }                                                                           \
+                                                                                \
+    static inline Promise(type) ___FUTURE_## type ##_promise(                   \
+        Future(type)* self)                                                     \
+    {                                                                           \
+        return (Promise(type)) { .future = self };                              \
+    }                                                                           \
+                                                                                \
+    static inline Result(void) ___PROMISE_## type ##_set(                       \
+        int src_line, char* src_file, const char* src_function,                 \
+        Promise(type) self, Result(type) result)                                \
+    {                                                                           \
+        Future(type)* future = self.future;                                     \
+        uint32_t state = atomic_fetch_or_explicit(&future->state,               \
+                                                  ___FUTURE_CLAIMED,            \
+                                                  memory_order_relaxed);        \
+                                                                                \
+        if (___RESULT_UNLIKELY(state & ___FUTURE_CLAIMED))                      \
+            return ___RESULT_void_declare(ERR(PromiseAlreadySet), src_line,     \
+                                          src_file, src_function);              \
+                                                                                \
+        future->result = result;                                                \
+        state = atomic_fetch_or_explicit(&future->state, ___FUTURE_READY,       \
+                                         memory_order_acq_rel);                 \
+                                                                                \
+        if (___RESULT_UNLIKELY(state & ___FUTURE_WAITERS))                      \
+            ___result_wake(&future->state);                                     \
+                                                                                \
+        return (Result(void)) {                                                 \
+            .error = NULL,                                                      \
+            .src_file = src_file,                                               \
+            .src_line = src_line,                                               \
+            .src_function = src_function,                                       \
+        };                                                                      \
+    }                                                                           \
+                                                                                \
+    static inline bool ___FUTURE_## type ##_is_ready(Future(type)* self)        \
+    {                                                                           \
+        return atomic_load_explicit(&self->state, memory_order_acquire)         \
+               & ___FUTURE_READY;                                               \
+    }                                                                           \
+                                                                                \
+    static inline Result(type) ___FUTURE_## type ##_poll(                       \
+        int src_line, char* src_file, const char* src_function,                 \
+        Future(type)* self)                                                     \
+    {                                                                           \
+        if (___RESULT_LIKELY(___FUTURE_## type ##_is_ready(self)))              \
+            return self->result;                                                \
+                                                                                \
+        return ___RESULT_## type ##_declare(ERR(ResourceUnavailable), src_line, \
+                                            src_file, src_function,             \
+                                            (type) { 0 });                      \
+    }                                                                           \
+                                                                                \
+    static inline Result(type) ___FUTURE_## type ##_wait(                       \
+        int src_line, char* src_file, const char* src_function,                 \
+        Future(type)* self, uint64_t timeout_ns)                                \
+    {                                                                           \
+        uint64_t deadline = 0;                                                  \
+        bool started = false;                                                   \
+                                                                                \
+        for (;;) {                                                              \
+            uint32_t state = atomic_load_explicit(&self->state,                 \
+                                                  memory_order_acquire);        \
+                                                                                \
+            if (___RESULT_LIKELY(state & ___FUTURE_READY))                      \
+                return self->result;                                            \
+                                                                                \
+            if (!started) {                                                     \
+                deadline = ___result_deadline(timeout_ns);                      \
+                started = true;                                                 \
+            }                                                                   \
+                                                                                \
+            if (!(state & ___FUTURE_WAITERS)                                    \
+                && !atomic_compare_exchange_weak_explicit(                      \
+                       &self->state, &state, state | ___FUTURE_WAITERS,         \
+                       memory_order_relaxed, memory_order_relaxed))             \
+                continue;                                                       \
+                                                                                \
+            if (!___result_wait(&self->state, state | ___FUTURE_WAITERS,        \
+                                deadline)                                       \
+                && !___FUTURE_## type ##_is_ready(self))                        \
+                return ___RESULT_## type ##_declare(ERR(TimerExpired),          \
+                                                    src_line, src_file,         \
+                                                    src_function,               \
+                                                    (type) { 0 });              \
+        }                                                                       \
+    }                                                                           \
+
+#define future_init(type, future) ___FUTURE_## type ##_init(future)
+
+#define future_promise(type, future) ___FUTURE_## type ##_promise(future)
+
+/* Sets the result once, later calls fail with PromiseAlreadySet */
+#define promise_set(type, promise, result)                                      \
+    ___PROMISE_## type ##_set(__LINE__, __FILE__, __func__, promise, result)
+
+#define future_is_ready(type, future) ___FUTURE_## type ##_is_ready(future)
+
+/* The result when it's ready, ResourceUnavailable with a zero value otherwise */
+#define future_poll(type, future)                                               \
+    ___FUTURE_## type ##_poll(__LINE__, __FILE__, __func__, future)
+
+/*
+    Blocks until the result is ready, at most timeout_ns (or
+    RESULT_WAIT_FOREVER), then fails with TimerExpired and a zero value.
+*/
+#define future_wait(type, future, timeout_ns)                                   \
+    ___FUTURE_## type ##_wait(__LINE__, __FILE__, __func__, future, timeout_ns)
+
+#endif
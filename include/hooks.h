@@ -0,0 +1,86 @@
+/*
+    HOOKS.H - Observing errors as they are created
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__HOOKS___
+#define ___RESULT__HOOKS___
+
+#include "config.h"
+#include "compiler.h"
+#include "error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(RESULT_TRACING) || defined(RESULT_SHARED_STATS)                    \
+    || defined(RESULT_USDT) || defined(RESULT_BACKTRACE)
+#define RESULT_ERROR_HOOKS
+#endif
+
+/*
+    Every error result passes through ___RESULT_ERROR_HOOK when it's created.
+    Without any of the observing build options it compiles to nothing,
+    otherwise it costs a single test of ___result_hooks (or'ed with the
+    semaphore of the error probe), until one of them is turned on at runtime
+    or a tracer attaches.
+*/
+#ifdef RESULT_ERROR_HOOKS
+
+#define ___RESULT_HOOK_TRACE        (1u << 0)
+#define ___RESULT_HOOK_STATS        (1u << 1)
+#define ___RESULT_HOOK_BACKTRACE    (1u << 2)
+
+extern unsigned int ___result_hooks;
+
+___RESULT_COLD
+void ___result_error_created(const Error* error, int src_line,
+                             const char* src_file, const char* src_function);
+
+#ifdef RESULT_USDT
+
+/* Set while a tracer is attached to the error probe */
+extern unsigned short result_error_semaphore;
+
+#define ___RESULT_HOOKS_ACTIVE()                                                \
+    ((___RESULT_LOAD_RELAXED(___result_hooks)                                   \
+      | ___RESULT_LOAD_RELAXED(result_error_semaphore)) != 0)
+
+#else
+
+#define ___RESULT_HOOKS_ACTIVE() (___RESULT_LOAD_RELAXED(___result_hooks) != 0)
+
+#endif
+
+#define ___RESULT_ERROR_HOOK(error, src_line, src_file, src_function)          \
+    do {                                                                        \
+        if (___RESULT_UNLIKELY((error) != NULL && ___RESULT_HOOKS_ACTIVE()))    \
+            ___result_error_created(error, src_line, src_file, src_function);   \
+    } while (0)
+
+#else
+
+#define ___RESULT_ERROR_HOOK(error, src_line, src_file, src_function)          \
+    ((void) 0)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
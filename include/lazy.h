@@ -0,0 +1,189 @@
+/*
+    LAZY.H - Results computed once, on first use
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__LAZY___
+#define ___RESULT__LAZY___
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "result.h"
+#include "catch.h"
+#include "panic.h"
+#include "retry.h"
+#include "wait.h"
+
+#define Lazy(type) ___LAZY_## type
+
+/*
+    The first caller claims the cell and runs the initializer, the ones that
+    come meanwhile sleep on the state word, and everyone after that reads the
+    result with a single acquire load. The result is kept whether it's ok or
+    not, unless there is a retry policy: the initializer is then repeated like
+    result_retry, and a Retryable error left after that isn't kept, so the
+    next caller starts over.
+
+    The initializer runs behind a panic boundary. A panic releases the cell,
+    so the next caller starts over too, and then goes on to the boundary of
+    the caller (or the panic function) with the same code and message.
+*/
+#define ___LAZY_RUNNING     (1u << 0)
+#define ___LAZY_READY       (1u << 1)
+#define ___LAZY_WAITERS     (1u << 2)
+
+#define LAZY_INIT(_call, _context, _policy)                                     \
+    { .state = 0, .call = (_call), .context = (_context), .policy = (_policy) }
+
+#define LAZY_DECLARE(type)                                                      \
+    typedef struct {                                                            \
+        _Atomic uint32_t    state;                                              \
+        Result(type)        (*call)(void*);                                     \
+        void*               context;                                            \
+        const RetryPolicy*  policy;                                             \
+        Result(type)        result;                                             \
+    } Lazy(type);                                                               \
+                                                                                \
+    typedef struct {                                                            \
+        Lazy(type)*         self;                                               \
+        Result(type)        result;                                             \
+    } ___LAZY_## type ##_CALL;                                                  \
+                                                                                \
+    static inline Result(void) ___LAZY_## type ##_call(void* context)           \
+    {                                                                           \
+        ___LAZY_## type ##_CALL* call = context;                                \
+        Lazy(type)* self = call->self;                                          \
+                                                                                \
+        call->result = self->policy == NULL                                     \
+            ? (*self->call)(self->context)                                      \
+            : ___RESULT_## type ##_retry(self->policy, NULL, self->call,        \
+                                         self->context);                        \
+                                                                                \
+        return result_OK();                                                     \
+    }                                                                           \
+                                                                                \
+    static inline void ___LAZY_## type ##_init(Lazy(type)* self,                \
+                                               Result(type) (*call)(void*),     \
+                                               void* context,                   \
+                                               const RetryPolicy* policy)       \
+    {                                                                           \
+        atomic_init(&self->state, 0);                                           \
+        self->call = call;                                                      \
+        self->context = context;                                                \
+        self->policy = policy;                                                  \
+    }                                                                           \
+                                                                                \
+    static inline bool ___LAZY_## type ##_is_ready(Lazy(type)* self)            \
+    {                                                                           \
+        return atomic_load_explicit(&self->state, memory_order_acquire)         \
+               & ___LAZY_READY;                                                 \
+    }                                                                           \
+                                                                                \
+    static inline Result(type) ___LAZY_## type ##_force(Lazy(type)* self)       \
+    {                                                                           \
+        for (;;) {                                                              \
+            uint32_t state = atomic_load_explicit(&self->state,                 \
+                                                  memory_order_acquire);        \
+                                                                                \
+            if (state & ___LAZY_READY) return self->result;                     \
+                                                                                \
+            if (!(state & ___LAZY_RUNNING)) {                                   \
+                if (!atomic_compare_exchange_weak_explicit(                     \
+                        &self->state, &state, state | ___LAZY_RUNNING,          \
+                        memory_order_acquire, memory_order_relaxed))            \
+                    continue;                                                   \
+                                                                                \
+                ___LAZY_## type ##_CALL call = { .self = self };                \
+                PanicRecord panic;                                              \
+                Result(void) called = result_catch_panic_record(                \
+                    &___LAZY_## type ##_call, &call, &panic);                   \
+                                                                                \
+                if (___RESULT_UNLIKELY(called.error != NULL)) {                 \
+                    state = atomic_exchange_explicit(&self->state, 0,           \
+                                                     memory_order_acq_rel);     \
+                    if (state & ___LAZY_WAITERS) ___result_wake(&self->state);  \
+                                                                                \
+                    ___result_panic(panic_function, called.src_line,            \
+                                    called.src_file, called.src_function,       \
+                                    panic.exit_code, "%s", panic.message);      \
+                    return ___RESULT_## type ##_declare(                        \
+                        called.error, called.src_line, called.src_file,         \
+                        called.src_function, (type) { 0 });                     \
+                }                                                               \
+                                                                                \
+                Result(type) result = call.result;                              \
+                bool keep = self->policy == NULL                                \
+                            || !result_is_kind(result, Retryable);              \
+                                                                                \
+                if (keep) self->result = result;                                \
+                state = atomic_exchange_explicit(&self->state,                  \
+                                                 keep ? ___LAZY_READY : 0,      \
+                                                 memory_order_acq_rel);         \
+                                                                                \
+                if (state & ___LAZY_WAITERS) ___result_wake(&self->state);      \
+                                                                                \
+                return result;                                                  \
+            }                                                                   \
+                                                                                \
+            if (!(state & ___LAZY_WAITERS)                                      \
+                && !atomic_compare_exchange_weak_explicit(                      \
+                       &self->state, &state, state | ___LAZY_WAITERS,           \
+                       memory_order_relaxed, memory_order_relaxed))             \
+                continue;                                                       \
+                                                                                \
+            ___result_wait(&self->state, state | ___LAZY_WAITERS,               \
+                           RESULT_WAIT_FOREVER);                                \
+        }                                                                       \
+    }                                                                           \
+                                                                                \
+    static inline Result(type) ___LAZY_## type ##_get(Lazy(type)* self)         \
+    {                                                                           \
+        if (___RESULT_LIKELY(___LAZY_## type ##_is_ready(self)))                \
+            return self->result;                                                \
+                                                                                \
+        return ___LAZY_## type ##_force(self);                                  \
+    }                                                                           \
+
+#define lazy_init(type, lazy, call, context, policy)                            \
+    ___LAZY_## type ##_init(lazy, call, context, policy)
+
+#define lazy_is_ready(type, lazy) ___LAZY_## type ##_is_ready(lazy)
+
+/* The result, computed by the first caller, with the location it came from */
+#define lazy_get(type, lazy) ___LAZY_## type ##_get(lazy)
+
+/* The result methods, applied to the result of the cell */
+#define lazy_unwrap(type, lazy) result_unwrap(type, lazy_get(type, lazy))
+
+#define lazy_unwrap_or(type, lazy, fallback)                                    \
+    result_unwrap_or(type, lazy_get(type, lazy), fallback)
+
+#define lazy_expect(type, lazy, error)                                          \
+    result_expect(type, lazy_get(type, lazy), error)
+
+#define lazy_is_ok(type, lazy) result_is_ok(lazy_get(type, lazy))
+
+#define lazy_is_err(type, lazy) result_is_err(lazy_get(type, lazy))
+
+#define lazy_and_then(type, lazy, call)                                         \
+    result_and_then(type, lazy_get(type, lazy), call)
+
+#define lazy_or_else(type, lazy, call)                                          \
+    result_or_else(type, lazy_get(type, lazy), call)
+
+#endif
@@ -0,0 +1,65 @@
+/*
+    LOG.H - Asynchronous binary logging of errors
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__LOG___
+#define ___RESULT__LOG___
+
+#include <stdint.h>
+
+#include "result.h"
+
+/* Records kept per thread until the writer drains them, the rest are dropped */
+#define RESULT_LOG_RING_SIZE 4096
+
+/* Raw arguments stored with a record, the ones after them are ignored */
+#define RESULT_LOG_MAX_ARGS 3
+
+/*
+    Starts the writer thread, that drains the rings of all threads to the
+    file every millisecond. The file is binary, result-log-decode turns it
+    into text or JSON.
+*/
+Result(void) result_log_start(const char* path);
+
+/*
+    Waits for the records other threads are writing, writes the remaining
+    records, and closes the file.
+*/
+Result(void) result_log_stop(void);
+
+/*
+    Logs the error of the result (evaluated once), located where it was
+    created, with up to RESULT_LOG_MAX_ARGS integer arguments. Ok results
+    are skipped, and so is everything while the logger is stopped. The
+    caller only copies a record to its own ring, so it never blocks on I/O,
+    records that don't fit in a full ring are dropped and counted.
+*/
+#define result_log(type, result, ...)                                           \
+    ___result_log_origin(&((Result(type)[1]) { result })[0].error,              \
+                         (const uint64_t[]) { 0, __VA_ARGS__ },                 \
+                         sizeof((uint64_t[]) { 0, __VA_ARGS__ })                \
+                         / sizeof(uint64_t) - 1)                                \
+
+/* Logs an error without a location, fits inspect_err */
+void result_log_error(const Error* error);
+
+/* The arguments start after a placeholder, that keeps the array non-empty */
+void ___result_log_origin(const void* origin, const uint64_t* arguments,
+                          unsigned int count);
+
+#endif
@@ -0,0 +1,125 @@
+/*
+    MEMO.H - Caching the results of fallible functions
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__MEMO___
+#define ___RESULT__MEMO___
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "result.h"
+#include "slice.h"
+
+#define Memo(type) ___MEMO_## type
+
+/* A time to live that never runs out */
+#define MEMO_FOREVER UINT64_MAX
+
+typedef struct {
+    uint64_t    hits;
+    uint64_t    error_hits;         /* hits of cached errors, part of hits */
+    uint64_t    misses;
+    uint64_t    expired;            /* misses on entries that ran out */
+    uint64_t    evictions;
+    size_t      entries;
+} MemoStats;
+
+typedef struct ___RESULT_MEMO_SHARD ___RESULT_MEMO_SHARD;
+
+/*
+    Keys are hashed to a shard, every shard has its own reader-writer lock,
+    a fixed share of the capacity, and a CLOCK hand that picks the entry to evict
+    once they are all taken. Lookups only take the read lock, they mark the
+    entry as referenced with a relaxed store, so readers never block readers.
+    Keys are copied, results are stored as they are, with their location.
+*/
+typedef struct {
+    ___RESULT_MEMO_SHARD*   shards;
+    size_t                  shard_mask;
+    size_t                  result_size;
+    uint64_t                ok_ttl_ns;
+    uint64_t                error_ttl_ns;
+} ___RESULT_MEMO;
+
+Result(void) ___result_memo_init(int src_line, char* src_file,
+                                 const char* src_function, ___RESULT_MEMO* core,
+                                 size_t result_size, size_t capacity,
+                                 uint64_t ok_ttl_ns, uint64_t error_ttl_ns);
+
+void ___result_memo_destroy(___RESULT_MEMO* core);
+
+bool ___result_memo_lookup(___RESULT_MEMO* core, str_slice key, void* result);
+
+void ___result_memo_store(___RESULT_MEMO* core, str_slice key,
+                          const void* result, const Error* error);
+
+void ___result_memo_invalidate(___RESULT_MEMO* core, str_slice key);
+
+void ___result_memo_clear(___RESULT_MEMO* core);
+
+MemoStats ___result_memo_stats(___RESULT_MEMO* core);
+
+/*
+    Threads that miss the same key at the same time all call the function,
+    and the last result stored wins.
+*/
+#define MEMO_DECLARE(type)                                                      \
+    typedef struct {                                                            \
+        ___RESULT_MEMO      core;                                               \
+    } Memo(type);                                                               \
+                                                                                \
+    static inline Result(type) ___MEMO_## type ##_get(                          \
+        Memo(type)* self, str_slice key,                                        \
+        Result(type) (*call)(str_slice, void*), void* context)                  \
+    {                                                                           \
+        Result(type) result;                                                    \
+                                                                                \
+        if (___result_memo_lookup(&self->core, key, &result)) return result;    \
+                                                                                \
+        result = (*call)(key, context);                                         \
+        ___result_memo_store(&self->core, key, &result, result.error);          \
+                                                                                \
+        return result;                                                          \
+    }                                                                           \
+
+/*
+    Keeps up to capacity results, ok ones for ok_ttl_ns and errors for
+    error_ttl_ns (MEMO_FOREVER never expires, 0 doesn't cache them at all).
+    Transient errors are never cached. The capacity is split between up to
+    16 shards, never more than capacity, so the cache never holds more.
+*/
+#define memo_init(type, cache, capacity, ok_ttl_ns, error_ttl_ns)               \
+    ___result_memo_init(__LINE__, __FILE__, __func__, &(cache)->core,           \
+                        sizeof(Result(type)), capacity, ok_ttl_ns,              \
+                        error_ttl_ns)
+
+#define memo_destroy(cache) ___result_memo_destroy(&(cache)->core)
+
+/* The cached result of call(key, context), calls it on a miss */
+#define memo_get(type, cache, key, call, context)                               \
+    ___MEMO_## type ##_get(cache, key, call, context)
+
+#define memo_invalidate(cache, key)                                             \
+    ___result_memo_invalidate(&(cache)->core, key)
+
+#define memo_clear(cache) ___result_memo_clear(&(cache)->core)
+
+#define memo_stats(cache) ___result_memo_stats(&(cache)->core)
+
+#endif
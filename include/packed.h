@@ -0,0 +1,342 @@
+/*
+    PACKED.H - Results of small values packed in a single word
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__PACKED___
+#define ___RESULT__PACKED___
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "result.h"
+
+#define Packed(type) ___PACKED_## type
+
+/*
+    A packed result keeps a value of up to 4 bytes in the low half of a
+    single 64 bit word, and the id of its error in the high half, 0 when it's
+    ok. It's returned in a register, instead of the memory of a full result.
+
+    An id stands for both the error and the location it was created at, so
+    nothing is lost on the way there and back. Ids are handed out the first
+    time a location creates an error, and stay valid until the program exits.
+*/
+#define ___PACKED_ID_SHIFT 32
+
+uint32_t ___result_packed_intern(const Error* error, int src_line,
+                                 char* src_file, const char* src_function);
+
+___RESULT_COLD
+uint32_t ___result_packed_error(const Error* error, int src_line,
+                                char* src_file, const char* src_function);
+
+/* The origin shares the layout of Result(void) */
+const Result(void)* ___result_packed_origin(uint32_t id);
+
+static inline uint32_t ___result_packed_id(uint64_t bits)
+{
+    return (uint32_t) (bits >> ___PACKED_ID_SHIFT);
+}
+
+static inline const Error* ___result_packed_error_of(uint64_t bits)
+{
+    uint32_t id = ___result_packed_id(bits);
+
+    return id == 0 ? NULL : ___result_packed_origin(id)->error;
+}
+
+#define PACKED_DECLARE(type)                                                    \
+    typedef struct {                                                            \
+        uint64_t    bits;                                                       \
+    } Packed(type);                                                             \
+                                                                                \
+    _Static_assert(sizeof(type) <= sizeof(uint32_t),                            \
+                   "Packed(" #type ") needs a value of 4 bytes or less");       \
+                                                                                \
+    static inline Packed(type) ___PACKED_## type ##_ok(type value)              \
+    {                                                                           \
+        uint32_t bits = 0;                                                      \
+                                                                                \
+        memcpy(&bits, &value, sizeof(value));                                   \
+        return (Packed(type)) { bits };                                         \
+    }                                                                           \
+                                                                                \
+    static inline Packed(type) ___PACKED_## type ##_err(uint32_t id)            \
+    {                                                                           \
+        return (Packed(type)) { (uint64_t) id << ___PACKED_ID_SHIFT };          \
+    }                                                                           \
+                                                                                \
+    static inline type ___PACKED_## type ##_value(Packed(type) self)            \
+    {                                                                           \
+        uint32_t bits = (uint32_t) self.bits;                                   \
+        type value;                                                             \
+                                                                                \
+        memcpy(&value, &bits, sizeof(value));                                   \
+        return value;                                                           \
+    }                                                                           \
+                                                                                \
+    static inline Packed(type) ___PACKED_## type ##_from_result(                \
+        Result(type) result)                                                    \
+    {                                                                           \
+        if (result_is_ok(result))                                               \
+            return ___PACKED_## type ##_ok(result.value);                       \
+                                                                                \
+        return ___PACKED_## type ##_err(                                        \
+            ___result_packed_intern(result.error, result.src_line,              \
+                                    result.src_file, result.src_function));     \
+    }                                                                           \
+                                                                                \
+    static inline Result(type) ___PACKED_## type ##_to_result(                  \
+        int src_line, char* src_file, const char* src_function,                 \
+        Packed(type) self)                                                      \
+    {                                                                           \
+        uint32_t id = ___result_packed_id(self.bits);                           \
+                                                                                \
+        if (___RESULT_LIKELY(id == 0))                                          \
+            return (Result(type)) {                                             \
+                .value = ___PACKED_## type ##_value(self),                      \
+                .error = NULL,                                                  \
+                .src_file = src_file,                                           \
+                .src_line = src_line,                                           \
+                .src_function = src_function,                                   \
+            };                                                                  \
+                                                                                \
+        const Result(void)* origin = ___result_packed_origin(id);               \
+                                                                                \
+        return (Result(type)) {                                                 \
+            .value = ___PACKED_## type ##_value(self),                          \
+            .error = origin->error,                                             \
+            .src_file = origin->src_file,                                       \
+            .src_line = origin->src_line,                                       \
+            .src_function = origin->src_function,                               \
+        };                                                                      \
+    }                                                                           \
+                                                                                \
+    static inline type ___PACKED_## type ##_unwrap(int src_line,                \
+                                                   char* src_file,              \
+                                                   const char* src_function,    \
+                                                   Packed(type) self)           \
+    {                                                                           \
+        uint32_t id = ___result_packed_id(self.bits);                           \
+                                                                                \
+        if (___RESULT_UNLIKELY(id != 0))                                        \
+            ___RESULT_panic_unwrap(src_line, src_file, src_function,            \
+                                   ___result_packed_origin(id));                \
+                                                                                \
+        return ___PACKED_## type ##_value(self);                                \
+    }                                                                           \
+                                                                                \
+    static inline type ___PACKED_## type ##_expect(int src_line,                \
+                                                   char* src_file,              \
+                                                   const char* src_function,    \
+                                                   Packed(type) self,           \
+                                                   const char* error)           \
+    {                                                                           \
+        uint32_t id = ___result_packed_id(self.bits);                           \
+                                                                                \
+        if (___RESULT_UNLIKELY(id != 0))                                        \
+            ___RESULT_panic_expect(src_line, src_file, src_function,            \
+                                   ___result_packed_origin(id), error);         \
+                                                                                \
+        return ___PACKED_## type ##_value(self);                                \
+    }                                                                           \
+                                                                                \
+    static inline const Error* ___PACKED_## type ##_unwrap_err(                 \
+        int src_line, char* src_file, const char* src_function,                 \
+        Packed(type) self)                                                      \
+    {                                                                           \
+        if (___RESULT_UNLIKELY(___result_packed_id(self.bits) == 0))            \
+            ___RESULT_panic_unwrap_err(src_line, src_file, src_function);       \
+                                                                                \
+        return ___result_packed_error_of(self.bits);                            \
+    }                                                                           \
+                                                                                \
+    static inline const Error* ___PACKED_## type ##_expect_err(                 \
+        int src_line, char* src_file, const char* src_function,                 \
+        Packed(type) self, const char* error)                                   \
+    {                                                                           \
+        if (___RESULT_UNLIKELY(___result_packed_id(self.bits) == 0))            \
+            ___RESULT_panic_expect_err(src_line, src_file, src_function,        \
+                                       error);                                  \
+                                                                                \
+        return ___result_packed_error_of(self.bits);                            \
+    }                                                                           \
+                                                                                \
+    static inline type ___PACKED_## type ##_unwrap_or(Packed(type) self,        \
+                                                      type fallback)            \
+    {                                                                           \
+        if (___result_packed_id(self.bits) != 0) return fallback;               \
+                                                                                \
+        return ___PACKED_## type ##_value(self);                                \
+    }                                                                           \
+                                                                                \
+    static inline const Error* ___PACKED_## type ##_unwrap_err_or(              \
+        Packed(type) self, const Error* fallback)                               \
+    {                                                                           \
+        if (___result_packed_id(self.bits) == 0) return fallback;               \
+                                                                                \
+        return ___result_packed_error_of(self.bits);                            \
+    }                                                                           \
+                                                                                \
+    static inline Packed(type) ___PACKED_## type ##_and(Packed(type) self,      \
+                                                        Packed(type) other)     \
+    {                                                                           \
+        if (___result_packed_id(self.bits) == 0) return other;                  \
+                                                                                \
+        return self;                                                            \
+    }                                                                           \
+                                                                                \
+    static inline Packed(type) ___PACKED_## type ##_and_then(                   \
+        Packed(type) self, Packed(type) (*c)(type))                             \
+    {                                                                           \
+        if (___result_packed_id(self.bits) == 0)                                \
+            return (*c)(___PACKED_## type ##_value(self));                      \
+                                                                                \
+        return self;                                                            \
+    }                                                                           \
+                                                                                \
+    static inline Packed(type) ___PACKED_## type ##_or(Packed(type) self,       \
+                                                       Packed(type) other)      \
+    {                                                                           \
+        if (___result_packed_id(self.bits) != 0) return other;                  \
+                                                                                \
+        return self;                                                            \
+    }                                                                           \
+                                                                                \
+    static inline Packed(type) ___PACKED_## type ##_or_else(                    \
+        Packed(type) self, Packed(type) (*c)(const Error*))                     \
+    {                                                                           \
+        if (___result_packed_id(self.bits) != 0)                                \
+            return (*c)(___result_packed_error_of(self.bits));                  \
+                                                                                \
+        return self;                                                            \
+    }                                                                           \
+                                                                                \
+    static inline void ___PACKED_## type ##_inspect(Packed(type) self,          \
+                                                    void (*c)(type))            \
+    {                                                                           \
+        if (___result_packed_id(self.bits) == 0)                                \
+            (*c)(___PACKED_## type ##_value(self));                             \
+    }                                                                           \
+                                                                                \
+    static inline void ___PACKED_## type ##_inspect_err(                        \
+        Packed(type) self, void (*c)(const Error*))                             \
+    {                                                                           \
+        if (___result_packed_id(self.bits) != 0)                                \
+            (*c)(___result_packed_error_of(self.bits));                         \
+    }                                                                           \
+                                                                                \
+    static inline bool ___PACKED_## type ##_is_ok_and(Packed(type) self,        \
+                                                      bool (*c)(type))          \
+    {                                                                           \
+        return ___result_packed_id(self.bits) == 0                              \
+               && (*c)(___PACKED_## type ##_value(self));                       \
+    }                                                                           \
+                                                                                \
+    static inline bool ___PACKED_## type ##_is_err_and(                         \
+        Packed(type) self, bool (*c)(const Error*))                             \
+    {                                                                           \
+        return ___result_packed_id(self.bits) != 0                              \
+               && (*c)(___result_packed_error_of(self.bits));                   \
+    }                                                                           \
+
+#define packed_OK(type, value) ___PACKED_## type ##_ok(value)
+
+#define packed_ERR(type, error)                                                 \
+    ___PACKED_## type ##_err(                                                   \
+        ___result_packed_error(ERR(error), __LINE__, __FILE__, __func__))
+
+#define ___PACKED_ERR_RAW(type, error)                                          \
+    ___PACKED_## type ##_err(                                                   \
+        ___result_packed_error(error, __LINE__, __FILE__, __func__))
+
+#define packed_from_result(type, result) ___PACKED_## type ##_from_result(result)
+
+/* A full result of an ok packed one points at the conversion */
+#define packed_to_result(type, packed)                                          \
+    ___PACKED_## type ##_to_result(__LINE__, __FILE__, __func__, packed)
+
+#define packed_is_ok(self)                                                      \
+    ___RESULT_LIKELY(___result_packed_id((self).bits) == 0)
+
+#define packed_is_err(self)                                                     \
+    ___RESULT_UNLIKELY(___result_packed_id((self).bits) != 0)
+
+#define packed_error(self) ___result_packed_error_of((self).bits)
+
+#define packed_is_kind(self, kind)                                              \
+    (packed_is_err(self) && error_is_kind(packed_error(self), kind))
+
+/* The result methods, on packed results */
+#define packed_and(type, self, other) ___PACKED_## type ##_and(self, other)
+
+#define packed_and_then(type, self, call)                                       \
+    ___PACKED_## type ##_and_then(self, call)
+
+#define packed_expect(type, packed, error)                                      \
+    ___PACKED_## type ##_expect(__LINE__, __FILE__, __func__, packed, error)
+
+#define packed_expect_err(type, packed, error)                                  \
+    ___PACKED_## type ##_expect_err(__LINE__, __FILE__, __func__, packed, error)
+
+#define packed_inspect(type, packed, call)                                      \
+    ___PACKED_## type ##_inspect(packed, call)
+
+#define packed_inspect_err(type, packed, call)                                  \
+    ___PACKED_## type ##_inspect_err(packed, call)
+
+#define packed_is_err_and(type, self, call)                                     \
+    ___PACKED_## type ##_is_err_and(self, call)
+
+#define packed_is_ok_and(type, self, call)                                      \
+    ___PACKED_## type ##_is_ok_and(self, call)
+
+#define packed_unwrap(type, packed)                                             \
+    ___PACKED_## type ##_unwrap(__LINE__, __FILE__, __func__, packed)
+
+#define packed_unwrap_err(type, packed)                                         \
+    ___PACKED_## type ##_unwrap_err(__LINE__, __FILE__, __func__, packed)
+
+#define packed_unwrap_or(type, packed, fallback)                                \
+    ___PACKED_## type ##_unwrap_or(packed, fallback)
+
+#define packed_unwrap_err_or(type, packed, fallback)                            \
+    ___PACKED_## type ##_unwrap_err_or(packed, fallback)
+
+#define packed_or(type, self, other) ___PACKED_## type ##_or(self, other)
+
+#define packed_or_else(type, self, call)                                        \
+    ___PACKED_## type ##_or_else(self, call)
+
+PACKED_DECLARE(bool)
+
+/* bool is a macro, the declaration above was expanded to _Bool */
+typedef Packed(_Bool) ___PACKED_bool;
+
+PACKED_DECLARE(char)
+PACKED_DECLARE(short)
+PACKED_DECLARE(int)
+PACKED_DECLARE(int8_t)
+PACKED_DECLARE(int16_t)
+PACKED_DECLARE(int32_t)
+PACKED_DECLARE(uint8_t)
+PACKED_DECLARE(uint16_t)
+PACKED_DECLARE(uint32_t)
+PACKED_DECLARE(float)
+
+#endif
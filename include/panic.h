@@ -24,6 +24,10 @@
 #include <stdarg.h>
 #include <stdbool.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define RESULT_PANIC_FUNCTION_PARAMTETERS                                       \
     int src_line,                                                               \
     const char* src_file,                                                       \
@@ -43,10 +47,23 @@ typedef void (*PanicFunction)(RESULT_PANIC_FUNCTION_PARAMTETERS);
 
 void ___default_panic(RESULT_PANIC_FUNCTION_PARAMTETERS);
 
+void panic_set_panic_function(PanicFunction function);
+
+/*
+    Panics of panicf and of the result methods go through the boundaries of
+    catch.h first, and only reach the function outside of them.
+*/
+void ___result_panic(PanicFunction function, RESULT_PANIC_FUNCTION_PARAMTETERS);
+
 #define panicf(code, ...)                                                       \
-    panic_function(__LINE__, __FILE__, __func__, code, __VA_ARGS__)
+    ___result_panic(panic_function, __LINE__, __FILE__, __func__, code,         \
+                    __VA_ARGS__)
 
 extern PanicFunction panic_function;
 extern bool panic_exit_on_panic;
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -0,0 +1,125 @@
+/*
+    PARALLEL.H - Fallible maps over arrays on a thread pool
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__PARALLEL___
+#define ___RESULT__PARALLEL___
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "result.h"
+
+/* The pool never grows beyond this many threads, the caller included */
+#define RESULT_PAR_MAX_THREADS 256
+
+typedef struct {
+    size_t          index;
+    const Error*    error;
+    char*           src_file;
+    int             src_line;
+    const char*     src_function;
+} ___RESULT_PAR_FAILURE;
+
+/* Runs [begin, end), and describes the first failing element on a failure */
+typedef bool (*___RESULT_PAR_CHUNK)(void* context, size_t begin, size_t end,
+                                    ___RESULT_PAR_FAILURE* failure);
+
+Result(size_t) ___result_par_run(int src_line, char* src_file,
+                                 const char* src_function,
+                                 ___RESULT_PAR_CHUNK chunk, void* context,
+                                 size_t count);
+
+/*
+    Defines the map from type_in to type_out, for result_par_map. Like the
+    parsers the map is inline, over the out of line pool.
+*/
+#define RESULT_PAR_MAP_DECLARE(type_in, type_out)                               \
+    typedef struct {                                                            \
+        Result(type_out) (*function)(type_in);                                  \
+        const type_in* in;                                                      \
+        type_out* out;                                                          \
+    } ___RESULT_## type_in ##_## type_out ##_PAR_MAP;                           \
+                                                                                \
+    static inline bool ___RESULT_## type_in ##_## type_out ##_par_chunk(        \
+        void* context, size_t begin, size_t end,                                \
+        ___RESULT_PAR_FAILURE* failure)                                         \
+    {                                                                           \
+        ___RESULT_## type_in ##_## type_out ##_PAR_MAP* map = context;          \
+                                                                                \
+        for (size_t i = begin; i < end; i++) {                                  \
+            Result(type_out) result = map->function(map->in[i]);                \
+                                                                                \
+            if (___RESULT_UNLIKELY(result.error != NULL)) {                     \
+                *failure = (___RESULT_PAR_FAILURE) {                            \
+                    .index = i,                                                 \
+                    .error = result.error,                                      \
+                    .src_file = result.src_file,                                \
+                    .src_line = result.src_line,                                \
+                    .src_function = result.src_function,                        \
+                };                                                              \
+                return false;                                                   \
+            }                                                                   \
+                                                                                \
+            map->out[i] = result.value;                                         \
+        }                                                                       \
+                                                                                \
+        return true;                                                            \
+    }                                                                           \
+                                                                                \
+    static inline Result(size_t) ___RESULT_## type_in ##_## type_out ##_par_map(\
+        int src_line, char* src_file, const char* src_function,                 \
+        Result(type_out) (*function)(type_in), const type_in* in,               \
+        type_out* out, size_t count)                                            \
+    {                                                                           \
+        ___RESULT_## type_in ##_## type_out ##_PAR_MAP map = {                  \
+            .function = function,                                               \
+            .in = in,                                                           \
+            .out = out,                                                         \
+        };                                                                      \
+                                                                                \
+        return ___result_par_run(                                               \
+            src_line, src_file, src_function,                                   \
+            &___RESULT_## type_in ##_## type_out ##_par_chunk, &map, count);    \
+    }                                                                           \
+
+/*
+    Calls function on every element of in, and stores the values in out. The
+    result is count, or the error of the lowest failing index with the index
+    as the value, like a sequential loop would give. The elements after the
+    failing one may or may not have been stored.
+
+    The work is split into chunks over a pool of a thread per cpu, that is
+    started at the first call. Idle threads steal halves of the remaining
+    chunks of the busy ones, and chunks after a failed index are skipped.
+    Maps of several threads at once queue a job each and share the pool, the
+    calling thread always works on its own. Maps called from inside a map run
+    sequentially on the calling thread.
+
+    A panic of function fails the map at the first index of its chunk. Once
+    every thread left the map, the calling thread panics again with the same
+    code and message, so a boundary around the map catches it.
+*/
+#define result_par_map(type_in, type_out, function, in, out, count)             \
+    ___RESULT_## type_in ##_## type_out ##_par_map(__LINE__, __FILE__,          \
+                                                    __func__, function, in,     \
+                                                    out, count)                 \
+
+/* The threads of the pool, the calling thread included */
+unsigned int result_par_threads(void);
+
+#endif
@@ -25,13 +25,9 @@
 
 #include <error.h>
 
-#define FileOperationFailedExitCode -1
-#define InvalidRequestExitCode -2
-#define PermissionErrorExitCode -3
-#define MemoryRelatedErrorExitCode -4
-#define MathRelatedErrorExitCode -5
-#define NetworkConectionErrorExitCode -6
-#define OtherErrorExitCode -7
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 ERROR_DECLARE(PermissionNotPermitted)
 ERROR_DECLARE(FileDoesNotExist)
@@ -203,6 +199,10 @@ typedef struct {
 extern const int ___errno_binds_size;
 extern const ___ERRNO_BIND ___errno_binds[];
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* !RESULT_DISABLE_PORTS */
 
 #endif
@@ -0,0 +1,263 @@
+/*
+    PORTS/FUNCTIONS.H - Math functions reporting domain and range errors
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__LIBM_FUNCTIONS___
+#define ___RESULT__LIBM_FUNCTIONS___
+
+#ifndef RESULT_DISABLE_PORTS
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <result.h>
+
+/*
+    The functions detect errors with the floating-point exception flags, rather
+    than errno. A domain error (FE_INVALID) gives NumericalArgumentOutOfDomain,
+    a pole error or an overflow (FE_DIVBYZERO, FE_OVERFLOW) gives
+    NumericalArgumentOutOfRange. Underflows are not errors. The value of an
+    error result is the one returned by libm (NaN, or an infinity).
+
+    The array versions test the flags once per call. The mask (if not NULL)
+    gets one of the values below for every element. out may be one of the
+    arguments (computing in place), the mask must not overlap them.
+*/
+#define LIBM_OK             0
+#define LIBM_DOMAIN_ERROR   1
+#define LIBM_RANGE_ERROR    2
+
+/*
+    libm_name(x), libm_namef(x), libm_name_array(out, x, count, mask) and
+    libm_namef_array(out, x, count, mask) (with a y after x for the binary
+    functions) pass the location of the call on to the error result.
+*/
+#define ___LIBM_DECLARE_UNARY(name)                                             \
+    Result(double) ___libm_## name(int src_line, char* src_file,                \
+                                   const char* src_function, double x);         \
+    Result(float) ___libm_## name ##f(int src_line, char* src_file,             \
+                                      const char* src_function, float x);       \
+                                                                                \
+    Result(void) ___libm_## name ##_array(int src_line, char* src_file,         \
+                                          const char* src_function,             \
+                                          double* out, const double* x,         \
+                                          size_t count, uint8_t* mask);         \
+                                                                                \
+    Result(void) ___libm_## name ##f_array(int src_line, char* src_file,        \
+                                           const char* src_function,            \
+                                           float* out, const float* x,          \
+                                           size_t count, uint8_t* mask);        \
+
+#define ___LIBM_DECLARE_BINARY(name)                                            \
+    Result(double) ___libm_## name(int src_line, char* src_file,                \
+                                   const char* src_function,                    \
+                                   double x, double y);                         \
+    Result(float) ___libm_## name ##f(int src_line, char* src_file,             \
+                                      const char* src_function,                 \
+                                      float x, float y);                        \
+                                                                                \
+    Result(void) ___libm_## name ##_array(int src_line, char* src_file,         \
+                                          const char* src_function,             \
+                                          double* out, const double* x,         \
+                                          const double* y, size_t count,        \
+                                          uint8_t* mask);                       \
+                                                                                \
+    Result(void) ___libm_## name ##f_array(int src_line, char* src_file,        \
+                                           const char* src_function,            \
+                                           float* out, const float* x,          \
+                                           const float* y, size_t count,        \
+                                           uint8_t* mask);                      \
+
+___LIBM_DECLARE_UNARY(sqrt)
+___LIBM_DECLARE_UNARY(exp)
+___LIBM_DECLARE_UNARY(exp2)
+___LIBM_DECLARE_UNARY(expm1)
+___LIBM_DECLARE_UNARY(log)
+___LIBM_DECLARE_UNARY(log2)
+___LIBM_DECLARE_UNARY(log10)
+___LIBM_DECLARE_UNARY(log1p)
+___LIBM_DECLARE_UNARY(sin)
+___LIBM_DECLARE_UNARY(cos)
+___LIBM_DECLARE_UNARY(tan)
+___LIBM_DECLARE_UNARY(asin)
+___LIBM_DECLARE_UNARY(acos)
+___LIBM_DECLARE_UNARY(sinh)
+___LIBM_DECLARE_UNARY(cosh)
+___LIBM_DECLARE_UNARY(acosh)
+___LIBM_DECLARE_UNARY(atanh)
+___LIBM_DECLARE_UNARY(tgamma)
+
+___LIBM_DECLARE_BINARY(pow)
+___LIBM_DECLARE_BINARY(hypot)
+___LIBM_DECLARE_BINARY(fmod)
+
+#define libm_sqrt(x) ___libm_sqrt(__LINE__, __FILE__, __func__, x)
+#define libm_sqrt_array(out, x, count, mask)                                    \
+    ___libm_sqrt_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+#define libm_sqrtf(x) ___libm_sqrtf(__LINE__, __FILE__, __func__, x)
+#define libm_sqrtf_array(out, x, count, mask)                                   \
+    ___libm_sqrtf_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+
+#define libm_exp(x) ___libm_exp(__LINE__, __FILE__, __func__, x)
+#define libm_exp_array(out, x, count, mask)                                     \
+    ___libm_exp_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+#define libm_expf(x) ___libm_expf(__LINE__, __FILE__, __func__, x)
+#define libm_expf_array(out, x, count, mask)                                    \
+    ___libm_expf_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+
+#define libm_exp2(x) ___libm_exp2(__LINE__, __FILE__, __func__, x)
+#define libm_exp2_array(out, x, count, mask)                                    \
+    ___libm_exp2_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+#define libm_exp2f(x) ___libm_exp2f(__LINE__, __FILE__, __func__, x)
+#define libm_exp2f_array(out, x, count, mask)                                   \
+    ___libm_exp2f_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+
+#define libm_expm1(x) ___libm_expm1(__LINE__, __FILE__, __func__, x)
+#define libm_expm1_array(out, x, count, mask)                                   \
+    ___libm_expm1_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+#define libm_expm1f(x) ___libm_expm1f(__LINE__, __FILE__, __func__, x)
+#define libm_expm1f_array(out, x, count, mask)                                  \
+    ___libm_expm1f_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+
+#define libm_log(x) ___libm_log(__LINE__, __FILE__, __func__, x)
+#define libm_log_array(out, x, count, mask)                                     \
+    ___libm_log_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+#define libm_logf(x) ___libm_logf(__LINE__, __FILE__, __func__, x)
+#define libm_logf_array(out, x, count, mask)                                    \
+    ___libm_logf_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+
+#define libm_log2(x) ___libm_log2(__LINE__, __FILE__, __func__, x)
+#define libm_log2_array(out, x, count, mask)                                    \
+    ___libm_log2_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+#define libm_log2f(x) ___libm_log2f(__LINE__, __FILE__, __func__, x)
+#define libm_log2f_array(out, x, count, mask)                                   \
+    ___libm_log2f_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+
+#define libm_log10(x) ___libm_log10(__LINE__, __FILE__, __func__, x)
+#define libm_log10_array(out, x, count, mask)                                   \
+    ___libm_log10_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+#define libm_log10f(x) ___libm_log10f(__LINE__, __FILE__, __func__, x)
+#define libm_log10f_array(out, x, count, mask)                                  \
+    ___libm_log10f_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+
+#define libm_log1p(x) ___libm_log1p(__LINE__, __FILE__, __func__, x)
+#define libm_log1p_array(out, x, count, mask)                                   \
+    ___libm_log1p_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+#define libm_log1pf(x) ___libm_log1pf(__LINE__, __FILE__, __func__, x)
+#define libm_log1pf_array(out, x, count, mask)                                  \
+    ___libm_log1pf_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+
+#define libm_sin(x) ___libm_sin(__LINE__, __FILE__, __func__, x)
+#define libm_sin_array(out, x, count, mask)                                     \
+    ___libm_sin_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+#define libm_sinf(x) ___libm_sinf(__LINE__, __FILE__, __func__, x)
+#define libm_sinf_array(out, x, count, mask)                                    \
+    ___libm_sinf_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+
+#define libm_cos(x) ___libm_cos(__LINE__, __FILE__, __func__, x)
+#define libm_cos_array(out, x, count, mask)                                     \
+    ___libm_cos_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+#define libm_cosf(x) ___libm_cosf(__LINE__, __FILE__, __func__, x)
+#define libm_cosf_array(out, x, count, mask)                                    \
+    ___libm_cosf_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+
+#define libm_tan(x) ___libm_tan(__LINE__, __FILE__, __func__, x)
+#define libm_tan_array(out, x, count, mask)                                     \
+    ___libm_tan_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+#define libm_tanf(x) ___libm_tanf(__LINE__, __FILE__, __func__, x)
+#define libm_tanf_array(out, x, count, mask)                                    \
+    ___libm_tanf_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+
+#define libm_asin(x) ___libm_asin(__LINE__, __FILE__, __func__, x)
+#define libm_asin_array(out, x, count, mask)                                    \
+    ___libm_asin_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+#define libm_asinf(x) ___libm_asinf(__LINE__, __FILE__, __func__, x)
+#define libm_asinf_array(out, x, count, mask)                                   \
+    ___libm_asinf_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+
+#define libm_acos(x) ___libm_acos(__LINE__, __FILE__, __func__, x)
+#define libm_acos_array(out, x, count, mask)                                    \
+    ___libm_acos_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+#define libm_acosf(x) ___libm_acosf(__LINE__, __FILE__, __func__, x)
+#define libm_acosf_array(out, x, count, mask)                                   \
+    ___libm_acosf_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+
+#define libm_sinh(x) ___libm_sinh(__LINE__, __FILE__, __func__, x)
+#define libm_sinh_array(out, x, count, mask)                                    \
+    ___libm_sinh_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+#define libm_sinhf(x) ___libm_sinhf(__LINE__, __FILE__, __func__, x)
+#define libm_sinhf_array(out, x, count, mask)                                   \
+    ___libm_sinhf_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+
+#define libm_cosh(x) ___libm_cosh(__LINE__, __FILE__, __func__, x)
+#define libm_cosh_array(out, x, count, mask)                                    \
+    ___libm_cosh_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+#define libm_coshf(x) ___libm_coshf(__LINE__, __FILE__, __func__, x)
+#define libm_coshf_array(out, x, count, mask)                                   \
+    ___libm_coshf_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+
+#define libm_acosh(x) ___libm_acosh(__LINE__, __FILE__, __func__, x)
+#define libm_acosh_array(out, x, count, mask)                                   \
+    ___libm_acosh_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+#define libm_acoshf(x) ___libm_acoshf(__LINE__, __FILE__, __func__, x)
+#define libm_acoshf_array(out, x, count, mask)                                  \
+    ___libm_acoshf_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+
+#define libm_atanh(x) ___libm_atanh(__LINE__, __FILE__, __func__, x)
+#define libm_atanh_array(out, x, count, mask)                                   \
+    ___libm_atanh_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+#define libm_atanhf(x) ___libm_atanhf(__LINE__, __FILE__, __func__, x)
+#define libm_atanhf_array(out, x, count, mask)                                  \
+    ___libm_atanhf_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+
+#define libm_tgamma(x) ___libm_tgamma(__LINE__, __FILE__, __func__, x)
+#define libm_tgamma_array(out, x, count, mask)                                  \
+    ___libm_tgamma_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+#define libm_tgammaf(x) ___libm_tgammaf(__LINE__, __FILE__, __func__, x)
+#define libm_tgammaf_array(out, x, count, mask)                                 \
+    ___libm_tgammaf_array(__LINE__, __FILE__, __func__, out, x, count, mask)
+
+#define libm_pow(x, y)                                                          \
+    ___libm_pow(__LINE__, __FILE__, __func__, x, y)
+#define libm_pow_array(out, x, y, count, mask)                                  \
+    ___libm_pow_array(__LINE__, __FILE__, __func__, out, x, y, count, mask)
+#define libm_powf(x, y)                                                         \
+    ___libm_powf(__LINE__, __FILE__, __func__, x, y)
+#define libm_powf_array(out, x, y, count, mask)                                 \
+    ___libm_powf_array(__LINE__, __FILE__, __func__, out, x, y, count, mask)
+
+#define libm_hypot(x, y)                                                        \
+    ___libm_hypot(__LINE__, __FILE__, __func__, x, y)
+#define libm_hypot_array(out, x, y, count, mask)                                \
+    ___libm_hypot_array(__LINE__, __FILE__, __func__, out, x, y, count, mask)
+#define libm_hypotf(x, y)                                                       \
+    ___libm_hypotf(__LINE__, __FILE__, __func__, x, y)
+#define libm_hypotf_array(out, x, y, count, mask)                               \
+    ___libm_hypotf_array(__LINE__, __FILE__, __func__, out, x, y, count, mask)
+
+#define libm_fmod(x, y)                                                         \
+    ___libm_fmod(__LINE__, __FILE__, __func__, x, y)
+#define libm_fmod_array(out, x, y, count, mask)                                 \
+    ___libm_fmod_array(__LINE__, __FILE__, __func__, out, x, y, count, mask)
+#define libm_fmodf(x, y)                                                        \
+    ___libm_fmodf(__LINE__, __FILE__, __func__, x, y)
+#define libm_fmodf_array(out, x, y, count, mask)                                \
+    ___libm_fmodf_array(__LINE__, __FILE__, __func__, out, x, y, count, mask)
+
+#endif
+
+#endif
@@ -0,0 +1,235 @@
+/*
+    PORTS/ALLOCATORS.H - Allocations returning results
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__MEMORY_ALLOCATORS___
+#define ___RESULT__MEMORY_ALLOCATORS___
+
+#ifndef RESULT_DISABLE_PORTS
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <result.h>
+
+ERROR_DECLARE(MemoryLimitExceeded)
+
+/*
+    The libc allocators. Failures are NotEnoughMemory, an alignment that is
+    not a power of two is an InvalidArgument. When realloc fails the block is
+    left untouched. Zero sized allocations can return NULL, like in libc. The
+    location of the call goes into the result.
+*/
+Result(void_ptr) ___memory_malloc(int src_line, char* src_file,
+                                  const char* src_function, size_t size);
+
+Result(void_ptr) ___memory_calloc(int src_line, char* src_file,
+                                  const char* src_function, size_t count,
+                                  size_t size);
+
+Result(void_ptr) ___memory_realloc(int src_line, char* src_file,
+                                   const char* src_function, void* pointer,
+                                   size_t size);
+
+Result(void_ptr) ___memory_aligned_alloc(int src_line, char* src_file,
+                                         const char* src_function,
+                                         size_t alignment, size_t size);
+
+#define memory_malloc(size)                                                     \
+    ___memory_malloc(__LINE__, __FILE__, __func__, size)
+
+#define memory_calloc(count, size)                                              \
+    ___memory_calloc(__LINE__, __FILE__, __func__, count, size)
+
+#define memory_realloc(pointer, size)                                           \
+    ___memory_realloc(__LINE__, __FILE__, __func__, pointer, size)
+
+#define memory_aligned_alloc(alignment, size)                                   \
+    ___memory_aligned_alloc(__LINE__, __FILE__, __func__, alignment, size)
+
+typedef struct {
+    size_t  allocations;
+    size_t  releases;               /* objects released, or arena resets */
+    size_t  failures;
+    size_t  bytes_in_use;
+    size_t  peak_bytes_in_use;
+    size_t  bytes_reserved;         /* taken from malloc, with the headers */
+    size_t  blocks;
+} MemoryStats;
+
+typedef struct ___MEMORY_BLOCK {
+    struct ___MEMORY_BLOCK*     next;
+    size_t                      size;
+} ___MEMORY_BLOCK;
+
+/*
+    Arenas hand out memory by bumping a cursor through blocks taken from
+    malloc, and release all of it at once. Requests larger than a block get a
+    block of their own. The capacity limits the bytes taken from malloc, going
+    over it fails with MemoryLimitExceeded.
+
+    Arenas and pools are not thread-safe, keep one per thread.
+*/
+#define MEMORY_ARENA_BLOCK_SIZE 65536
+
+typedef struct {
+    uintptr_t           cursor;
+    uintptr_t           end;
+    ___MEMORY_BLOCK*    blocks;
+    size_t              block_size;
+    size_t              capacity;
+    MemoryStats         stats;
+} MemoryArena;
+
+/* 0 picks MEMORY_ARENA_BLOCK_SIZE, a capacity of 0 is unlimited */
+void memory_arena_init(MemoryArena* arena, size_t block_size, size_t capacity);
+
+/*
+    The alignment has to be a power of two. A zero sized allocation takes a
+    byte, so it gets a pointer of its own, never NULL.
+*/
+#define memory_arena_alloc(arena, size, alignment)                              \
+    ___memory_arena_alloc(__LINE__, __FILE__, __func__, arena, size, alignment)
+
+#define memory_arena_new(arena, type)                                           \
+    memory_arena_alloc(arena, sizeof(type), _Alignof(type))
+
+/* Keeps the current block for the next allocations, and frees the rest */
+void memory_arena_reset(MemoryArena* arena);
+
+void memory_arena_free(MemoryArena* arena);
+
+MemoryStats memory_arena_stats(const MemoryArena* arena);
+
+/*
+    Pools hand out objects of a single size, released objects are kept on a
+    free list for the next allocations. The objects are carved out of blocks
+    of objects_per_block objects. The capacity limits the number of live
+    objects, going over it fails with MemoryLimitExceeded.
+*/
+#define MEMORY_POOL_OBJECTS_PER_BLOCK 256
+
+typedef struct {
+    void*               free_list;
+    uintptr_t           cursor;
+    uintptr_t           end;
+    ___MEMORY_BLOCK*    blocks;
+    size_t              object_size;
+    size_t              objects_per_block;
+    size_t              capacity;
+    MemoryStats         stats;
+} MemoryPool;
+
+/* 0 picks MEMORY_POOL_OBJECTS_PER_BLOCK, a capacity of 0 is unlimited */
+void memory_pool_init(MemoryPool* pool, size_t object_size,
+                      size_t objects_per_block, size_t capacity);
+
+#define memory_pool_alloc(pool)                                                 \
+    ___memory_pool_alloc(__LINE__, __FILE__, __func__, pool)
+
+void memory_pool_free(MemoryPool* pool);
+
+MemoryStats memory_pool_stats(const MemoryPool* pool);
+
+/*
+    The happy paths are inline, a bump or a pop from the free list. New
+    blocks and the errors go through the out of line functions.
+*/
+#define ___MEMORY_OK(result_value)                                              \
+    (Result(void_ptr)) {                                                        \
+        .value = (result_value),                                                \
+        .error = NULL,                                                          \
+        .src_file = src_file,                                                   \
+        .src_line = src_line,                                                   \
+        .src_function = src_function,                                           \
+    }                                                                           \
+
+Result(void_ptr) ___memory_arena_grow(int src_line, char* src_file,
+                                      const char* src_function,
+                                      MemoryArena* arena, size_t size,
+                                      size_t alignment);
+
+static inline Result(void_ptr) ___memory_arena_alloc(int src_line,
+                                                     char* src_file,
+                                                     const char* src_function,
+                                                     MemoryArena* arena,
+                                                     size_t size,
+                                                     size_t alignment)
+{
+    uintptr_t start = (arena->cursor + alignment - 1) & ~(alignment - 1);
+    size_t taken = size + (size == 0);
+
+    if (___RESULT_LIKELY(alignment != 0 && (alignment & (alignment - 1)) == 0
+                         && start >= arena->cursor && start <= arena->end
+                         && taken <= arena->end - start)) {
+        arena->cursor = start + taken;
+        arena->stats.allocations++;
+        arena->stats.bytes_in_use += size;
+
+        return ___MEMORY_OK((void*) start);
+    }
+
+    return ___memory_arena_grow(src_line, src_file, src_function, arena, size,
+                                alignment);
+}
+
+Result(void_ptr) ___memory_pool_grow(int src_line, char* src_file,
+                                     const char* src_function,
+                                     MemoryPool* pool);
+
+static inline Result(void_ptr) ___memory_pool_alloc(int src_line,
+                                                    char* src_file,
+                                                    const char* src_function,
+                                                    MemoryPool* pool)
+{
+    void* object = pool->free_list;
+
+    if (___RESULT_UNLIKELY(
+            pool->stats.allocations - pool->stats.releases >= pool->capacity))
+        return ___memory_pool_grow(src_line, src_file, src_function, pool);
+
+    if (___RESULT_LIKELY(object != NULL))
+        pool->free_list = *(void**) object;
+    else if (___RESULT_LIKELY(pool->cursor != pool->end)) {
+        object = (void*) pool->cursor;
+        pool->cursor += pool->object_size;
+    } else
+        return ___memory_pool_grow(src_line, src_file, src_function, pool);
+
+    pool->stats.allocations++;
+    pool->stats.bytes_in_use += pool->object_size;
+    if (pool->stats.bytes_in_use > pool->stats.peak_bytes_in_use)
+        pool->stats.peak_bytes_in_use = pool->stats.bytes_in_use;
+
+    return ___MEMORY_OK(object);
+}
+
+/* The object has to come from the same pool */
+static inline void memory_pool_release(MemoryPool* pool, void* object)
+{
+    if (object == NULL) return;
+
+    *(void**) object = pool->free_list;
+    pool->free_list = object;
+
+    pool->stats.releases++;
+    pool->stats.bytes_in_use -= pool->object_size;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,226 @@
+/*
+    PORTS/NUMBERS.H - Parsing numbers from text
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__PARSE_NUMBERS___
+#define ___RESULT__PARSE_NUMBERS___
+
+#ifndef RESULT_DISABLE_PORTS
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <result.h>
+
+ERROR_DECLARE(ParseEmpty)
+ERROR_DECLARE(ParseInvalidDigit)
+ERROR_DECLARE(ParseOverflow)
+
+/*
+    The parsers work like from_chars. The text doesn't have to end with a NUL,
+    leading whitespace and a plus sign are not accepted, and the longest number
+    at the start of the text is parsed. The number of characters taken is
+    stored in consumed (if not NULL), the rest of the text is left for the
+    caller. Parsing doesn't depend on the locale.
+
+    An empty text gives ParseEmpty, a text not starting with a number gives
+    ParseInvalidDigit, and a number that doesn't fit in the type gives
+    ParseOverflow (with the value clamped, and all of the digits consumed).
+*/
+const Error* ___result_parse_unsigned(const char* text, size_t length,
+                                      uint64_t max, uint64_t* value,
+                                      size_t* consumed);
+
+/* The value is stored in two's complement, negative numbers may reach -max-1 */
+const Error* ___result_parse_signed(const char* text, size_t length,
+                                    uint64_t max, uint64_t* value,
+                                    size_t* consumed);
+
+#define ___RESULT_PARSE_SIGNED(type) ((type) -1 < (type) 1)
+
+#define ___RESULT_PARSE_MAX(type)                                               \
+    ((uint64_t) -1 >> (64 - sizeof(type) * CHAR_BIT +                           \
+                       ___RESULT_PARSE_SIGNED(type)))
+
+/*
+    Defines ___result_parse_type for an integer type. The parsers are inline
+    over the two out of line ones above, so there is nothing to define in a
+    source file. Call them with result_parse(type, text, length, consumed).
+*/
+#define RESULT_PARSE_DECLARE(type)                                              \
+    static inline Result(type)                                                  \
+    ___result_parse_## type(int src_line, char* src_file,                       \
+                            const char* src_function, const char* text,         \
+                            size_t length, size_t* consumed)                    \
+    {                                                                           \
+        uint64_t value;                                                         \
+        const Error* error = ___RESULT_PARSE_SIGNED(type)                       \
+            ? ___result_parse_signed(text, length, ___RESULT_PARSE_MAX(type),   \
+                                     &value, consumed)                          \
+            : ___result_parse_unsigned(text, length, ___RESULT_PARSE_MAX(type), \
+                                       &value, consumed);                       \
+                                                                                \
+        if (___RESULT_UNLIKELY(error != NULL))                                  \
+            return ___RESULT_## type ##_declare(error, src_line, src_file,      \
+                                                src_function, (type) value);    \
+                                                                                \
+        return (Result(type)) {                                                 \
+            .value = (type) value,                                              \
+            .error = NULL,                                                      \
+            .src_file = src_file,                                               \
+            .src_line = src_line,                                               \
+            .src_function = src_function,                                       \
+        };                                                                      \
+    }                                                                           \
+
+/* Takes the text, its length and consumed */
+#define result_parse(type, ...)                                                 \
+    ___result_parse_## type(__LINE__, __FILE__, __func__, __VA_ARGS__)
+
+RESULT_PARSE_DECLARE(int8_t)
+RESULT_PARSE_DECLARE(int16_t)
+RESULT_PARSE_DECLARE(int32_t)
+RESULT_PARSE_DECLARE(int64_t)
+RESULT_PARSE_DECLARE(int_fast8_t)
+RESULT_PARSE_DECLARE(int_fast16_t)
+RESULT_PARSE_DECLARE(int_fast32_t)
+RESULT_PARSE_DECLARE(int_fast64_t)
+RESULT_PARSE_DECLARE(int_least8_t)
+RESULT_PARSE_DECLARE(int_least16_t)
+RESULT_PARSE_DECLARE(int_least32_t)
+RESULT_PARSE_DECLARE(int_least64_t)
+RESULT_PARSE_DECLARE(intmax_t)
+RESULT_PARSE_DECLARE(intptr_t)
+RESULT_PARSE_DECLARE(uint8_t)
+RESULT_PARSE_DECLARE(uint16_t)
+RESULT_PARSE_DECLARE(uint32_t)
+RESULT_PARSE_DECLARE(uint64_t)
+RESULT_PARSE_DECLARE(uint_fast8_t)
+RESULT_PARSE_DECLARE(uint_fast16_t)
+RESULT_PARSE_DECLARE(uint_fast32_t)
+RESULT_PARSE_DECLARE(uint_fast64_t)
+RESULT_PARSE_DECLARE(uint_least8_t)
+RESULT_PARSE_DECLARE(uint_least16_t)
+RESULT_PARSE_DECLARE(uint_least32_t)
+RESULT_PARSE_DECLARE(uint_least64_t)
+RESULT_PARSE_DECLARE(uintmax_t)
+RESULT_PARSE_DECLARE(uintptr_t)
+RESULT_PARSE_DECLARE(char)
+RESULT_PARSE_DECLARE(short)
+RESULT_PARSE_DECLARE(int)
+RESULT_PARSE_DECLARE(long)
+RESULT_PARSE_DECLARE(long_long)
+RESULT_PARSE_DECLARE(unsigned_char)
+RESULT_PARSE_DECLARE(unsigned_short)
+RESULT_PARSE_DECLARE(unsigned_int)
+RESULT_PARSE_DECLARE(unsigned_long)
+RESULT_PARSE_DECLARE(unsigned_long_long)
+RESULT_PARSE_DECLARE(size_t)
+RESULT_PARSE_DECLARE(ptrdiff_t)
+
+/*
+    Accepts [-]digits[.digits][(e|E)[+|-]digits], inf, infinity and nan
+    (in any case). Numbers too large for a double give ParseOverflow, too small
+    ones are rounded (to zero if needed).
+*/
+Result(double) ___result_parse_double(int src_line, char* src_file,
+                                      const char* src_function,
+                                      const char* text, size_t length,
+                                      size_t* consumed);
+
+/*
+    Parse up to count fields separated by the delimiter into out. The value is
+    the number of the parsed fields, and on error the index of the failing one.
+    A field has to be a whole number, and a delimiter has to be followed by
+    one, so a trailing delimiter gives ParseEmpty. When count fields are
+    parsed, the delimiter after the last one is left in the text. consumed is
+    the offset where parsing stopped.
+*/
+#define ___RESULT_PARSE_DECLARE_COLUMN(type)                                    \
+    Result(size_t) ___result_parse_## type ##_column(int src_line,              \
+                                                     char* src_file,            \
+                                                     const char* src_function,  \
+                                                     const char* text,          \
+                                                     size_t length,             \
+                                                     char delimiter,            \
+                                                     type* out, size_t count,   \
+                                                     size_t* consumed);         \
+
+___RESULT_PARSE_DECLARE_COLUMN(int64_t)
+___RESULT_PARSE_DECLARE_COLUMN(uint64_t)
+___RESULT_PARSE_DECLARE_COLUMN(double)
+
+/* Takes the text, its length, the delimiter, out, count and consumed */
+#define result_parse_column(type, ...)                                          \
+    ___result_parse_## type ##_column(__LINE__, __FILE__, __func__, __VA_ARGS__)
+
+/*
+    parse_type(text, length, consumed) and
+    parse_type_column(text, length, delimiter, out, count, consumed), the
+    location of the call goes into the result.
+*/
+#define parse_int8_t(...) result_parse(int8_t, __VA_ARGS__)
+#define parse_int16_t(...) result_parse(int16_t, __VA_ARGS__)
+#define parse_int32_t(...) result_parse(int32_t, __VA_ARGS__)
+#define parse_int64_t(...) result_parse(int64_t, __VA_ARGS__)
+#define parse_int_fast8_t(...) result_parse(int_fast8_t, __VA_ARGS__)
+#define parse_int_fast16_t(...) result_parse(int_fast16_t, __VA_ARGS__)
+#define parse_int_fast32_t(...) result_parse(int_fast32_t, __VA_ARGS__)
+#define parse_int_fast64_t(...) result_parse(int_fast64_t, __VA_ARGS__)
+#define parse_int_least8_t(...) result_parse(int_least8_t, __VA_ARGS__)
+#define parse_int_least16_t(...) result_parse(int_least16_t, __VA_ARGS__)
+#define parse_int_least32_t(...) result_parse(int_least32_t, __VA_ARGS__)
+#define parse_int_least64_t(...) result_parse(int_least64_t, __VA_ARGS__)
+#define parse_intmax_t(...) result_parse(intmax_t, __VA_ARGS__)
+#define parse_intptr_t(...) result_parse(intptr_t, __VA_ARGS__)
+#define parse_uint8_t(...) result_parse(uint8_t, __VA_ARGS__)
+#define parse_uint16_t(...) result_parse(uint16_t, __VA_ARGS__)
+#define parse_uint32_t(...) result_parse(uint32_t, __VA_ARGS__)
+#define parse_uint64_t(...) result_parse(uint64_t, __VA_ARGS__)
+#define parse_uint_fast8_t(...) result_parse(uint_fast8_t, __VA_ARGS__)
+#define parse_uint_fast16_t(...) result_parse(uint_fast16_t, __VA_ARGS__)
+#define parse_uint_fast32_t(...) result_parse(uint_fast32_t, __VA_ARGS__)
+#define parse_uint_fast64_t(...) result_parse(uint_fast64_t, __VA_ARGS__)
+#define parse_uint_least8_t(...) result_parse(uint_least8_t, __VA_ARGS__)
+#define parse_uint_least16_t(...) result_parse(uint_least16_t, __VA_ARGS__)
+#define parse_uint_least32_t(...) result_parse(uint_least32_t, __VA_ARGS__)
+#define parse_uint_least64_t(...) result_parse(uint_least64_t, __VA_ARGS__)
+#define parse_uintmax_t(...) result_parse(uintmax_t, __VA_ARGS__)
+#define parse_uintptr_t(...) result_parse(uintptr_t, __VA_ARGS__)
+#define parse_char(...) result_parse(char, __VA_ARGS__)
+#define parse_short(...) result_parse(short, __VA_ARGS__)
+#define parse_int(...) result_parse(int, __VA_ARGS__)
+#define parse_long(...) result_parse(long, __VA_ARGS__)
+#define parse_long_long(...) result_parse(long_long, __VA_ARGS__)
+#define parse_unsigned_char(...) result_parse(unsigned_char, __VA_ARGS__)
+#define parse_unsigned_short(...) result_parse(unsigned_short, __VA_ARGS__)
+#define parse_unsigned_int(...) result_parse(unsigned_int, __VA_ARGS__)
+#define parse_unsigned_long(...) result_parse(unsigned_long, __VA_ARGS__)
+#define parse_unsigned_long_long(...)                                           \
+    result_parse(unsigned_long_long, __VA_ARGS__)
+#define parse_size_t(...) result_parse(size_t, __VA_ARGS__)
+#define parse_ptrdiff_t(...) result_parse(ptrdiff_t, __VA_ARGS__)
+#define parse_double(...) result_parse(double, __VA_ARGS__)
+
+#define parse_int64_t_column(...) result_parse_column(int64_t, __VA_ARGS__)
+#define parse_uint64_t_column(...) result_parse_column(uint64_t, __VA_ARGS__)
+#define parse_double_column(...) result_parse_column(double, __VA_ARGS__)
+
+#endif
+
+#endif
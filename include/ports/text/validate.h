@@ -0,0 +1,68 @@
+/*
+    PORTS/VALIDATE.H - Validating untrusted text
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__TEXT_VALIDATE___
+#define ___RESULT__TEXT_VALIDATE___
+
+#ifndef RESULT_DISABLE_PORTS
+
+#include <stddef.h>
+
+#include <result.h>
+
+/* The text is not what it was expected to be */
+ERROR_KIND_DEFINE(InvalidText,              9,  0)
+
+ERROR_DECLARE(InvalidUtf8)
+ERROR_DECLARE(NonAsciiCharacter)
+ERROR_DECLARE(UnexpectedNulByte)
+
+/*
+    The validators return the length of the text, or an error with the offset
+    of the first violation as the value. For UTF-8 that's the first byte of
+    the malformed sequence (overlong forms, surrogates and code points above
+    U+10FFFF are malformed too). The location of the call goes into the
+    result.
+
+    The kernels are picked at the first call: AVX2 for UTF-8, AVX2 or SSE2 for
+    ASCII where the cpu has them, and a word at a time scalar code otherwise.
+*/
+Result(size_t) ___text_validate_utf8(int src_line, char* src_file,
+                                     const char* src_function,
+                                     const char* text, size_t length);
+
+Result(size_t) ___text_validate_ascii(int src_line, char* src_file,
+                                      const char* src_function,
+                                      const char* text, size_t length);
+
+Result(size_t) ___text_validate_no_nul(int src_line, char* src_file,
+                                       const char* src_function,
+                                       const char* text, size_t length);
+
+#define text_validate_utf8(text, length)                                        \
+    ___text_validate_utf8(__LINE__, __FILE__, __func__, text, length)
+
+#define text_validate_ascii(text, length)                                       \
+    ___text_validate_ascii(__LINE__, __FILE__, __func__, text, length)
+
+#define text_validate_no_nul(text, length)                                      \
+    ___text_validate_no_nul(__LINE__, __FILE__, __func__, text, length)
+
+#endif
+
+#endif
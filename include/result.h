@@ -25,13 +25,55 @@
 
 #include <wchar.h>
 
+#include "compiler.h"
 #include "panic.h"
 #include "error.h"
+#include "hooks.h"
+#include "retry.h"
 #include "ports/libc/errors.h"
 #include "version.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define Result(type) ___RESULT_ ## type
 
+/*
+    Out of line panic paths shared by all of the result types.
+
+    They are kept cold and out of line, so the happy path of unwrap and expect
+    is a single test and jump. The origin points at the error field of the
+    result, all result types share the layout of Result(void) from there on.
+*/
+___RESULT_COLD ___RESULT_PANIC_NORETURN
+void ___RESULT_panic_unwrap(int src_line, char* src_file,
+                            const char* src_function, const void* origin);
+
+___RESULT_COLD ___RESULT_PANIC_NORETURN
+void ___RESULT_panic_expect(int src_line, char* src_file,
+                            const char* src_function, const void* origin,
+                            const char* error);
+
+___RESULT_COLD ___RESULT_PANIC_NORETURN
+void ___RESULT_panic_unwrap_err(int src_line, char* src_file,
+                                const char* src_function);
+
+___RESULT_COLD ___RESULT_PANIC_NORETURN
+void ___RESULT_panic_expect_err(int src_line, char* src_file,
+                                const char* src_function, const char* error);
+
+/*
+    One stage of result_chain, inline so the call through the pointer becomes
+    a direct one and every stage returns straight from its own test
+*/
+#define ___RESULT_DECLARE_CHAIN(type)                                           \
+    static inline Result(type) ___RESULT_## type ##_chain(Result(type) self,    \
+                                                Result(type) (*c)(type))        \
+    {                                                                           \
+        return result_is_err(self) ? self : c(self.value);                      \
+    }                                                                           \
+
 #define RESULT_DEFINE_WITH_TYPE(type)                                           \
     typedef struct {                                                            \
         type            value;                                                  \
@@ -41,6 +83,8 @@
         const char*     src_function;                                           \
     } Result(type);                                                             \
                                                                                 \
+    ___RESULT_DECLARE_CHAIN(type)                                               \
+                                                                                \
     RESULT_DEFINE(type)                                                         \
 
 #define RESULT_DECLARE(type)                                                    \
@@ -52,6 +96,8 @@
         const char*     src_function;                                           \
     } Result(type);                                                             \
                                                                                 \
+    ___RESULT_DECLARE_CHAIN(type)                                               \
+                                                                                \
     Result(type) ___RESULT_## type ##_declare(const Error* error, int src_line, \
                                               char* src_file,                   \
                                               const char* src_function,         \
@@ -103,6 +149,11 @@
                                          bool (*c)(const Error*));              \
                                                                                 \
     bool ___RESULT_## type ##_is_ok_and(Result(type) self, bool (*c)(type));    \
+                                                                                \
+    Result(type) ___RESULT_## type ##_retry(const RetryPolicy* policy,          \
+                                            RetryStats* stats,                  \
+                                            Result(type) (*c)(void*),           \
+                                            void* context);                     \
 
 
 #define RESULT_DEFINE(type)                                                     \
@@ -119,6 +170,8 @@
             .src_function = src_function,                                       \
         };                                                                      \
                                                                                 \
+        ___RESULT_ERROR_HOOK(error, src_line, src_file, src_function);          \
+                                                                                \
         return result;                                                          \
     }                                                                           \
                                                                                 \
@@ -126,18 +179,9 @@
                                      const char* src_function,                  \
                                      Result(type) self)                         \
     {                                                                           \
-        if (is_err(self))                                                     	\
-            panic_function(src_line,                                            \
-                           src_file,                                            \
-                           src_function,                                        \
-                           self.error->exit_code,                               \
-                           "Tried to unwrap from an error result.\""            \
-                           "\n\t\"Error: %s (from %s at %s:%d)",                \
-                           self.error->message,                                 \
-                           self.src_function,                                 	\
-                           self.src_file,                                     	\
-                           self.src_line                                      	\
-                );                                                              \
+        if (is_err(self))                                                       \
+            ___RESULT_panic_unwrap(src_line, src_file, src_function,            \
+                                   &self.error);                                \
                                                                                 \
         return self.value;                                                    	\
     }                                                                           \
@@ -161,18 +205,9 @@
                                      const char* src_function,                  \
                                      Result(type) self, const char* error)      \
     {                                                                           \
-        if (is_err(self))                                                     	\
-            panic_function(src_line,                                            \
-                           src_file,                                            \
-                           src_function,                                        \
-                           6,                                                   \
-                           "\n%s: %s (from %s at %s:%d)",                       \
-                           error,                                               \
-                           self.error->message,                               	\
-                           self.src_function,                                 	\
-                           self.src_file,                                     	\
-                           self.src_line                                      	\
-                );                                                              \
+        if (is_err(self))                                                       \
+            ___RESULT_panic_expect(src_line, src_file, src_function,            \
+                                   &self.error, error);                         \
                                                                                 \
         return self.value;                                                    	\
     }                                                                           \
@@ -182,14 +217,9 @@
                                                  Result(type) self,             \
                                                  const char* error)	            \
     {                                                                           \
-        if (is_ok(self))                                                      	\
-            panic_function(src_line,                                            \
-                           src_file,                                            \
-                           src_function,                                        \
-                           6,                                                   \
-                           "%s",                                                \
-                           error                                                \
-                );                                                              \
+        if (is_ok(self))                                                        \
+            ___RESULT_panic_expect_err(src_line, src_file, src_function,        \
+                                       error);                                  \
                                                                                 \
         return self.error;                                                    	\
     }                                                                           \
@@ -199,12 +229,7 @@
                                                  Result(type) self)             \
     {                                                                           \
         if (is_ok(self))                                                        \
-            panic_function(src_line,                                            \
-                           src_file,                                            \
-                           src_function,                                        \
-                           6,                                                   \
-                           "\nTried to unwrap an error from an ok result."      \
-                );                                                              \
+            ___RESULT_panic_unwrap_err(src_line, src_file, src_function);       \
                                                                                 \
         return self.error;                                                      \
     }                                                                           \
@@ -263,11 +288,118 @@
     {                                                                           \
         return is_ok(self) && (*c)(self.value);                                 \
     }                                                                           \
+                                                                                \
+    Result(type) ___RESULT_## type ##_retry(const RetryPolicy* policy,          \
+                                            RetryStats* stats,                  \
+                                            Result(type) (*c)(void*),           \
+                                            void* context)                      \
+    {                                                                           \
+        ___RESULT_RETRY_STATE state;                                            \
+        Result(type) result;                                                    \
+                                                                                \
+        ___result_retry_begin(policy, &state);                                  \
+        do                                                                      \
+            result = (*c)(context);                                             \
+        while (___result_retry_again(policy, &state, result.error));            \
+        ___result_retry_end(&state, stats);                                     \
+                                                                                \
+        return result;                                                          \
+    }                                                                           \
+
+/*
+    Defines the methods of a result type as aliases of the methods of another
+    result type, with the same size and signedness of the value. The methods
+    of both types then share a single implementation, so the library carries
+    one copy of the code per value representation, instead of one per type.
+
+    Falls back to RESULT_DEFINE on targets without symbol aliases.
+*/
+#if defined(__ELF__) && (defined(__GNUC__) || defined(__clang__))
+
+#define ___RESULT_ALIAS(target, method)                                         \
+    __attribute__((alias("___RESULT_" #target "_" #method)))
+
+#define RESULT_DEFINE_ALIAS(type, target)                                       \
+    Result(type) ___RESULT_## type ##_declare(const Error* error, int src_line, \
+                                              char* src_file,                   \
+                                              const char* src_function,         \
+                                              type value)                       \
+        ___RESULT_ALIAS(target, declare);                                       \
+                                                                                \
+    type ___RESULT_## type ##_unwrap(int src_line, char* src_file,              \
+                                     const char* src_function,                  \
+                                     Result(type) self)                         \
+        ___RESULT_ALIAS(target, unwrap);                                        \
+                                                                                \
+    type ___RESULT_## type ##_unwrap_or(Result(type) self, type fallback)       \
+        ___RESULT_ALIAS(target, unwrap_or);                                     \
+                                                                                \
+    const Error* ___RESULT_## type ##_unwrap_err_or(Result(type) self,          \
+                                                    const Error* fallback)      \
+        ___RESULT_ALIAS(target, unwrap_err_or);                                 \
+                                                                                \
+    type ___RESULT_## type ##_expect(int src_line, char* src_file,              \
+                                     const char* src_function,                  \
+                                     Result(type) self, const char* error)      \
+        ___RESULT_ALIAS(target, expect);                                        \
+                                                                                \
+    const Error* ___RESULT_## type ##_expect_err(int src_line, char* src_file,  \
+                                                 const char* src_function,      \
+                                                 Result(type) self,             \
+                                                 const char* error)             \
+        ___RESULT_ALIAS(target, expect_err);                                    \
+                                                                                \
+    const Error* ___RESULT_## type ##_unwrap_err(int src_line, char* src_file,  \
+                                                 const char* src_function,      \
+                                                 Result(type) self)             \
+        ___RESULT_ALIAS(target, unwrap_err);                                    \
+                                                                                \
+    Result(type) ___RESULT_## type ##_and(Result(type) self,                    \
+                                          Result(type) other)                   \
+        ___RESULT_ALIAS(target, and);                                           \
+                                                                                \
+    Result(type) ___RESULT_## type ##_and_then(Result(type) self,               \
+                                               Result(type) (*c)(type))         \
+        ___RESULT_ALIAS(target, and_then);                                      \
+                                                                                \
+    Result(type) ___RESULT_## type ##_or(Result(type) self, Result(type) other) \
+        ___RESULT_ALIAS(target, or);                                            \
+                                                                                \
+    Result(type) ___RESULT_## type ##_or_else(Result(type) self,                \
+                                              Result(type) (*c)(const Error*))  \
+        ___RESULT_ALIAS(target, or_else);                                       \
+                                                                                \
+    void ___RESULT_## type ##_inspect(Result(type) self, void (*c)(type))       \
+        ___RESULT_ALIAS(target, inspect);                                       \
+                                                                                \
+    void ___RESULT_## type ##_inspect_err(Result(type) self,                    \
+                                          void (*c)(const Error*))              \
+        ___RESULT_ALIAS(target, inspect_err);                                   \
+                                                                                \
+    bool ___RESULT_## type ##_is_err_and(Result(type) self,                     \
+                                         bool (*c)(const Error*))               \
+        ___RESULT_ALIAS(target, is_err_and);                                    \
+                                                                                \
+    bool ___RESULT_## type ##_is_ok_and(Result(type) self, bool (*c)(type))     \
+        ___RESULT_ALIAS(target, is_ok_and);                                     \
+                                                                                \
+    Result(type) ___RESULT_## type ##_retry(const RetryPolicy* policy,          \
+                                            RetryStats* stats,                  \
+                                            Result(type) (*c)(void*),           \
+                                            void* context)                      \
+        ___RESULT_ALIAS(target, retry);
+
+#else
+
+#define RESULT_DEFINE_ALIAS(type, target) RESULT_DEFINE(type)
+
+#endif
 
 #define result_and(type, self, other)                                           \
     ___RESULT_## type ##_and(self, other)
 
-#define result_and_then(type, self, call) ___RESULT_## type ##_and(self, call)
+#define result_and_then(type, self, call)                                       \
+    ___RESULT_## type ##_and_then(self, call)
 
 #define result_expect(type, result, error)                                      \
     ___RESULT_## type ##_expect(__LINE__, __FILE__, __func__, result, error)
@@ -291,7 +423,7 @@
     ___RESULT_## type ##_unwrap(__LINE__, __FILE__, __func__, result)
 
 #define result_unwrap_err(type, result)                                         \
-    ___RESULT_## type ##_unwrap_err(__LINE__, __FILE___, __func__, result)
+    ___RESULT_## type ##_unwrap_err(__LINE__, __FILE__, __func__, result)
 
 #define result_unwrap_or(type, result, fallback)                                \
     ___RESULT_## type ##_unwrap_or(result, fallback)
@@ -304,20 +436,93 @@
 #define result_or_else(type, self, call)                                        \
     ___RESULT_## type ##_or_else(self, call)
 
+#define result_retry(type, policy, stats, call, context)                        \
+    ___RESULT_## type ##_retry(policy, stats, call, context)
 
+/*
+    result_chain(type, result, call...) passes the value of an ok result to
+    the first call, the value of its result to the next one, and so on, up to
+    the first error, like nested result_and_then. The stages are inline
+    functions, once inlined the calls are direct and every error returns from
+    its own stage, the code is the one of hand-written early returns.
+    Takes up to 16 calls, all of them Result(type) (*)(type).
+*/
+#define ___RESULT_CHAIN_NTH(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12,  \
+                            _13, _14, _15, _16, n, ...) n
+
+#define ___RESULT_CHAIN_COUNT(...)                                              \
+    ___RESULT_CHAIN_NTH(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6,    \
+                        5, 4, 3, 2, 1, 0)
+
+#define ___RESULT_CHAIN_PASTE(n) ___RESULT_CHAIN_ ## n
+#define ___RESULT_CHAIN_EACH(n) ___RESULT_CHAIN_PASTE(n)
+
+#define ___RESULT_CHAIN_MAP(macro, x, ...)                                      \
+    ___RESULT_CHAIN_EACH(___RESULT_CHAIN_COUNT(__VA_ARGS__))(macro, x,          \
+                                                             __VA_ARGS__)
+
+#define ___RESULT_CHAIN_1(macro, x, call) macro(x, call)
+#define ___RESULT_CHAIN_2(macro, x, call, ...)                                  \
+    macro(x, call) ___RESULT_CHAIN_1(macro, x, __VA_ARGS__)
+#define ___RESULT_CHAIN_3(macro, x, call, ...)                                  \
+    macro(x, call) ___RESULT_CHAIN_2(macro, x, __VA_ARGS__)
+#define ___RESULT_CHAIN_4(macro, x, call, ...)                                  \
+    macro(x, call) ___RESULT_CHAIN_3(macro, x, __VA_ARGS__)
+#define ___RESULT_CHAIN_5(macro, x, call, ...)                                  \
+    macro(x, call) ___RESULT_CHAIN_4(macro, x, __VA_ARGS__)
+#define ___RESULT_CHAIN_6(macro, x, call, ...)                                  \
+    macro(x, call) ___RESULT_CHAIN_5(macro, x, __VA_ARGS__)
+#define ___RESULT_CHAIN_7(macro, x, call, ...)                                  \
+    macro(x, call) ___RESULT_CHAIN_6(macro, x, __VA_ARGS__)
+#define ___RESULT_CHAIN_8(macro, x, call, ...)                                  \
+    macro(x, call) ___RESULT_CHAIN_7(macro, x, __VA_ARGS__)
+#define ___RESULT_CHAIN_9(macro, x, call, ...)                                  \
+    macro(x, call) ___RESULT_CHAIN_8(macro, x, __VA_ARGS__)
+#define ___RESULT_CHAIN_10(macro, x, call, ...)                                 \
+    macro(x, call) ___RESULT_CHAIN_9(macro, x, __VA_ARGS__)
+#define ___RESULT_CHAIN_11(macro, x, call, ...)                                 \
+    macro(x, call) ___RESULT_CHAIN_10(macro, x, __VA_ARGS__)
+#define ___RESULT_CHAIN_12(macro, x, call, ...)                                 \
+    macro(x, call) ___RESULT_CHAIN_11(macro, x, __VA_ARGS__)
+#define ___RESULT_CHAIN_13(macro, x, call, ...)                                 \
+    macro(x, call) ___RESULT_CHAIN_12(macro, x, __VA_ARGS__)
+#define ___RESULT_CHAIN_14(macro, x, call, ...)                                 \
+    macro(x, call) ___RESULT_CHAIN_13(macro, x, __VA_ARGS__)
+#define ___RESULT_CHAIN_15(macro, x, call, ...)                                 \
+    macro(x, call) ___RESULT_CHAIN_14(macro, x, __VA_ARGS__)
+#define ___RESULT_CHAIN_16(macro, x, call, ...)                                 \
+    macro(x, call) ___RESULT_CHAIN_15(macro, x, __VA_ARGS__)
+
+#define ___RESULT_CHAIN_OPEN(type, call) ___RESULT_## type ##_chain(
+#define ___RESULT_CHAIN_CLOSE(type, call) , call)
+
+#define result_chain(type, result, ...)                                         \
+    ___RESULT_CHAIN_MAP(___RESULT_CHAIN_OPEN, type, __VA_ARGS__) (result)       \
+    ___RESULT_CHAIN_MAP(___RESULT_CHAIN_CLOSE, type, __VA_ARGS__)
+
+
+/* The value of an error is zeroed, a compound literal works for structs too */
 #define result_ERR(type, error)                                                 \
-    ___RESULT_## type ##_declare(ERR(error), __LINE__, __FILE__, __func__, 0)
+    ___RESULT_## type ##_declare(ERR(error), __LINE__, __FILE__, __func__,      \
+                                 (type) { 0 })
 
 #define ___RESULT_ERR_RAW(type, error)                                          \
-    ___RESULT_## type ##_declare(error, __LINE__, __FILE__, __func__, 0)
+    ___RESULT_## type ##_declare(error, __LINE__, __FILE__, __func__,           \
+                                 (type) { 0 })
+
 
+#define result_is_ok(self) ___RESULT_LIKELY((self).error == NULL)
+#define result_is_err(self) ___RESULT_UNLIKELY((self).error != NULL)
 
-#define result_is_ok(self) self.error == NULL
-#define result_is_err(self) self.error != NULL
+#define result_is_kind(self, kind)                                              \
+    ((self).error != NULL && error_is_kind((self).error, kind))
 
 
-#define ___RESULT_ARG(_1, _2, _3, ...) _3
-#define ___RESULT_HAS_COMMA(...) ___RESULT_ARG(__VA_ARGS__, 0, 0, 1, 1)
+/* Compound literal values have commas of their own, up to 15 are told apart */
+#define ___RESULT_ARG(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13,   \
+                      _14, _15, _16, _17, ...) _17
+#define ___RESULT_HAS_COMMA(...)                                                \
+    ___RESULT_ARG(__VA_ARGS__, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0)
 
 #define ___RESULT_OK_EXPAND(x) ___RESULT_OK ## x
 #define ___RESULT_OK_HELPER(x) ___RESULT_OK_EXPAND(x)
@@ -326,10 +531,10 @@
     ___RESULT_OK_HELPER(___RESULT_HAS_COMMA(__VA_ARGS__))(__VA_ARGS__)
 
 #define ___RESULT_OK0(...)                                                      \
-    ___RESULT_void_declare(NULL, __LINE__, __FILE__, __func__, __VA_ARGS__)
+    ___RESULT_void_declare_real(NULL, __LINE__, __FILE__, __func__)
 
 #define ___RESULT_OK1(type, ...)                                                \
-    ___RESULT_## type ##_declare(NULL, __LINE__, __FILE__, __func__)
+    ___RESULT_## type ##_declare(NULL, __LINE__, __FILE__, __func__, __VA_ARGS__)
 
 #ifndef RESULT_DONT_DEFINE_SHORTCUTS
 
@@ -343,12 +548,29 @@
 
 #define is_ok result_is_ok
 #define is_err result_is_err
+#define is_kind result_is_kind
 
 #endif
 
 RESULT_DECLARE(char)
 typedef char* char_ptr;
 RESULT_DECLARE(char_ptr)
+typedef void* void_ptr;
+RESULT_DECLARE(void_ptr)
+
+/* Borrowed views of memory owned by someone else, not ended with a NUL */
+typedef struct {
+    const char*     data;
+    size_t          length;
+} str_slice;
+RESULT_DECLARE(str_slice)
+
+typedef struct {
+    const uint8_t*  data;
+    size_t          length;
+} byte_slice;
+RESULT_DECLARE(byte_slice)
+
 RESULT_DECLARE(int8_t)
 RESULT_DECLARE(int16_t)
 RESULT_DECLARE(int32_t)
@@ -382,7 +604,22 @@ RESULT_DECLARE(int)
 RESULT_DECLARE(short)
 RESULT_DECLARE(size_t)
 RESULT_DECLARE(ptrdiff_t)
+RESULT_DECLARE(long)
+typedef long long long_long;
+RESULT_DECLARE(long_long)
+typedef unsigned char unsigned_char;
+RESULT_DECLARE(unsigned_char)
+typedef unsigned short unsigned_short;
+RESULT_DECLARE(unsigned_short)
+typedef unsigned int unsigned_int;
+RESULT_DECLARE(unsigned_int)
+typedef unsigned long unsigned_long;
+RESULT_DECLARE(unsigned_long)
+typedef unsigned long long unsigned_long_long;
+RESULT_DECLARE(unsigned_long_long)
 RESULT_DECLARE(wchar_t)
+RESULT_DECLARE(float)
+RESULT_DECLARE(double)
 
 /* RESULT_DECLARE(void) */
 typedef struct {
@@ -396,6 +633,9 @@ Result(void) ___RESULT_void_declare_real(const Error* error,
                                          int src_line, char* src_file,
                                          const char* src_function);
 
+#define ___RESULT_void_declare(error, src_line, src_file, src_function, ...)    \
+    ___RESULT_void_declare_real(error, src_line, src_file, src_function)
+
 void ___RESULT_void_unwrap(int src_line, char* src_file,
                            const char* src_function, Result(void) self);
 
@@ -435,4 +675,11 @@ bool ___RESULT_void_is_err_and(Result(void) self, bool (*c)(const Error*));
 
 bool ___RESULT_void_is_ok_and(Result(void) self, bool (*c)(void));
 
+Result(void) ___RESULT_void_retry(const RetryPolicy* policy, RetryStats* stats,
+                                  Result(void) (*c)(void*), void* context);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
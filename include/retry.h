@@ -0,0 +1,89 @@
+/*
+    RETRY.H - Repeating calls that fail with retryable errors
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__RETRY___
+#define ___RESULT__RETRY___
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    A call is repeated as long as it fails with a Retryable error, and the
+    policy allows it. Retryable errors, that are not Transient, are repeated
+    right away. Transient errors are repeated after a wait, that starts with
+    spinning, then yields the cpu, then sleeps with an exponential backoff.
+*/
+typedef struct {
+    unsigned int    max_attempts;       /* 0 - unlimited */
+    uint64_t        deadline_ns;        /* 0 - no deadline */
+    unsigned int    spin_attempts;
+    unsigned int    yield_attempts;
+    uint64_t        initial_backoff_ns;
+    uint64_t        max_backoff_ns;
+    unsigned int    backoff_multiplier;
+    bool            jitter;
+} RetryPolicy;
+
+#define RETRY_POLICY_DEFAULT                                                    \
+    {                                                                           \
+        .max_attempts = 10,                                                     \
+        .deadline_ns = 0,                                                       \
+        .spin_attempts = 2,                                                     \
+        .yield_attempts = 2,                                                    \
+        .initial_backoff_ns = 1000000,                                          \
+        .max_backoff_ns = 1000000000,                                           \
+        .backoff_multiplier = 2,                                                \
+        .jitter = true,                                                         \
+    }
+
+/* The time from the first call to the end of the last one, and the sleeps */
+typedef struct {
+    unsigned int    attempts;
+    uint64_t        elapsed_ns;
+    uint64_t        slept_ns;
+} RetryStats;
+
+typedef struct {
+    unsigned int    attempts;
+    unsigned int    waits;
+    uint64_t        started_ns;
+    uint64_t        slept_ns;
+    uint64_t        backoff_ns;
+    uint64_t        seed;
+} ___RESULT_RETRY_STATE;
+
+void ___result_retry_begin(const RetryPolicy* policy,
+                           ___RESULT_RETRY_STATE* state);
+
+bool ___result_retry_again(const RetryPolicy* policy,
+                           ___RESULT_RETRY_STATE* state, const Error* error);
+
+void ___result_retry_end(const ___RESULT_RETRY_STATE* state,
+                         RetryStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
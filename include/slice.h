@@ -0,0 +1,237 @@
+/*
+    SLICE.H - Borrowed views of strings and bytes
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__SLICE___
+#define ___RESULT__SLICE___
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "result.h"
+
+ERROR_DECLARE(SliceOutOfBounds)
+
+/*
+    Slices point into memory owned by someone else, nothing here copies or
+    allocates. A slice is valid as long as the memory it points to, and it
+    doesn't have to end with a NUL (print it with STR_SLICE_FMT).
+*/
+#define STR_SLICE_FMT "%.*s"
+#define STR_SLICE_ARG(slice) (int) (slice).length, (slice).data
+
+static inline str_slice str_slice_from(const char* data, size_t length)
+{
+    return (str_slice) { .data = data, .length = length };
+}
+
+/* The only call that measures the string, keep the slice instead of strlen */
+static inline str_slice str_slice_from_cstr(const char* string)
+{
+    return (str_slice) { .data = string, .length = strlen(string) };
+}
+
+static inline byte_slice byte_slice_from(const void* data, size_t length)
+{
+    return (byte_slice) { .data = (const uint8_t*) data, .length = length };
+}
+
+static inline byte_slice str_slice_bytes(str_slice slice)
+{
+    return (byte_slice) {
+        .data = (const uint8_t*) slice.data,
+        .length = slice.length,
+    };
+}
+
+static inline str_slice byte_slice_str(byte_slice slice)
+{
+    return (str_slice) {
+        .data = (const char*) slice.data,
+        .length = slice.length,
+    };
+}
+
+/* NULL + 0 is undefined in C, so a slice over no memory keeps its NULL */
+static inline const char* ___slice_at(const char* data, size_t offset)
+{
+    return offset == 0 ? data : data + offset;
+}
+
+static inline bool ___slice_equal(const void* a, size_t a_length,
+                                  const void* b, size_t b_length)
+{
+    return a_length == b_length
+           && (a_length == 0 || memcmp(a, b, a_length) == 0);
+}
+
+static inline bool str_slice_equal(str_slice a, str_slice b)
+{
+    return ___slice_equal(a.data, a.length, b.data, b.length);
+}
+
+static inline bool byte_slice_equal(byte_slice a, byte_slice b)
+{
+    return ___slice_equal(a.data, a.length, b.data, b.length);
+}
+
+static inline bool str_slice_starts_with(str_slice slice, str_slice prefix)
+{
+    return prefix.length <= slice.length
+           && ___slice_equal(slice.data, prefix.length,
+                             prefix.data, prefix.length);
+}
+
+static inline bool str_slice_ends_with(str_slice slice, str_slice suffix)
+{
+    return suffix.length <= slice.length
+           && ___slice_equal(___slice_at(slice.data,
+                                         slice.length - suffix.length),
+                             suffix.length, suffix.data, suffix.length);
+}
+
+/* Index of the first c, or the length of the slice when there is none */
+static inline size_t str_slice_find(str_slice slice, char c)
+{
+    const char* found = slice.length == 0
+                        ? NULL : memchr(slice.data, c, slice.length);
+
+    return found == NULL ? slice.length : (size_t) (found - slice.data);
+}
+
+/* Drops the ASCII whitespace from both ends */
+static inline str_slice str_slice_trim(str_slice slice)
+{
+    while (slice.length != 0
+           && (slice.data[0] == ' ' || (slice.data[0] >= '\t'
+                                         && slice.data[0] <= '\r'))) {
+        slice.data++;
+        slice.length--;
+    }
+
+    while (slice.length != 0
+           && (slice.data[slice.length - 1] == ' '
+               || (slice.data[slice.length - 1] >= '\t'
+                   && slice.data[slice.length - 1] <= '\r')))
+        slice.length--;
+
+    return slice;
+}
+
+/*
+    Takes the next token, up to the delimiter, from the front of rest, and
+    returns false once rest is used up. Like strsep, empty tokens are kept, so
+    "a,,b" has three of them, and an empty text has a single empty one. The
+    last token leaves rest with a NULL data.
+*/
+static inline bool str_slice_split(str_slice* rest, char delimiter,
+                                   str_slice* token)
+{
+    if (rest->data == NULL) return false;
+
+    size_t end = str_slice_find(*rest, delimiter);
+    *token = str_slice_from(rest->data, end);
+
+    if (end == rest->length)
+        *rest = str_slice_from(NULL, 0);
+    else
+        *rest = str_slice_from(rest->data + end + 1, rest->length - end - 1);
+
+    return true;
+}
+
+/* Both the str and the byte slices share one layout, so they share the code */
+static inline Result(str_slice) ___slice_sub(int src_line, char* src_file,
+                                             const char* src_function,
+                                             str_slice slice, size_t start,
+                                             size_t end)
+{
+    if (___RESULT_UNLIKELY(start > end || end > slice.length))
+        return ___RESULT_str_slice_declare(ERR(SliceOutOfBounds), src_line,
+                                           src_file, src_function,
+                                           str_slice_from(NULL, 0));
+
+    return (Result(str_slice)) {
+        .value = str_slice_from(___slice_at(slice.data, start), end - start),
+        .error = NULL,
+        .src_file = src_file,
+        .src_line = src_line,
+        .src_function = src_function,
+    };
+}
+
+static inline Result(str_slice) ___slice_take(int src_line, char* src_file,
+                                              const char* src_function,
+                                              str_slice* rest, size_t length)
+{
+    Result(str_slice) taken = ___slice_sub(src_line, src_file, src_function,
+                                           *rest, 0, length);
+
+    if (___RESULT_LIKELY(taken.error == NULL))
+        *rest = str_slice_from(___slice_at(rest->data, length),
+                               rest->length - length);
+
+    return taken;
+}
+
+static inline Result(byte_slice) ___slice_as_bytes(Result(str_slice) self)
+{
+    return (Result(byte_slice)) {
+        .value = str_slice_bytes(self.value),
+        .error = self.error,
+        .src_file = self.src_file,
+        .src_line = self.src_line,
+        .src_function = self.src_function,
+    };
+}
+
+static inline Result(byte_slice) ___byte_slice_take(int src_line,
+                                                    char* src_file,
+                                                    const char* src_function,
+                                                    byte_slice* rest,
+                                                    size_t length)
+{
+    str_slice chars = byte_slice_str(*rest);
+    Result(str_slice) taken = ___slice_take(src_line, src_file, src_function,
+                                            &chars, length);
+
+    *rest = str_slice_bytes(chars);
+    return ___slice_as_bytes(taken);
+}
+
+/* The characters from start up to end, SliceOutOfBounds when they don't fit */
+#define str_slice_sub(slice, start, end)                                        \
+    ___slice_sub(__LINE__, __FILE__, __func__, slice, start, end)
+
+#define byte_slice_sub(slice, start, end)                                       \
+    ___slice_as_bytes(___slice_sub(__LINE__, __FILE__, __func__,                \
+                                   byte_slice_str(slice), start, end))
+
+/*
+    Takes the first length elements from the front of *rest, and moves rest
+    after them. A rest shorter than that gives SliceOutOfBounds, and is left
+    as it was.
+*/
+#define str_slice_take(rest, length)                                            \
+    ___slice_take(__LINE__, __FILE__, __func__, rest, length)
+
+#define byte_slice_take(rest, length)                                           \
+    ___byte_slice_take(__LINE__, __FILE__, __func__, rest, length)
+
+#endif
@@ -0,0 +1,48 @@
+/*
+    STATS.H - Error counters shared with other processes
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__STATS___
+#define ___RESULT__STATS___
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "result.h"
+#include "statsmap.h"
+
+#ifdef RESULT_SHARED_STATS
+
+/*
+    Maps the counters to shared memory, and starts counting every error
+    created by the process. A name (like "/worker.42") creates a POSIX
+    shared memory object, NULL an anonymous memfd (Linux only), that other
+    processes reach through /proc/<pid>/fd/<fd>. The result holds the file
+    descriptor of the mapping. Counting is a few atomic adds, without locks,
+    system calls or I/O.
+*/
+Result(int) result_stats_export(const char* name);
+
+/* Stops counting and removes the name, the mapping of the process stays */
+void result_stats_unexport(void);
+
+void ___result_stats_error(const Error* error);
+
+#endif
+
+#endif
@@ -0,0 +1,112 @@
+/*
+    STATSMAP.H - Layout of the shared error counters, and their reader
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__STATSMAP___
+#define ___RESULT__STATSMAP___
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "result.h"
+
+ERROR_DECLARE(StatsLayoutMismatch)
+ERROR_DECLARE(StatsNotFound)
+ERROR_DECLARE(StatsAccessDenied)
+ERROR_DECLARE(StatsUnavailable)
+
+/*
+    The layout of the shared mapping. Writers only add fields at the end and
+    bump the minor version, anything else changes the major version, that
+    readers have to match. Readers accept any minor version, and tell the
+    fields they can read by the size in the header. The header is filled
+    before the magic is stored, so a reader that sees the magic sees the rest
+    of it.
+
+    Every error is counted in its own slot (or as dropped) and in the slot of
+    its exit code, there is no total to keep the writers off one more shared
+    line, readers add the counts up.
+*/
+#define RESULT_STATS_MAGIC          0x5354415453534552u /* "RESSTATS" */
+#define RESULT_STATS_MAJOR          1
+#define RESULT_STATS_MINOR          0
+
+/* Distinct errors and exit codes counted, the ones after them are dropped */
+#define RESULT_STATS_ERRORS         1024
+#define RESULT_STATS_EXIT_CODES     64
+
+#define RESULT_STATS_MESSAGE_SIZE   104
+
+/* A slot is claimed by storing the key, and usable once ready is set */
+typedef struct {
+    _Atomic uint64_t    key;
+    _Atomic uint64_t    count;
+    _Atomic uint32_t    ready;
+    int32_t             exit_code;
+    char                message[RESULT_STATS_MESSAGE_SIZE];
+} ResultStatsError;
+
+typedef struct {
+    _Atomic uint64_t    key;                /* exit code + 1 << 32 */
+    _Atomic uint64_t    count;
+} ResultStatsExitCode;
+
+typedef struct {
+    _Atomic uint64_t    magic;
+    uint16_t            major;
+    uint16_t            minor;
+    uint32_t            size;
+    uint32_t            errors_size;
+    uint32_t            exit_codes_size;
+    int64_t             pid;
+    uint64_t            started_ns;         /* CLOCK_REALTIME */
+    _Atomic uint64_t    dropped;            /* errors without a slot */
+    ResultStatsError    errors[RESULT_STATS_ERRORS];
+    ResultStatsExitCode exit_codes[RESULT_STATS_EXIT_CODES];
+} ResultStatsMap;
+
+/* The end of the last field of version 1.0, the smallest map readers accept */
+#define RESULT_STATS_SIZE_1_0                                                   \
+    (offsetof(ResultStatsMap, exit_codes)                                       \
+     + RESULT_STATS_EXIT_CODES * sizeof(ResultStatsExitCode))
+
+typedef struct {
+    const ResultStatsMap*   map;
+    size_t                  size;
+} ResultStatsReader;
+
+/*
+    Maps the counters of another process read-only, by the name it exported
+    them with, or by a path (like /proc/<pid>/fd/<fd>). A map of another
+    major version, or smaller than the 1.0 layout, gives StatsLayoutMismatch.
+    A name that doesn't exist gives StatsNotFound, one that can't be read
+    StatsAccessDenied, and the other failures StatsUnavailable.
+
+    The reader is a library of its own, result-stats-reader, that doesn't
+    need libresult. Its results don't go through the error hooks.
+*/
+Result(void) result_stats_attach(ResultStatsReader* reader, const char* name);
+
+void result_stats_detach(ResultStatsReader* reader);
+
+/* Fields added after 1.0 exist only in the maps of writers that know them */
+#define result_stats_has(reader, field)                                         \
+    (offsetof(ResultStatsMap, field) + sizeof(((ResultStatsMap*) 0)->field)     \
+     <= (reader)->map->size)
+
+#endif
@@ -0,0 +1,42 @@
+/*
+    TRACE.H - Sampled tracing of error results
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__TRACE___
+#define ___RESULT__TRACE___
+
+#include "result.h"
+
+#ifdef RESULT_TRACING
+
+/* Number of records kept per thread, older records are overwritten */
+#define RESULT_TRACE_RING_SIZE 4096
+
+/* Records every rate-th error created by each thread, 0 stops the tracer */
+void result_trace_start(unsigned int rate);
+
+void result_trace_stop(void);
+
+/* Writes the records in the Chrome trace (and Perfetto) JSON format */
+Result(void) result_trace_dump(const char* path);
+
+void ___result_trace_error(const Error* error, int src_line,
+                           const char* src_file, const char* src_function);
+
+#endif
+
+#endif
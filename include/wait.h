@@ -0,0 +1,43 @@
+/*
+    WAIT.H - Blocking on atomic words
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__WAIT___
+#define ___RESULT__WAIT___
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Waits without a timeout */
+#define RESULT_WAIT_FOREVER UINT64_MAX
+
+/* The deadline timeout_ns from now, RESULT_WAIT_FOREVER stays as it is */
+uint64_t ___result_deadline(uint64_t timeout_ns);
+
+/*
+    Blocks while the word holds expected, until the deadline, and returns
+    false when it passed. It can return early, so callers check the word
+    again in a loop. Futexes on Linux, a shared condition variable elsewhere.
+*/
+bool ___result_wait(_Atomic uint32_t* word, uint32_t expected,
+                    uint64_t deadline_ns);
+
+/* Wakes all of the threads blocked on the word */
+void ___result_wake(_Atomic uint32_t* word);
+
+#endif
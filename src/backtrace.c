@@ -0,0 +1,258 @@
+/*
+    BACKTRACE.C - Raw backtraces of errors and panics
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <backtrace.h>
+#include <hooks.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <link.h>
+#include <unistd.h>
+#include <unwind.h>
+
+#ifndef NT_GNU_BUILD_ID
+#define NT_GNU_BUILD_ID 3
+#endif
+
+/* Build-ids are 20 bytes (sha1) in practice, longer ones are cut */
+#define ___RESULT_BUILD_ID_SIZE 32
+
+static _Thread_local ResultBacktrace ___result_backtrace_error_trace;
+static _Thread_local const Error* ___result_backtrace_error_value = NULL;
+static _Thread_local const Error* ___result_backtrace_panic_value = NULL;
+
+typedef struct {
+    ResultBacktrace*    backtrace;
+    unsigned int        skip;
+} ___RESULT_BACKTRACE_WALK;
+
+static _Unwind_Reason_Code ___result_backtrace_frame(
+    struct _Unwind_Context* context, void* argument)
+{
+    ___RESULT_BACKTRACE_WALK* walk = argument;
+    uintptr_t address = (uintptr_t) _Unwind_GetIP(context);
+
+    if (address == 0) return _URC_END_OF_STACK;
+
+    if (walk->skip > 0) {
+        walk->skip--;
+        return _URC_NO_REASON;
+    }
+
+    walk->backtrace->frames[walk->backtrace->count++] = (void*) address;
+
+    return walk->backtrace->count == RESULT_BACKTRACE_DEPTH
+           ? _URC_END_OF_STACK : _URC_NO_REASON;
+}
+
+/* Not inlined, so the frames to skip are the same everywhere */
+__attribute__((noinline))
+unsigned int result_backtrace_capture(ResultBacktrace* backtrace,
+                                      unsigned int skip)
+{
+    ___RESULT_BACKTRACE_WALK walk = {
+        .backtrace = backtrace,
+        .skip = skip + 1,
+    };
+
+    backtrace->count = 0;
+    _Unwind_Backtrace(&___result_backtrace_frame, &walk);
+
+    return backtrace->count;
+}
+
+typedef struct {
+    uintptr_t           address;
+    bool                found;
+    const char*         path;
+    uintptr_t           base;
+    unsigned char       build_id[___RESULT_BUILD_ID_SIZE];
+    size_t              build_id_size;
+} ___RESULT_BACKTRACE_MODULE;
+
+static void ___result_backtrace_build_id(const struct dl_phdr_info* info,
+                                         ___RESULT_BACKTRACE_MODULE* module)
+{
+    for (size_t i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr)* header = &info->dlpi_phdr[i];
+
+        if (header->p_type != PT_NOTE) continue;
+
+        const char* note = (const char*) (info->dlpi_addr + header->p_vaddr);
+        const char* end = note + header->p_memsz;
+
+        while (note + sizeof(ElfW(Nhdr)) <= end) {
+            const ElfW(Nhdr)* entry = (const ElfW(Nhdr)*) note;
+            const char* name = note + sizeof(*entry);
+            const char* description = name + ((entry->n_namesz + 3) & ~3u);
+
+            if (entry->n_type == NT_GNU_BUILD_ID && entry->n_namesz == 4
+                && memcmp(name, "GNU", 4) == 0) {
+                size_t size = entry->n_descsz < ___RESULT_BUILD_ID_SIZE
+                              ? entry->n_descsz : ___RESULT_BUILD_ID_SIZE;
+
+                memcpy(module->build_id, description, size);
+                module->build_id_size = size;
+                return;
+            }
+
+            note = description + ((entry->n_descsz + 3) & ~3u);
+        }
+    }
+}
+
+static int ___result_backtrace_module(struct dl_phdr_info* info, size_t size,
+                                      void* argument)
+{
+    ___RESULT_BACKTRACE_MODULE* module = argument;
+    (void) size;
+
+    for (size_t i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr)* header = &info->dlpi_phdr[i];
+        uintptr_t start = info->dlpi_addr + header->p_vaddr;
+
+        if (header->p_type != PT_LOAD || module->address < start
+            || module->address - start >= header->p_memsz)
+            continue;
+
+        module->found = true;
+        module->path = info->dlpi_name;
+        module->base = info->dlpi_addr;
+        ___result_backtrace_build_id(info, module);
+
+        return 1;
+    }
+
+    return 0;
+}
+
+void result_backtrace_print(FILE* file, const ResultBacktrace* backtrace)
+{
+    char executable[4096] = "";
+
+    for (unsigned int i = 0; i < backtrace->count; i++) {
+        ___RESULT_BACKTRACE_MODULE module = {
+            .address = (uintptr_t) backtrace->frames[i],
+        };
+
+        dl_iterate_phdr(&___result_backtrace_module, &module);
+
+        if (!module.found) {
+            fprintf(file, "    #%-2u 0x%016llx\n", i,
+                    (unsigned long long) module.address);
+            continue;
+        }
+
+        /* The executable has no name of its own */
+        if (module.path == NULL || module.path[0] == '\0') {
+            if (executable[0] == '\0') {
+                ssize_t length = readlink("/proc/self/exe", executable,
+                                          sizeof(executable) - 1);
+                executable[length > 0 ? length : 0] = '\0';
+            }
+
+            module.path = executable[0] ? executable : "?";
+        }
+
+        fprintf(file, "    #%-2u 0x%016llx %s+0x%llx", i,
+                (unsigned long long) module.address, module.path,
+                (unsigned long long) (module.address - module.base));
+
+        if (module.build_id_size != 0) {
+            fprintf(file, " (build-id ");
+            for (size_t j = 0; j < module.build_id_size; j++)
+                fprintf(file, "%02x", module.build_id[j]);
+            fputc(')', file);
+        }
+
+        fputc('\n', file);
+    }
+}
+
+void ___result_backtrace_error(const Error* error)
+{
+    /* Skips the hooks, the backtrace starts where the error was created */
+    result_backtrace_capture(&___result_backtrace_error_trace, 2);
+    ___result_backtrace_error_value = error;
+}
+
+void result_backtrace_start(void)
+{
+    __atomic_fetch_or(&___result_hooks, ___RESULT_HOOK_BACKTRACE,
+                      __ATOMIC_RELAXED);
+}
+
+void result_backtrace_stop(void)
+{
+    __atomic_fetch_and(&___result_hooks, ~___RESULT_HOOK_BACKTRACE,
+                       __ATOMIC_RELAXED);
+}
+
+const ResultBacktrace* result_backtrace_last_error(const Error** error)
+{
+    if (___result_backtrace_error_value == NULL) return NULL;
+
+    if (error != NULL) *error = ___result_backtrace_error_value;
+    return &___result_backtrace_error_trace;
+}
+
+void ___result_backtrace_panicking(const Error* error)
+{
+    ___result_backtrace_panic_value = error;
+}
+
+void ___result_backtrace_panic(FILE* file)
+{
+    const Error* panicking = ___result_backtrace_panic_value;
+    const Error* last = ___result_backtrace_error_value;
+    ResultBacktrace backtrace;
+
+    ___result_backtrace_panic_value = NULL;
+
+    /* Skips the panic function, the backtrace starts where it was called */
+    result_backtrace_capture(&backtrace, 2);
+
+    fprintf(file, "Backtrace of the panic:\n");
+    result_backtrace_print(file, &backtrace);
+
+    /*
+        Errors are shared, the same pointer only says the last error of the
+        thread is of the same error as the panic, not that it is its value
+    */
+    if (panicking != NULL && panicking != last)
+        fprintf(file, "The error of the panic %p (%s) is not the last error "
+                "of the thread, its backtrace is lost.\n",
+                (const void*) panicking, panicking->message);
+
+    if (last != NULL) {
+        fprintf(file, "Backtrace of the last error of the thread %p (%s)%s:\n",
+                (const void*) last, last->message,
+                panicking == last ? ", the same error as the panic" : "");
+        result_backtrace_print(file, &___result_backtrace_error_trace);
+    }
+
+    fprintf(file, "Symbolize with result-symbolize.\n");
+}
@@ -0,0 +1,78 @@
+/*
+    CHANNEL.C - Bounded queues of results between threads
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <channel.h>
+#include <ports/libc/errors.h>
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+ERROR_DEFINE(ChannelClosed, OtherErrorExitCode, "The channel was closed.")
+
+Result(void) ___result_channel_init(int src_line, char* src_file,
+                                    const char* src_function,
+                                    ___RESULT_CHANNEL* core, void** cells,
+                                    size_t cell_size, size_t capacity)
+{
+    size_t size = 2;
+
+    while (size < capacity && size < ___CHANNEL_CLOSED >> 1) size <<= 1;
+
+    if (size > SIZE_MAX / cell_size)
+        return ___CHANNEL_ERR(NotEnoughMemory);
+
+    char* memory = malloc(size * cell_size);
+    if (memory == NULL) return ___CHANNEL_ERR(NotEnoughMemory);
+
+    /* The sequence is the first field of a cell */
+    for (size_t i = 0; i < size; i++)
+        atomic_init((_Atomic size_t*) (memory + i * cell_size), i);
+
+    atomic_init(&core->tail, 0);
+    atomic_init(&core->head, 0);
+    atomic_init(&core->not_empty, 0);
+    atomic_init(&core->waiting_consumers, 0);
+    atomic_init(&core->not_full, 0);
+    atomic_init(&core->waiting_producers, 0);
+    core->mask = size - 1;
+
+    *cells = memory;
+    return ___CHANNEL_OK();
+}
+
+void ___result_channel_destroy(___RESULT_CHANNEL* core, void** cells)
+{
+    free(*cells);
+
+    *cells = NULL;
+    core->mask = 0;
+}
+
+void ___result_channel_close(___RESULT_CHANNEL* core)
+{
+    atomic_fetch_or_explicit(&core->tail, ___CHANNEL_CLOSED,
+                             memory_order_seq_cst);
+
+    /* Everyone blocked has to see the channel closed */
+    atomic_fetch_add_explicit(&core->not_empty, 1, memory_order_release);
+    ___result_wake(&core->not_empty);
+    atomic_fetch_add_explicit(&core->not_full, 1, memory_order_release);
+    ___result_wake(&core->not_full);
+}
@@ -0,0 +1,22 @@
+/*
+    CHECKED.C - Integer arithmetic and conversions checked for overflow
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <checked.h>
+#include <error.h>
+
+ERROR_DEFINE(IntegerOverflow, MathRelatedErrorExitCode, "The result of an integer operation could not be represented in its type.")
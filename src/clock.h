@@ -0,0 +1,95 @@
+/*
+    CLOCK.H - Monotonic clock and sleeping used internally by the library
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__CLOCK___
+#define ___RESULT__CLOCK___
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+
+#include <windows.h>
+
+static inline uint64_t ___result_clock_ns(void)
+{
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+
+    return (uint64_t) ((double) counter.QuadPart * 1e9 / (double) frequency.QuadPart);
+}
+
+static inline uint64_t ___result_coarse_clock_ns(void)
+{
+    return ___result_clock_ns();
+}
+
+static inline void ___result_sleep_ns(uint64_t ns)
+{
+    Sleep((DWORD) ((ns + 999999) / 1000000));
+}
+
+static inline void ___result_yield(void)
+{
+    SwitchToThread();
+}
+
+#else
+
+#include <time.h>
+#include <sched.h>
+
+static inline uint64_t ___result_clock_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+/* Ticks with the scheduler only, but costs a fraction, good enough for ages */
+static inline uint64_t ___result_coarse_clock_ns(void)
+{
+#if defined(CLOCK_MONOTONIC_COARSE)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+#else
+    return ___result_clock_ns();
+#endif
+}
+
+static inline void ___result_sleep_ns(uint64_t ns)
+{
+    struct timespec duration = {
+        .tv_sec = (time_t) (ns / 1000000000u),
+        .tv_nsec = (long) (ns % 1000000000u),
+    };
+
+    nanosleep(&duration, NULL);
+}
+
+static inline void ___result_yield(void)
+{
+    sched_yield();
+}
+
+#endif
+
+#endif
@@ -0,0 +1,64 @@
+/*
+    HOOKS.C - Observing errors as they are created
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <hooks.h>
+
+#ifdef RESULT_TRACING
+#include <trace.h>
+#endif
+
+#ifdef RESULT_SHARED_STATS
+#include <stats.h>
+#endif
+
+#ifdef RESULT_BACKTRACE
+#include <backtrace.h>
+#endif
+
+#include "usdt.h"
+
+unsigned int ___result_hooks = 0;
+
+void ___result_error_created(const Error* error, int src_line,
+                             const char* src_file, const char* src_function)
+{
+    unsigned int hooks = ___RESULT_LOAD_RELAXED(___result_hooks);
+
+#ifdef RESULT_TRACING
+    if (hooks & ___RESULT_HOOK_TRACE)
+        ___result_trace_error(error, src_line, src_file, src_function);
+#endif
+
+#ifdef RESULT_SHARED_STATS
+    if (hooks & ___RESULT_HOOK_STATS)
+        ___result_stats_error(error);
+#endif
+
+#ifdef RESULT_BACKTRACE
+    if (hooks & ___RESULT_HOOK_BACKTRACE)
+        ___result_backtrace_error(error);
+#endif
+
+    ___RESULT_USDT(error, error, error->message, error->exit_code, src_file,
+                   src_line, src_function);
+
+    (void) hooks;
+    (void) src_line;
+    (void) src_file;
+    (void) src_function;
+}
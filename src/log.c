@@ -0,0 +1,530 @@
+/*
+    LOG.C - Asynchronous binary logging of errors
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <log.h>
+#include <ports/ports.h>
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define ___RESULT_LOG_TSC
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+#include "clock.h"
+#include "logformat.h"
+
+typedef struct {
+    uint64_t        timestamp_ns;
+    const Error*    error;
+    const char*     src_file;
+    const char*     src_function;
+    int32_t         src_line;
+    uint32_t        count;
+    uint64_t        arguments[RESULT_LOG_MAX_ARGS];
+} ___RESULT_LOG_ENTRY;
+
+/*
+    A ring has a single producer, its thread, and a single consumer, the
+    writer. The producer keeps its own copy of the tail, so it only touches
+    the line of the consumer when the ring looks full.
+
+    The producer raises writing before it checks that the log runs, and
+    stop lowers running before it checks writing, so either the producer
+    sees the log stopped, or stop waits until its record is in the ring.
+*/
+typedef struct ___RESULT_LOG_RING {
+    struct ___RESULT_LOG_RING*  next;
+    atomic_bool                 in_use;
+    uint32_t                    thread_id;
+
+    _Alignas(64) _Atomic uint64_t head;
+    uint64_t                    cached_tail;
+    _Atomic uint64_t            dropped;
+    atomic_bool                 writing;
+
+    _Alignas(64) _Atomic uint64_t tail;
+    uint64_t                    reported;
+
+    ___RESULT_LOG_ENTRY         entries[RESULT_LOG_RING_SIZE];
+} ___RESULT_LOG_RING;
+
+static _Atomic(___RESULT_LOG_RING*) ___result_log_rings = NULL;
+static atomic_bool ___result_log_running = false;
+
+static _Thread_local ___RESULT_LOG_RING* ___result_log_ring = NULL;
+
+/*
+    Reading the clock costs more than the rest of a record, so with an
+    invariant TSC records take ticks, and the writer turns them into
+    nanoseconds, with the rate measured since the start of the log.
+*/
+static bool ___result_log_use_tsc = false;
+
+static inline uint64_t ___result_log_ticks(void)
+{
+#ifdef ___RESULT_LOG_TSC
+    if (___RESULT_LIKELY(___result_log_use_tsc)) return __rdtsc();
+#endif
+
+    return ___result_clock_ns();
+}
+
+static bool ___result_log_tsc_invariant(void)
+{
+#ifdef ___RESULT_LOG_TSC
+    unsigned int eax, ebx, ecx, edx;
+
+    if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+        return (edx >> 8) & 1;
+#endif
+
+    return false;
+}
+
+static pthread_key_t ___result_log_key;
+static pthread_once_t ___result_log_once = PTHREAD_ONCE_INIT;
+
+/* Used only by the writer, and by start and stop around it */
+static struct {
+    pthread_mutex_t     lock;
+    pthread_t           thread;
+    FILE*               file;
+    int                 c_err;
+    uint64_t*           seen;
+    size_t              seen_size;
+    size_t              seen_count;
+    uint64_t            start_ticks;
+    uint64_t            start_ns;
+    double              ns_per_tick;
+} ___result_log_writer = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static void ___result_log_release(void* ring)
+{
+    atomic_store_explicit(&((___RESULT_LOG_RING*) ring)->in_use, false,
+                          memory_order_release);
+}
+
+static void ___result_log_init_key(void)
+{
+    pthread_key_create(&___result_log_key, &___result_log_release);
+}
+
+static uint32_t ___result_log_current_thread(void)
+{
+#if defined(__linux__)
+    return (uint32_t) syscall(SYS_gettid);
+#else
+    return (uint32_t) (uintptr_t) pthread_self();
+#endif
+}
+
+static ___RESULT_LOG_RING* ___result_log_claim_ring(void)
+{
+    ___RESULT_LOG_RING* ring = atomic_load_explicit(&___result_log_rings,
+                                                    memory_order_acquire);
+
+    for (; ring != NULL; ring = ring->next) {
+        bool free = false;
+
+        if (atomic_compare_exchange_strong(&ring->in_use, &free, true)) break;
+    }
+
+    if (ring == NULL) {
+        ring = calloc(1, sizeof(*ring));
+        if (ring == NULL) return NULL;
+
+        atomic_init(&ring->in_use, true);
+        atomic_init(&ring->head, 0);
+        atomic_init(&ring->dropped, 0);
+        atomic_init(&ring->writing, false);
+        atomic_init(&ring->tail, 0);
+
+        ring->next = atomic_load_explicit(&___result_log_rings,
+                                          memory_order_relaxed);
+        while (!atomic_compare_exchange_weak(&___result_log_rings,
+                                             &ring->next, ring));
+    }
+
+    /* A reused ring continues where the previous thread stopped */
+    ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    ring->thread_id = ___result_log_current_thread();
+
+    pthread_once(&___result_log_once, &___result_log_init_key);
+    pthread_setspecific(___result_log_key, ring);
+
+    return ring;
+}
+
+static void ___result_log_write(const Error* error, char* src_file,
+                                int src_line, const char* src_function,
+                                const uint64_t* arguments, unsigned int count)
+{
+    if (!atomic_load_explicit(&___result_log_running, memory_order_acquire))
+        return;
+
+    ___RESULT_LOG_RING* ring = ___result_log_ring;
+    if (___RESULT_UNLIKELY(ring == NULL)) {
+        ring = ___result_log_ring = ___result_log_claim_ring();
+        if (ring == NULL) return;
+    }
+
+    atomic_store_explicit(&ring->writing, true, memory_order_seq_cst);
+
+    if (!atomic_load_explicit(&___result_log_running, memory_order_seq_cst)) {
+        atomic_store_explicit(&ring->writing, false, memory_order_release);
+        return;
+    }
+
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    if (___RESULT_UNLIKELY(head - ring->cached_tail >= RESULT_LOG_RING_SIZE)) {
+        ring->cached_tail = atomic_load_explicit(&ring->tail,
+                                                 memory_order_acquire);
+
+        if (head - ring->cached_tail >= RESULT_LOG_RING_SIZE) {
+            atomic_store_explicit(&ring->dropped,
+                                  atomic_load_explicit(&ring->dropped,
+                                                       memory_order_relaxed)
+                                  + 1,
+                                  memory_order_relaxed);
+            atomic_store_explicit(&ring->writing, false, memory_order_release);
+            return;
+        }
+    }
+
+    if (count > RESULT_LOG_MAX_ARGS) count = RESULT_LOG_MAX_ARGS;
+
+    ___RESULT_LOG_ENTRY* entry = &ring->entries[head % RESULT_LOG_RING_SIZE];
+
+    entry->timestamp_ns = ___result_log_ticks();
+    entry->error = error;
+    entry->src_file = src_file;
+    entry->src_function = src_function;
+    entry->src_line = src_line;
+    entry->count = count;
+    for (unsigned int i = 0; i < count; i++)
+        entry->arguments[i] = arguments[i];
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    atomic_store_explicit(&ring->writing, false, memory_order_release);
+}
+
+void ___result_log_origin(const void* origin, const uint64_t* arguments,
+                          unsigned int count)
+{
+    Result(void) self;
+    memcpy(&self, origin, sizeof(self));
+
+    if (___RESULT_LIKELY(self.error == NULL)) return;
+
+    ___result_log_write(self.error, self.src_file, self.src_line,
+                        self.src_function, arguments + 1, count);
+}
+
+void result_log_error(const Error* error)
+{
+    if (error == NULL) return;
+
+    ___result_log_write(error, NULL, 0, NULL, NULL, 0);
+}
+
+/* The writer */
+
+static void ___result_log_put(const void* data, size_t size)
+{
+    if (fwrite(data, 1, size, ___result_log_writer.file) != size
+        && ___result_log_writer.c_err == 0)
+        ___result_log_writer.c_err = errno ? errno : EIO;
+}
+
+static void ___result_log_put_tag(char tag)
+{
+    ___result_log_put(&tag, 1);
+}
+
+static void ___result_log_put_u32(uint32_t value)
+{
+    ___result_log_put(&value, sizeof(value));
+}
+
+static void ___result_log_put_u64(uint64_t value)
+{
+    ___result_log_put(&value, sizeof(value));
+}
+
+/* Adds the id to the set of the defined ones, false if it was there already */
+static bool ___result_log_define(uint64_t id)
+{
+    if (___result_log_writer.seen_count * 2 >= ___result_log_writer.seen_size) {
+        size_t size = ___result_log_writer.seen_size
+                      ? ___result_log_writer.seen_size * 2 : 256;
+        uint64_t* seen = calloc(size, sizeof(*seen));
+
+        /* Defining it again is harmless, the decoder keeps the last one */
+        if (seen == NULL) return true;
+
+        for (size_t i = 0; i < ___result_log_writer.seen_size; i++) {
+            uint64_t key = ___result_log_writer.seen[i];
+            if (key == 0) continue;
+
+            size_t slot = (key * 0x9e3779b97f4a7c15u) >> 32 & (size - 1);
+            while (seen[slot] != 0) slot = (slot + 1) & (size - 1);
+            seen[slot] = key;
+        }
+
+        free(___result_log_writer.seen);
+        ___result_log_writer.seen = seen;
+        ___result_log_writer.seen_size = size;
+    }
+
+    size_t mask = ___result_log_writer.seen_size - 1;
+    size_t slot = (id * 0x9e3779b97f4a7c15u) >> 32 & mask;
+
+    for (; ___result_log_writer.seen[slot] != 0; slot = (slot + 1) & mask)
+        if (___result_log_writer.seen[slot] == id) return false;
+
+    ___result_log_writer.seen[slot] = id;
+    ___result_log_writer.seen_count++;
+    return true;
+}
+
+static uint64_t ___result_log_string(const char* string)
+{
+    uint64_t id = (uint64_t) (uintptr_t) string;
+
+    if (string != NULL && ___result_log_define(id)) {
+        uint32_t length = (uint32_t) strlen(string);
+
+        ___result_log_put_tag(___RESULT_LOG_STRING);
+        ___result_log_put_u64(id);
+        ___result_log_put_u32(length);
+        ___result_log_put(string, length);
+    }
+
+    return id;
+}
+
+static uint64_t ___result_log_error(const Error* error)
+{
+    uint64_t id = (uint64_t) (uintptr_t) error;
+
+    if (___result_log_define(id)) {
+        uint32_t length = (uint32_t) strlen(error->message);
+
+        ___result_log_put_tag(___RESULT_LOG_ERROR);
+        ___result_log_put_u64(id);
+        ___result_log_put_u32((uint32_t) error->exit_code);
+        ___result_log_put_u32(length);
+        ___result_log_put(error->message, length);
+    }
+
+    return id;
+}
+
+static void ___result_log_calibrate(void)
+{
+    if (!___result_log_use_tsc) return;
+
+    uint64_t ticks = ___result_log_ticks();
+    uint64_t ns = ___result_clock_ns();
+
+    if (ticks > ___result_log_writer.start_ticks)
+        ___result_log_writer.ns_per_tick =
+            (double) (ns - ___result_log_writer.start_ns)
+            / (double) (ticks - ___result_log_writer.start_ticks);
+}
+
+static uint64_t ___result_log_ns(uint64_t ticks)
+{
+    if (!___result_log_use_tsc) return ticks;
+
+    int64_t elapsed = (int64_t) (ticks - ___result_log_writer.start_ticks);
+
+    return ___result_log_writer.start_ns
+           + (uint64_t) ((double) elapsed * ___result_log_writer.ns_per_tick);
+}
+
+static bool ___result_log_drain(void)
+{
+    bool wrote = false;
+
+    ___result_log_calibrate();
+
+    for (___RESULT_LOG_RING* ring = atomic_load(&___result_log_rings);
+         ring != NULL; ring = ring->next) {
+        uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+        for (; tail != head; tail++) {
+            const ___RESULT_LOG_ENTRY* entry =
+                &ring->entries[tail % RESULT_LOG_RING_SIZE];
+
+            uint64_t error = ___result_log_error(entry->error);
+            uint64_t file = ___result_log_string(entry->src_file);
+            uint64_t function = ___result_log_string(entry->src_function);
+
+            ___result_log_put_tag(___RESULT_LOG_RECORD);
+            ___result_log_put_u64(___result_log_ns(entry->timestamp_ns));
+            ___result_log_put_u64(error);
+            ___result_log_put_u64(file);
+            ___result_log_put_u64(function);
+            ___result_log_put_u32((uint32_t) entry->src_line);
+            ___result_log_put_u32(ring->thread_id);
+            ___result_log_put_u32(entry->count);
+            ___result_log_put(entry->arguments,
+                              entry->count * sizeof(entry->arguments[0]));
+            wrote = true;
+        }
+
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+
+        uint64_t dropped = atomic_load_explicit(&ring->dropped,
+                                                memory_order_relaxed);
+        if (dropped != ring->reported) {
+            ___result_log_put_tag(___RESULT_LOG_DROPPED);
+            ___result_log_put_u32(ring->thread_id);
+            ___result_log_put_u64(dropped - ring->reported);
+            ring->reported = dropped;
+            wrote = true;
+        }
+    }
+
+    return wrote;
+}
+
+static void* ___result_log_writer_thread(void* argument)
+{
+    (void) argument;
+
+    while (atomic_load_explicit(&___result_log_running, memory_order_acquire)) {
+        if (___result_log_drain()) fflush(___result_log_writer.file);
+
+        ___result_sleep_ns(1000000);
+    }
+
+    return NULL;
+}
+
+Result(void) result_log_start(const char* path)
+{
+    pthread_mutex_lock(&___result_log_writer.lock);
+
+    if (___result_log_writer.file != NULL) {
+        pthread_mutex_unlock(&___result_log_writer.lock);
+        return result_ERR(void, AlreadyInProgress);
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        int c_err = errno;
+
+        pthread_mutex_unlock(&___result_log_writer.lock);
+        return ___RESULT_ERR_RAW(void, ____result_bind_errno_to_error(c_err));
+    }
+
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+
+    ___result_log_writer.file = file;
+    ___result_log_writer.c_err = 0;
+    ___result_log_put(___RESULT_LOG_MAGIC, sizeof(___RESULT_LOG_MAGIC) - 1);
+
+    /* The ids are only valid in this log, so everything is defined again */
+    free(___result_log_writer.seen);
+    ___result_log_writer.seen = NULL;
+    ___result_log_writer.seen_size = 0;
+    ___result_log_writer.seen_count = 0;
+
+    /* Records of an earlier log are not carried over */
+    for (___RESULT_LOG_RING* ring = atomic_load(&___result_log_rings);
+         ring != NULL; ring = ring->next) {
+        atomic_store(&ring->tail, atomic_load(&ring->head));
+        ring->reported = atomic_load(&ring->dropped);
+    }
+
+    ___result_log_use_tsc = ___result_log_tsc_invariant();
+    ___result_log_writer.start_ticks = ___result_log_ticks();
+    ___result_log_writer.start_ns = ___result_clock_ns();
+
+    /* A first rate, refined on every drain as the log gets longer */
+    ___result_sleep_ns(1000000);
+    ___result_log_calibrate();
+
+    atomic_store(&___result_log_running, true);
+
+    int c_err = pthread_create(&___result_log_writer.thread, NULL,
+                               &___result_log_writer_thread, NULL);
+    if (c_err != 0) {
+        atomic_store(&___result_log_running, false);
+        fclose(file);
+        ___result_log_writer.file = NULL;
+
+        pthread_mutex_unlock(&___result_log_writer.lock);
+        return ___RESULT_ERR_RAW(void, ____result_bind_errno_to_error(c_err));
+    }
+
+    pthread_mutex_unlock(&___result_log_writer.lock);
+    return result_OK(void);
+}
+
+Result(void) result_log_stop(void)
+{
+    pthread_mutex_lock(&___result_log_writer.lock);
+
+    if (___result_log_writer.file == NULL) {
+        pthread_mutex_unlock(&___result_log_writer.lock);
+        return result_OK(void);
+    }
+
+    atomic_store(&___result_log_running, false);
+
+    /* Records that were being written when the log stopped still make it */
+    for (___RESULT_LOG_RING* ring = atomic_load(&___result_log_rings);
+         ring != NULL; ring = ring->next)
+        while (atomic_load(&ring->writing)) ___result_yield();
+
+    pthread_join(___result_log_writer.thread, NULL);
+    ___result_log_drain();
+
+    int c_err = ___result_log_writer.c_err;
+    if (fclose(___result_log_writer.file) != 0 && c_err == 0) c_err = errno;
+    ___result_log_writer.file = NULL;
+
+    pthread_mutex_unlock(&___result_log_writer.lock);
+
+    if (c_err != 0)
+        return ___RESULT_ERR_RAW(void, ____result_bind_errno_to_error(c_err));
+
+    return result_OK(void);
+}
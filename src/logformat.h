@@ -0,0 +1,41 @@
+/*
+    LOGFORMAT.H - The file format of the binary log
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__LOGFORMAT___
+#define ___RESULT__LOGFORMAT___
+
+/*
+    The log starts with the magic, followed by entries, each starting with
+    its tag. Numbers are in the byte order of the machine that wrote the log.
+    Errors and strings are defined once, before the first record using them,
+    and records refer to them by their id (0 for none).
+
+    ERROR       u64 id, i32 exit code, u32 length, message
+    STRING      u64 id, u32 length, bytes
+    RECORD      u64 timestamp ns, u64 error, u64 file, u64 function,
+                i32 line, u32 thread, u32 count, count * u64 arguments
+    DROPPED     u32 thread, u64 records dropped since the last DROPPED
+*/
+#define ___RESULT_LOG_MAGIC "RESLOG01"
+
+#define ___RESULT_LOG_ERROR     'E'
+#define ___RESULT_LOG_STRING    'S'
+#define ___RESULT_LOG_RECORD    'R'
+#define ___RESULT_LOG_DROPPED   'D'
+
+#endif
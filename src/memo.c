@@ -0,0 +1,398 @@
+/*
+    MEMO.C - Caching the results of fallible functions
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <memo.h>
+#include <compiler.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pthread.h>
+
+#include "clock.h"
+
+#define ___MEMO_NONE UINT32_MAX
+
+/* Caches get up to this many shards, and never more than capacity */
+#define ___MEMO_MAX_SHARDS 16
+
+/* The result of the entry follows it, at a multiple of the alignment */
+typedef struct {
+    uint64_t        hash;
+    uint64_t        expires_ns;
+    char*           key;
+    size_t          key_length;
+    uint32_t        next;
+    bool            error;
+    atomic_bool     referenced;
+} ___RESULT_MEMO_ENTRY;
+
+#define ___MEMO_ENTRY_SIZE                                                      \
+    ((sizeof(___RESULT_MEMO_ENTRY) + _Alignof(max_align_t) - 1)                 \
+     & ~(_Alignof(max_align_t) - 1))
+
+struct ___RESULT_MEMO_SHARD {
+    _Alignas(64) pthread_rwlock_t lock;
+    char*               entries;
+    uint32_t*           buckets;
+    size_t              stride;
+    uint32_t            mask;
+    uint32_t            capacity;
+    uint32_t            count;
+    uint32_t            hand;
+    _Atomic uint64_t    hits;
+    _Atomic uint64_t    error_hits;
+    _Atomic uint64_t    misses;
+    _Atomic uint64_t    expired;
+    uint64_t            evictions;
+};
+
+/* Eight bytes at a time, finished like splitmix64 */
+static uint64_t ___result_memo_hash(const char* data, size_t length)
+{
+    uint64_t hash = 0x9e3779b97f4a7c15u ^ length;
+
+    for (; length >= 8; data += 8, length -= 8) {
+        uint64_t word;
+        memcpy(&word, data, 8);
+        hash = (hash ^ word) * 0xbf58476d1ce4e5b9u;
+        hash ^= hash >> 29;
+    }
+
+    uint64_t tail = 0;
+    if (length != 0) memcpy(&tail, data, length);
+    hash = (hash ^ tail) * 0x94d049bb133111ebu;
+
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9u;
+    return hash ^ (hash >> 31);
+}
+
+static inline ___RESULT_MEMO_SHARD* ___result_memo_shard(___RESULT_MEMO* core,
+                                                         uint64_t hash)
+{
+    return &core->shards[(hash >> 32) & core->shard_mask];
+}
+
+static inline ___RESULT_MEMO_ENTRY* ___result_memo_entry(
+    ___RESULT_MEMO_SHARD* shard, uint32_t index)
+{
+    return (___RESULT_MEMO_ENTRY*) (shard->entries + index * shard->stride);
+}
+
+static uint32_t ___result_memo_find(___RESULT_MEMO_SHARD* shard, uint64_t hash,
+                                    str_slice key)
+{
+    uint32_t index = shard->buckets[hash & shard->mask];
+
+    while (index != ___MEMO_NONE) {
+        ___RESULT_MEMO_ENTRY* entry = ___result_memo_entry(shard, index);
+
+        if (entry->hash == hash && entry->key_length == key.length
+            && (key.length == 0
+                || memcmp(entry->key, key.data, key.length) == 0))
+            return index;
+
+        index = entry->next;
+    }
+
+    return ___MEMO_NONE;
+}
+
+static void ___result_memo_unlink(___RESULT_MEMO_SHARD* shard, uint32_t index)
+{
+    ___RESULT_MEMO_ENTRY* entry = ___result_memo_entry(shard, index);
+    uint32_t* link = &shard->buckets[entry->hash & shard->mask];
+
+    while (*link != index)
+        link = &___result_memo_entry(shard, *link)->next;
+
+    *link = entry->next;
+    free(entry->key);
+    entry->key = NULL;
+}
+
+Result(void) ___result_memo_init(int src_line, char* src_file,
+                                 const char* src_function, ___RESULT_MEMO* core,
+                                 size_t result_size, size_t capacity,
+                                 uint64_t ok_ttl_ns, uint64_t error_ttl_ns)
+{
+    size_t shards = 1;
+
+    while (shards < ___MEMO_MAX_SHARDS && shards * 2 <= capacity) shards <<= 1;
+
+    /* The first shards take the remainder, so they add up to capacity */
+    size_t per_shard = capacity / shards;
+    size_t remainder = capacity % shards;
+
+    if (capacity == 0 || per_shard + 1 >= ___MEMO_NONE)
+        return ___RESULT_void_declare(ERR(InvalidArgument), src_line, src_file,
+                                      src_function);
+
+    core->shards = calloc(shards, sizeof(*core->shards));
+    if (core->shards == NULL) goto out_of_memory;
+
+    core->shard_mask = shards - 1;
+    core->result_size = result_size;
+    core->ok_ttl_ns = ok_ttl_ns;
+    core->error_ttl_ns = error_ttl_ns;
+
+    for (size_t i = 0; i < shards; i++) {
+        ___RESULT_MEMO_SHARD* shard = &core->shards[i];
+        size_t entries = per_shard + (i < remainder);
+        size_t buckets = 1;
+
+        while (buckets < entries) buckets <<= 1;
+
+        shard->stride = ___MEMO_ENTRY_SIZE
+                        + ((result_size + _Alignof(max_align_t) - 1)
+                           & ~(_Alignof(max_align_t) - 1));
+        shard->capacity = (uint32_t) entries;
+        shard->mask = (uint32_t) (buckets - 1);
+        shard->entries = malloc(entries * shard->stride);
+        shard->buckets = malloc(buckets * sizeof(*shard->buckets));
+
+        if (shard->entries == NULL || shard->buckets == NULL) {
+            for (size_t j = 0; j <= i; j++) {
+                if (j < i) pthread_rwlock_destroy(&core->shards[j].lock);
+                free(core->shards[j].entries);
+                free(core->shards[j].buckets);
+            }
+
+            free(core->shards);
+            core->shards = NULL;
+            goto out_of_memory;
+        }
+
+        pthread_rwlock_init(&shard->lock, NULL);
+        memset(shard->buckets, 0xff, buckets * sizeof(*shard->buckets));
+    }
+
+    return (Result(void)) {
+        .error = NULL,
+        .src_file = src_file,
+        .src_line = src_line,
+        .src_function = src_function,
+    };
+
+out_of_memory:
+    return ___RESULT_void_declare(ERR(NotEnoughMemory), src_line, src_file,
+                                  src_function);
+}
+
+void ___result_memo_destroy(___RESULT_MEMO* core)
+{
+    if (core->shards == NULL) return;
+
+    ___result_memo_clear(core);
+
+    for (size_t i = 0; i <= core->shard_mask; i++) {
+        pthread_rwlock_destroy(&core->shards[i].lock);
+        free(core->shards[i].entries);
+        free(core->shards[i].buckets);
+    }
+
+    free(core->shards);
+    core->shards = NULL;
+}
+
+bool ___result_memo_lookup(___RESULT_MEMO* core, str_slice key, void* result)
+{
+    uint64_t hash = ___result_memo_hash(key.data, key.length);
+    ___RESULT_MEMO_SHARD* shard = ___result_memo_shard(core, hash);
+    bool hit = false;
+
+    pthread_rwlock_rdlock(&shard->lock);
+
+    uint32_t index = ___result_memo_find(shard, hash, key);
+    if (index != ___MEMO_NONE) {
+        ___RESULT_MEMO_ENTRY* entry = ___result_memo_entry(shard, index);
+
+        if (entry->expires_ns == MEMO_FOREVER
+            || ___result_coarse_clock_ns() < entry->expires_ns) {
+            memcpy(result, (char*) entry + ___MEMO_ENTRY_SIZE,
+                   core->result_size);
+
+            /* Only written when it's clear, readers don't share the line */
+            if (!atomic_load_explicit(&entry->referenced, memory_order_relaxed))
+                atomic_store_explicit(&entry->referenced, true,
+                                      memory_order_relaxed);
+
+            if (entry->error)
+                atomic_fetch_add_explicit(&shard->error_hits, 1,
+                                          memory_order_relaxed);
+            hit = true;
+        } else {
+            atomic_fetch_add_explicit(&shard->expired, 1, memory_order_relaxed);
+        }
+    }
+
+    pthread_rwlock_unlock(&shard->lock);
+
+    atomic_fetch_add_explicit(hit ? &shard->hits : &shard->misses, 1,
+                              memory_order_relaxed);
+    return hit;
+}
+
+/* Frees an entry, preferring the ones that ran out, then the unreferenced */
+static uint32_t ___result_memo_evict(___RESULT_MEMO_SHARD* shard, uint64_t now)
+{
+    for (;;) {
+        uint32_t index = shard->hand;
+        ___RESULT_MEMO_ENTRY* entry = ___result_memo_entry(shard, index);
+
+        shard->hand = index + 1 == shard->count ? 0 : index + 1;
+
+        if ((entry->expires_ns != MEMO_FOREVER && now >= entry->expires_ns)
+            || !atomic_exchange_explicit(&entry->referenced, false,
+                                         memory_order_relaxed)) {
+            ___result_memo_unlink(shard, index);
+            shard->evictions++;
+            return index;
+        }
+    }
+}
+
+void ___result_memo_store(___RESULT_MEMO* core, str_slice key,
+                          const void* result, const Error* error)
+{
+    uint64_t ttl_ns = error == NULL ? core->ok_ttl_ns : core->error_ttl_ns;
+
+    /* A transient error says nothing about the next call */
+    if (ttl_ns == 0 || (error != NULL && error_is_kind(error, Transient)))
+        return;
+
+    uint64_t hash = ___result_memo_hash(key.data, key.length);
+    ___RESULT_MEMO_SHARD* shard = ___result_memo_shard(core, hash);
+
+    char* copy = malloc(key.length ? key.length : 1);
+    if (copy == NULL) return;
+    if (key.length != 0) memcpy(copy, key.data, key.length);
+
+    uint64_t now = ___result_coarse_clock_ns();
+    uint64_t expires_ns = ttl_ns == MEMO_FOREVER || now > UINT64_MAX - ttl_ns
+                          ? MEMO_FOREVER : now + ttl_ns;
+
+    pthread_rwlock_wrlock(&shard->lock);
+
+    uint32_t index = ___result_memo_find(shard, hash, key);
+    ___RESULT_MEMO_ENTRY* entry;
+
+    if (index != ___MEMO_NONE) {
+        entry = ___result_memo_entry(shard, index);
+        free(entry->key);
+    } else {
+        index = shard->count < shard->capacity
+                ? shard->count++ : ___result_memo_evict(shard, now);
+
+        entry = ___result_memo_entry(shard, index);
+        entry->hash = hash;
+        entry->key_length = key.length;
+        entry->next = shard->buckets[hash & shard->mask];
+        shard->buckets[hash & shard->mask] = index;
+    }
+
+    entry->key = copy;
+    entry->expires_ns = expires_ns;
+    entry->error = error != NULL;
+    atomic_store_explicit(&entry->referenced, false, memory_order_relaxed);
+    memcpy((char*) entry + ___MEMO_ENTRY_SIZE, result, core->result_size);
+
+    pthread_rwlock_unlock(&shard->lock);
+}
+
+/* Moves the last entry into the hole, so the entries stay packed */
+static void ___result_memo_remove(___RESULT_MEMO_SHARD* shard, uint32_t index)
+{
+    uint32_t last = --shard->count;
+
+    ___result_memo_unlink(shard, index);
+
+    if (index != last) {
+        ___RESULT_MEMO_ENTRY* moved = ___result_memo_entry(shard, last);
+        uint32_t* link = &shard->buckets[moved->hash & shard->mask];
+
+        while (*link != last)
+            link = &___result_memo_entry(shard, *link)->next;
+        *link = index;
+
+        memcpy(___result_memo_entry(shard, index), moved, shard->stride);
+    }
+
+    if (shard->hand >= shard->count) shard->hand = 0;
+}
+
+void ___result_memo_invalidate(___RESULT_MEMO* core, str_slice key)
+{
+    uint64_t hash = ___result_memo_hash(key.data, key.length);
+    ___RESULT_MEMO_SHARD* shard = ___result_memo_shard(core, hash);
+
+    pthread_rwlock_wrlock(&shard->lock);
+
+    uint32_t index = ___result_memo_find(shard, hash, key);
+    if (index != ___MEMO_NONE) ___result_memo_remove(shard, index);
+
+    pthread_rwlock_unlock(&shard->lock);
+}
+
+void ___result_memo_clear(___RESULT_MEMO* core)
+{
+    for (size_t i = 0; i <= core->shard_mask; i++) {
+        ___RESULT_MEMO_SHARD* shard = &core->shards[i];
+
+        pthread_rwlock_wrlock(&shard->lock);
+
+        for (uint32_t j = 0; j < shard->count; j++)
+            free(___result_memo_entry(shard, j)->key);
+
+        memset(shard->buckets, 0xff,
+               ((size_t) shard->mask + 1) * sizeof(*shard->buckets));
+        shard->count = 0;
+        shard->hand = 0;
+
+        pthread_rwlock_unlock(&shard->lock);
+    }
+}
+
+MemoStats ___result_memo_stats(___RESULT_MEMO* core)
+{
+    MemoStats stats = { 0 };
+
+    for (size_t i = 0; i <= core->shard_mask; i++) {
+        ___RESULT_MEMO_SHARD* shard = &core->shards[i];
+
+        stats.hits += atomic_load_explicit(&shard->hits, memory_order_relaxed);
+        stats.error_hits += atomic_load_explicit(&shard->error_hits,
+                                                 memory_order_relaxed);
+        stats.misses += atomic_load_explicit(&shard->misses,
+                                             memory_order_relaxed);
+        stats.expired += atomic_load_explicit(&shard->expired,
+                                              memory_order_relaxed);
+
+        pthread_rwlock_rdlock(&shard->lock);
+        stats.evictions += shard->evictions;
+        stats.entries += shard->count;
+        pthread_rwlock_unlock(&shard->lock);
+    }
+
+    return stats;
+}
@@ -0,0 +1,187 @@
+/*
+    PACKED.C - Ids of the errors of packed results
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <packed.h>
+#include <hooks.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <pthread.h>
+
+#define ___PACKED_CHUNK_SIZE 4096
+#define ___PACKED_CHUNKS 1024
+#define ___PACKED_BUCKETS 4096
+#define ___PACKED_CACHE_SIZE 64
+
+/* Handed out once the origins can't be stored anymore */
+#define ___PACKED_LOST UINT32_MAX
+
+typedef struct {
+    Result(void)    origin;
+    uint32_t        next;
+} ___RESULT_PACKED_ENTRY;
+
+typedef struct {
+    const Error*    error;
+    const char*     src_file;
+    const char*     src_function;
+    int             src_line;
+    uint32_t        id;
+} ___RESULT_PACKED_CACHED;
+
+static const Result(void) ___result_packed_lost = {
+    .error = ERR(NotEnoughMemory),
+    .src_file = __FILE__,
+    .src_line = __LINE__,
+    .src_function = "___result_packed_intern",
+};
+
+/*
+    The origins are stored in chunks that never move, so they are read
+    without a lock. Interning takes the lock, but every thread remembers the
+    ids it got last, and locations that keep failing find theirs there.
+*/
+static _Atomic(___RESULT_PACKED_ENTRY*)
+    ___result_packed_chunks[___PACKED_CHUNKS];
+static uint32_t ___result_packed_buckets[___PACKED_BUCKETS];
+static uint32_t ___result_packed_count = 0;
+static pthread_mutex_t ___result_packed_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static _Thread_local ___RESULT_PACKED_CACHED
+    ___result_packed_cache[___PACKED_CACHE_SIZE];
+
+static uint64_t ___result_packed_hash(const Error* error, int src_line,
+                                      const char* src_file,
+                                      const char* src_function)
+{
+    uint64_t hash = (uint64_t) (uintptr_t) error * 0x9e3779b97f4a7c15u;
+
+    hash ^= ((uint64_t) (uintptr_t) src_file + (uint64_t) src_line)
+            * 0xbf58476d1ce4e5b9u;
+    hash ^= (uint64_t) (uintptr_t) src_function * 0x94d049bb133111ebu;
+
+    return hash ^ (hash >> 29);
+}
+
+static ___RESULT_PACKED_ENTRY* ___result_packed_entry(uint32_t id)
+{
+    ___RESULT_PACKED_ENTRY* chunk = atomic_load_explicit(
+        &___result_packed_chunks[(id - 1) / ___PACKED_CHUNK_SIZE],
+        memory_order_acquire);
+
+    return &chunk[(id - 1) % ___PACKED_CHUNK_SIZE];
+}
+
+static uint32_t ___result_packed_insert(uint32_t* bucket, const Error* error,
+                                        int src_line, char* src_file,
+                                        const char* src_function)
+{
+    uint32_t index = ___result_packed_count;
+
+    if (index >= ___PACKED_CHUNKS * ___PACKED_CHUNK_SIZE) return ___PACKED_LOST;
+
+    _Atomic(___RESULT_PACKED_ENTRY*)* slot =
+        &___result_packed_chunks[index / ___PACKED_CHUNK_SIZE];
+    ___RESULT_PACKED_ENTRY* chunk = atomic_load_explicit(slot,
+                                                         memory_order_relaxed);
+
+    if (chunk == NULL) {
+        chunk = calloc(___PACKED_CHUNK_SIZE, sizeof(*chunk));
+        if (chunk == NULL) return ___PACKED_LOST;
+
+        atomic_store_explicit(slot, chunk, memory_order_release);
+    }
+
+    ___RESULT_PACKED_ENTRY* entry = &chunk[index % ___PACKED_CHUNK_SIZE];
+
+    entry->origin.error = error;
+    entry->origin.src_file = src_file;
+    entry->origin.src_line = src_line;
+    entry->origin.src_function = src_function;
+    entry->next = *bucket;
+
+    ___result_packed_count = index + 1;
+    *bucket = index + 1;
+
+    return index + 1;
+}
+
+uint32_t ___result_packed_intern(const Error* error, int src_line,
+                                 char* src_file, const char* src_function)
+{
+    uint64_t hash = ___result_packed_hash(error, src_line, src_file,
+                                          src_function);
+    ___RESULT_PACKED_CACHED* cached =
+        &___result_packed_cache[hash % ___PACKED_CACHE_SIZE];
+
+    if (cached->id != 0 && cached->error == error
+        && cached->src_line == src_line && cached->src_file == src_file
+        && cached->src_function == src_function)
+        return cached->id;
+
+    pthread_mutex_lock(&___result_packed_lock);
+
+    uint32_t* bucket = &___result_packed_buckets[(hash >> 32)
+                                                 % ___PACKED_BUCKETS];
+    uint32_t id = *bucket;
+
+    for (; id != 0; id = ___result_packed_entry(id)->next) {
+        const Result(void)* origin = &___result_packed_entry(id)->origin;
+
+        if (origin->error == error && origin->src_line == src_line
+            && origin->src_file == src_file
+            && origin->src_function == src_function)
+            break;
+    }
+
+    if (id == 0)
+        id = ___result_packed_insert(bucket, error, src_line, src_file,
+                                     src_function);
+
+    pthread_mutex_unlock(&___result_packed_lock);
+
+    if (id != ___PACKED_LOST)
+        *cached = (___RESULT_PACKED_CACHED) {
+            .error = error,
+            .src_file = src_file,
+            .src_function = src_function,
+            .src_line = src_line,
+            .id = id,
+        };
+
+    return id;
+}
+
+uint32_t ___result_packed_error(const Error* error, int src_line,
+                                char* src_file, const char* src_function)
+{
+    ___RESULT_ERROR_HOOK(error, src_line, src_file, src_function);
+
+    return ___result_packed_intern(error, src_line, src_file, src_function);
+}
+
+const Result(void)* ___result_packed_origin(uint32_t id)
+{
+    if (___RESULT_UNLIKELY(id == ___PACKED_LOST)) return &___result_packed_lost;
+
+    return &___result_packed_entry(id)->origin;
+}
@@ -16,24 +16,84 @@
     limitations under the License.
 */
 
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <panic.h>
+#include <catch.h>
+
+#ifdef RESULT_BACKTRACE
+#include <backtrace.h>
+#endif
 
+#include <setjmp.h>
 #include <stdbool.h>
+#include <string.h>
+
+#include "usdt.h"
 
-PanicFunction panic_function = &PANIC_FUNCTION;
+PanicFunction panic_function = &___default_panic;
 bool panic_exit_on_panic = true;
 
+ERROR_DEFINE(Panicked,              OtherErrorExitCode,             "The call panicked.")
+
+/*
+    The signal mask is not saved, panics don't change it, and saving it would
+    cost a system call on every boundary.
+*/
+#if defined(_WIN32)
+typedef jmp_buf ___RESULT_PANIC_JUMP;
+#define ___RESULT_PANIC_SETJMP(jump) setjmp(jump)
+#define ___RESULT_PANIC_LONGJMP(jump) longjmp(jump, 1)
+#else
+typedef sigjmp_buf ___RESULT_PANIC_JUMP;
+#define ___RESULT_PANIC_SETJMP(jump) sigsetjmp(jump, 0)
+#define ___RESULT_PANIC_LONGJMP(jump) siglongjmp(jump, 1)
+#endif
+
+typedef struct ___RESULT_PANIC_BOUNDARY {
+    ___RESULT_PANIC_JUMP                jump;
+    struct ___RESULT_PANIC_BOUNDARY*    previous;
+    PanicRecord*                        record;
+} ___RESULT_PANIC_BOUNDARY;
+
+typedef struct {
+    int         exit_code;
+    int         src_line;
+    const char* src_file;
+    const char* src_function;
+    char        message[RESULT_PANIC_MESSAGE_SIZE];
+} ___RESULT_PANIC_CAUGHT;
+
+static _Thread_local ___RESULT_PANIC_BOUNDARY* ___result_panic_boundary = NULL;
+static _Thread_local ___RESULT_PANIC_CAUGHT ___result_panic_caught;
+
 void panic_set_panic_function(PanicFunction new)
 {
-    if (new == NULL) panic("Api abuse on panic_set_panic_function (new == NULL).");
+    if (new == NULL) panicf(6, "Api abuse on panic_set_panic_function (new == NULL).");
     panic_function = new;
 }
 
-void ___default_panic(RESULT_PANIC_FUNCTION_PARAMTETERS)
+/* Records the panic for the innermost boundary, before jumping back to it */
+static void ___result_panic_record(int src_line, const char* src_file,
+                                   const char* src_function, int exit_code,
+                                   const char* message, va_list arguments)
 {
-    va_list arguments;
-    va_start(arguments, message);
+    ___RESULT_PANIC_CAUGHT* caught = &___result_panic_caught;
 
+    vsnprintf(caught->message, sizeof(caught->message), message, arguments);
+
+    caught->exit_code = exit_code;
+    caught->src_line = src_line;
+    caught->src_file = src_file;
+    caught->src_function = src_function;
+}
+
+static void ___default_vpanic(int src_line, const char* src_file,
+                              const char* src_function, int exit_code,
+                              const char* message, va_list arguments)
+{
     fprintf(stderr, "The program panicked with a following message: \"");
     vfprintf(stderr, message, arguments);
     fprintf(stderr, 
@@ -43,7 +103,140 @@ void ___default_panic(RESULT_PANIC_FUNCTION_PARAMTETERS)
             src_function
         );
 
+#ifdef RESULT_BACKTRACE
+    ___result_backtrace_panic(stderr);
+    fputc('\n', stderr);
+#endif
+
     fprintf(stderr, "The program %s with exit code %d.\n", panic_exit_on_panic ? "exited" : "\"exited\"", exit_code);
-    va_end(arguments);
     if (panic_exit_on_panic) exit(exit_code);
 }
+
+void ___default_panic(RESULT_PANIC_FUNCTION_PARAMTETERS)
+{
+    va_list arguments;
+    va_start(arguments, message);
+
+    if (___result_panic_boundary != NULL) {
+        ___result_panic_record(src_line, src_file, src_function, exit_code,
+                               message, arguments);
+        va_end(arguments);
+        ___RESULT_PANIC_LONGJMP(___result_panic_boundary->jump);
+    }
+
+    ___default_vpanic(src_line, src_file, src_function, exit_code, message,
+                      arguments);
+
+    va_end(arguments);
+}
+
+/*
+    Every panic of panicf and of the result methods comes here, so the
+    boundaries catch it whatever the panic function is. Custom panic functions
+    get the message already formatted.
+*/
+void ___result_panic(PanicFunction function, RESULT_PANIC_FUNCTION_PARAMTETERS)
+{
+    va_list arguments;
+    va_start(arguments, message);
+
+    if (___RESULT_USDT_ENABLED(panic)) {
+        char text[RESULT_PANIC_MESSAGE_SIZE];
+        va_list copy;
+
+        va_copy(copy, arguments);
+        vsnprintf(text, sizeof(text), message, copy);
+        va_end(copy);
+
+        ___RESULT_USDT(panic, exit_code, text, src_file, src_line,
+                       src_function);
+    }
+
+    if (___result_panic_boundary != NULL) {
+#ifdef RESULT_BACKTRACE
+        ___result_backtrace_panicking(NULL);
+#endif
+        ___result_panic_record(src_line, src_file, src_function, exit_code,
+                               message, arguments);
+        va_end(arguments);
+        ___RESULT_PANIC_LONGJMP(___result_panic_boundary->jump);
+    }
+
+    if (function == &___default_panic) {
+        ___default_vpanic(src_line, src_file, src_function, exit_code, message,
+                          arguments);
+        va_end(arguments);
+        return;
+    }
+
+    char buffer[RESULT_PANIC_MESSAGE_SIZE];
+    va_list copy;
+
+    va_copy(copy, arguments);
+    int length = vsnprintf(buffer, sizeof(buffer), message, copy);
+    va_end(copy);
+
+    char* text = buffer;
+    if (length >= (int) sizeof(buffer)) {
+        char* allocated = malloc((size_t) length + 1);
+
+        if (allocated != NULL) {
+            vsnprintf(allocated, (size_t) length + 1, message, arguments);
+            text = allocated;
+        }
+    }
+
+    va_end(arguments);
+
+#ifdef RESULT_BACKTRACE
+    /* Only the default panic function prints the backtraces */
+    ___result_backtrace_panicking(NULL);
+#endif
+
+    function(src_line, src_file, src_function, exit_code, "%s", text);
+
+    if (text != buffer) free(text);
+}
+
+Result(void) result_catch_panic_record(Result(void) (*call)(void*),
+                                       void* context, PanicRecord* record)
+{
+    ___RESULT_PANIC_BOUNDARY boundary;
+    boundary.previous = ___result_panic_boundary;
+    boundary.record = record;
+
+    if (___RESULT_PANIC_SETJMP(boundary.jump) != 0) {
+        ___RESULT_PANIC_CAUGHT* caught = &___result_panic_caught;
+
+        ___result_panic_boundary = boundary.previous;
+
+        if (boundary.record != NULL) {
+            boundary.record->exit_code = caught->exit_code;
+            memcpy(boundary.record->message, caught->message,
+                   sizeof(boundary.record->message));
+        }
+
+        return ___RESULT_void_declare(ERR(Panicked), caught->src_line,
+                                      (char*) caught->src_file,
+                                      caught->src_function);
+    }
+
+    ___result_panic_boundary = &boundary;
+    Result(void) result = call(context);
+    ___result_panic_boundary = boundary.previous;
+
+    return result;
+}
+
+Result(void) result_catch_panic(Result(void) (*call)(void*), void* context)
+{
+    return result_catch_panic_record(call, context, NULL);
+}
+
+PanicInfo result_last_panic(void)
+{
+    return (PanicInfo) {
+        .exit_code = ___result_panic_caught.exit_code,
+        .message = ___result_panic_caught.message,
+    };
+}
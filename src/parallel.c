@@ -0,0 +1,382 @@
+/*
+    PARALLEL.C - Fallible maps over arrays on a thread pool
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <parallel.h>
+#include <catch.h>
+#include <compiler.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+/* Every participant starts with this many chunks */
+#define ___RESULT_PAR_CHUNKS_PER_THREAD 16
+
+/*
+    The chunks a participant has left, as begin << 32 | end. The owner takes
+    chunks from the front, thieves take the back half, both with a CAS.
+*/
+typedef struct {
+    _Alignas(64) _Atomic uint64_t range;
+} ___RESULT_PAR_SLOT;
+
+typedef struct ___RESULT_PAR_JOB {
+    ___RESULT_PAR_CHUNK     chunk;
+    void*                   context;
+    size_t                  count;
+    size_t                  chunk_size;
+    unsigned int            participants;
+
+    /* Under the lock of the pool */
+    struct ___RESULT_PAR_JOB*   next;
+    unsigned int            joined;     /* participants so far, the caller too */
+    unsigned int            working;    /* pool threads inside of the job */
+    bool                    queued;
+
+    /* Lowest failed index, SIZE_MAX while nothing failed */
+    _Alignas(64) _Atomic size_t failed;
+    pthread_mutex_t         failure_lock;
+    ___RESULT_PAR_FAILURE   failure;
+    bool                    panicked;
+    PanicRecord             panic;
+
+    ___RESULT_PAR_SLOT      slots[RESULT_PAR_MAX_THREADS];
+} ___RESULT_PAR_JOB;
+
+/*
+    Every caller queues a job of its own. Idle threads join the first queued
+    job, which leaves the queue once all of its participants joined, or once
+    one of them ran out of work.
+*/
+static struct {
+    pthread_once_t      once;
+    pthread_mutex_t     lock;
+    pthread_cond_t      wake;
+    pthread_cond_t      done;
+    unsigned int        threads;
+    ___RESULT_PAR_JOB*  first;
+    ___RESULT_PAR_JOB*  last;
+} ___result_par_pool = {
+    .once = PTHREAD_ONCE_INIT,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+    .threads = 1,
+};
+
+static _Thread_local bool ___result_par_worker = false;
+
+#define ___RESULT_PAR_RANGE(begin, end) (((uint64_t) (begin) << 32) | (end))
+#define ___RESULT_PAR_BEGIN(range) ((uint32_t) ((range) >> 32))
+#define ___RESULT_PAR_END(range) ((uint32_t) (range))
+
+static void ___result_par_fail(___RESULT_PAR_JOB* job,
+                               const ___RESULT_PAR_FAILURE* failure,
+                               const PanicRecord* panic)
+{
+    pthread_mutex_lock(&job->failure_lock);
+
+    if (failure->index < atomic_load_explicit(&job->failed,
+                                              memory_order_relaxed)) {
+        job->failure = *failure;
+        job->panicked = panic != NULL;
+        if (panic != NULL) job->panic = *panic;
+
+        atomic_store_explicit(&job->failed, failure->index,
+                              memory_order_relaxed);
+    }
+
+    pthread_mutex_unlock(&job->failure_lock);
+}
+
+typedef struct {
+    ___RESULT_PAR_JOB*  job;
+    size_t              begin;
+    size_t              end;
+} ___RESULT_PAR_CALL;
+
+static Result(void) ___result_par_call(void* argument)
+{
+    ___RESULT_PAR_CALL* call = argument;
+    ___RESULT_PAR_FAILURE failure;
+
+    if (___RESULT_UNLIKELY(!call->job->chunk(call->job->context, call->begin,
+                                             call->end, &failure)))
+        ___result_par_fail(call->job, &failure, NULL);
+
+    return result_OK();
+}
+
+/*
+    Chunks run behind a panic boundary, so a panic can't jump out of the job
+    and leave it running. It fails the job at the first index of its chunk,
+    and the caller panics again once the job is over.
+*/
+static void ___result_par_run_chunk(___RESULT_PAR_JOB* job, uint32_t chunk)
+{
+    size_t begin = (size_t) chunk * job->chunk_size;
+    size_t end = begin + job->chunk_size;
+
+    if (end > job->count) end = job->count;
+
+    /* Cancelled, a lower index already failed */
+    if (begin > atomic_load_explicit(&job->failed, memory_order_relaxed))
+        return;
+
+    ___RESULT_PAR_CALL call = { .job = job, .begin = begin, .end = end };
+    PanicRecord panic;
+    Result(void) called = result_catch_panic_record(&___result_par_call, &call,
+                                                    &panic);
+
+    if (___RESULT_UNLIKELY(called.error != NULL)) {
+        ___RESULT_PAR_FAILURE failure = {
+            .index = begin,
+            .error = called.error,
+            .src_file = called.src_file,
+            .src_line = called.src_line,
+            .src_function = called.src_function,
+        };
+
+        ___result_par_fail(job, &failure, &panic);
+    }
+}
+
+static bool ___result_par_take(_Atomic uint64_t* slot, uint32_t* chunk)
+{
+    uint64_t range = atomic_load_explicit(slot, memory_order_relaxed);
+
+    do {
+        uint32_t begin = ___RESULT_PAR_BEGIN(range);
+        uint32_t end = ___RESULT_PAR_END(range);
+
+        if (begin >= end) return false;
+
+        *chunk = begin;
+    } while (!atomic_compare_exchange_weak_explicit(
+                 slot, &range, ___RESULT_PAR_RANGE(*chunk + 1,
+                                                   ___RESULT_PAR_END(range)),
+                 memory_order_acq_rel, memory_order_relaxed));
+
+    return true;
+}
+
+static bool ___result_par_steal(___RESULT_PAR_JOB* job, unsigned int thief)
+{
+    for (unsigned int i = 1; i < job->participants; i++) {
+        _Atomic uint64_t* victim = &job->slots[(thief + i) % job->participants].range;
+        uint64_t range = atomic_load_explicit(victim, memory_order_relaxed);
+
+        for (;;) {
+            uint32_t begin = ___RESULT_PAR_BEGIN(range);
+            uint32_t end = ___RESULT_PAR_END(range);
+
+            if (begin >= end) break;
+
+            uint32_t middle = end - (end - begin + 1) / 2;
+
+            if (atomic_compare_exchange_weak_explicit(
+                    victim, &range, ___RESULT_PAR_RANGE(begin, middle),
+                    memory_order_acq_rel, memory_order_relaxed)) {
+                /* Nobody steals from an empty slot, so a store is enough */
+                atomic_store_explicit(&job->slots[thief].range,
+                                      ___RESULT_PAR_RANGE(middle, end),
+                                      memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+static void ___result_par_work(___RESULT_PAR_JOB* job, unsigned int id)
+{
+    do {
+        uint32_t chunk;
+
+        while (___result_par_take(&job->slots[id].range, &chunk))
+            ___result_par_run_chunk(job, chunk);
+    } while (___result_par_steal(job, id));
+}
+
+/* Under the lock of the pool */
+static void ___result_par_dequeue(___RESULT_PAR_JOB* job)
+{
+    if (!job->queued) return;
+
+    ___RESULT_PAR_JOB** link = &___result_par_pool.first;
+    ___RESULT_PAR_JOB* previous = NULL;
+
+    while (*link != job) {
+        previous = *link;
+        link = &(*link)->next;
+    }
+
+    *link = job->next;
+    if (___result_par_pool.last == job) ___result_par_pool.last = previous;
+    job->queued = false;
+}
+
+static void* ___result_par_thread(void* argument)
+{
+    (void) argument;
+
+    ___result_par_worker = true;
+
+    pthread_mutex_lock(&___result_par_pool.lock);
+    for (;;) {
+        while (___result_par_pool.first == NULL)
+            pthread_cond_wait(&___result_par_pool.wake,
+                              &___result_par_pool.lock);
+
+        ___RESULT_PAR_JOB* job = ___result_par_pool.first;
+        unsigned int id = job->joined++;
+
+        if (job->joined == job->participants) ___result_par_dequeue(job);
+        job->working++;
+        pthread_mutex_unlock(&___result_par_pool.lock);
+
+        ___result_par_work(job, id);
+
+        /* Nothing is left to take or steal, later threads would only look */
+        pthread_mutex_lock(&___result_par_pool.lock);
+        ___result_par_dequeue(job);
+        if (--job->working == 0)
+            pthread_cond_broadcast(&___result_par_pool.done);
+    }
+
+    return NULL;
+}
+
+static void ___result_par_start(void)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (cpus < 1) cpus = 1;
+    if (cpus > RESULT_PAR_MAX_THREADS) cpus = RESULT_PAR_MAX_THREADS;
+
+    unsigned int threads = 1;
+    pthread_attr_t attributes;
+
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+
+    /* The pool works with whatever number of threads could be started */
+    for (; threads < (unsigned int) cpus; threads++) {
+        pthread_t thread;
+
+        if (pthread_create(&thread, &attributes, &___result_par_thread, NULL)
+            != 0)
+            break;
+    }
+
+    pthread_attr_destroy(&attributes);
+    ___result_par_pool.threads = threads;
+}
+
+unsigned int result_par_threads(void)
+{
+    pthread_once(&___result_par_pool.once, &___result_par_start);
+    return ___result_par_pool.threads;
+}
+
+Result(size_t) ___result_par_run(int src_line, char* src_file,
+                                 const char* src_function,
+                                 ___RESULT_PAR_CHUNK chunk, void* context,
+                                 size_t count)
+{
+    unsigned int threads = result_par_threads();
+    ___RESULT_PAR_FAILURE failure;
+
+    if (count < 2 || threads == 1 || ___result_par_worker) {
+        if (___RESULT_UNLIKELY(!chunk(context, 0, count, &failure)))
+            return ___RESULT_size_t_declare(failure.error, failure.src_line,
+                                            failure.src_file,
+                                            failure.src_function,
+                                            failure.index);
+
+        return ___RESULT_size_t_declare(NULL, src_line, src_file, src_function,
+                                        count);
+    }
+
+    ___RESULT_PAR_JOB job;
+
+    size_t chunks = (size_t) threads * ___RESULT_PAR_CHUNKS_PER_THREAD;
+    if (chunks > count) chunks = count;
+
+    job.chunk = chunk;
+    job.context = context;
+    job.count = count;
+    job.chunk_size = (count + chunks - 1) / chunks;
+    job.participants = threads;
+    job.next = NULL;
+    job.joined = 1;
+    job.working = 0;
+    job.queued = true;
+    job.failed = SIZE_MAX;
+    job.panicked = false;
+    pthread_mutex_init(&job.failure_lock, NULL);
+
+    /* Recount, the rounding up can leave fewer chunks */
+    chunks = (count + job.chunk_size - 1) / job.chunk_size;
+
+    for (unsigned int i = 0; i < threads; i++)
+        atomic_store_explicit(&job.slots[i].range,
+                              ___RESULT_PAR_RANGE(chunks * i / threads,
+                                                  chunks * (i + 1) / threads),
+                              memory_order_relaxed);
+
+    pthread_mutex_lock(&___result_par_pool.lock);
+    if (___result_par_pool.last != NULL) ___result_par_pool.last->next = &job;
+    else ___result_par_pool.first = &job;
+    ___result_par_pool.last = &job;
+    pthread_cond_broadcast(&___result_par_pool.wake);
+    pthread_mutex_unlock(&___result_par_pool.lock);
+
+    ___result_par_worker = true;
+    ___result_par_work(&job, 0);
+    ___result_par_worker = false;
+
+    pthread_mutex_lock(&___result_par_pool.lock);
+    ___result_par_dequeue(&job);
+    while (job.working != 0)
+        pthread_cond_wait(&___result_par_pool.done, &___result_par_pool.lock);
+    pthread_mutex_unlock(&___result_par_pool.lock);
+
+    size_t failed = atomic_load_explicit(&job.failed, memory_order_relaxed);
+    failure = job.failure;
+
+    pthread_mutex_destroy(&job.failure_lock);
+
+    if (failed == SIZE_MAX)
+        return ___RESULT_size_t_declare(NULL, src_line, src_file, src_function,
+                                        count);
+
+    if (___RESULT_UNLIKELY(job.panicked))
+        ___result_panic(panic_function, failure.src_line, failure.src_file,
+                        failure.src_function, job.panic.exit_code, "%s",
+                        job.panic.message);
+
+    return ___RESULT_size_t_declare(failure.error, failure.src_line,
+                                    failure.src_file, failure.src_function,
+                                    failure.index);
+}
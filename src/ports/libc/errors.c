@@ -37,7 +37,7 @@ Error descriptions are based on the:
 ERROR_DEFINE(PermissionNotPermitted,                PermissionErrorExitCode,        "An attempt was made to perform an operation that is reserved for higher privilage processes.")
 ERROR_DEFINE(FileDoesNotExist,                      FileOperationFailedExitCode,    "No file or directory could be found in the path specified.")
 ERROR_DEFINE(ProcessNotFound,                       InvalidRequestExitCode,         "No process could be found corresponding to the PID specified.")
-ERROR_DEFINE(InterruptedSysCall,                    OtherErrorExitCode,             "An asynchronous signal occured and prevented completion of the call.")
+ERROR_DEFINE_WITH_KIND(InterruptedSysCall,                  ERROR_KIND(Retryable),  OtherErrorExitCode,             "An asynchronous signal occured and prevented completion of the call.")
 ERROR_DEFINE(IOError,                               FileOperationFailedExitCode,    "Some physical input or output error occured.")
 ERROR_DEFINE(DeviceNotFoundOrAddress,               FileOperationFailedExitCode,    "Attached device couldn't handle the request, was incorectly installed, or was not found.")
 ERROR_DEFINE(ArgumentListTooBig,                    InvalidRequestExitCode,         "The number of bytes used in the argument list exceeded the limit.")
@@ -49,7 +49,7 @@ ERROR_DEFINE(NotEnoughMemory,                       MemoryRelatedErrorExitCode,
 ERROR_DEFINE(PermissionDenied,                      FileOperationFailedExitCode,    "An attempt was made to access a file in a way forbidden by it's file access permissions.")
 ERROR_DEFINE(BadAddress,                            MemoryRelatedErrorExitCode,     "The system detected an invalid address in attempting to use an argument of a call.")
 ERROR_DEFINE(NotABlockDevice,                       FileOperationFailedExitCode,    "An attempt was made to do a block operation on an non-block device or file.")
-ERROR_DEFINE(DeviceOrResourceBusy,                  OtherErrorExitCode,             "An attempt was made to use a system resource which was used at a time in a conflicting way.")
+ERROR_DEFINE_WITH_KIND(DeviceOrResourceBusy,                ERROR_KIND(Transient),  OtherErrorExitCode,             "An attempt was made to use a system resource which was used at a time in a conflicting way.")
 ERROR_DEFINE(FileExists,                            FileOperationFailedExitCode,    "An attempt was made to create a file in a location used by another file.")
 ERROR_DEFINE(InvalidCrossDeviceLink,                FileOperationFailedExitCode,    "An attempt was made to create a hard link across file systems.")
 ERROR_DEFINE(UnsupportedDeviceOperation,            InvalidRequestExitCode,         "An attempt was made to apply an inappropriate function to a device.")
@@ -69,7 +69,7 @@ ERROR_DEFINE(BrokenPipe,                            OtherErrorExitCode,
 ERROR_DEFINE(DeviceNotFound,                        InvalidRequestExitCode,         " The wrong type of device was given to a function that expects a particular sort of device.")
 ERROR_DEFINE(NumericalArgumentOutOfDomain,          MathRelatedErrorExitCode,       "A numerical input argument was ouside the defined domain of the mathematical function")
 ERROR_DEFINE(NumericalArgumentOutOfRange,           MathRelatedErrorExitCode,       "A numerical result of the function was too large to fit in the avaiable space.")
-ERROR_DEFINE(ResourceUnavailable,                   OtherErrorExitCode,             "The system lacks resources to complete the operation. This operation may succeed later, when system resources are freed.")
+ERROR_DEFINE_WITH_KIND(ResourceUnavailable,                 ERROR_KIND(Transient),  OtherErrorExitCode,             "The system lacks resources to complete the operation. This operation may succeed later, when system resources are freed.")
 ERROR_DEFINE(InProgress,                            OtherErrorExitCode,             "A long operation was attempted at a non-blocking function. [If you (a user) see this error message, this is a programming error. Please report it to the program authors.]")
 ERROR_DEFINE(AlreadyInProgress,                     OtherErrorExitCode,             "An operation was attempted on a non-blocking object that already had an operation in progress.")
 ERROR_DEFINE(SocketOperationOnNonSocket,            InvalidRequestExitCode,         "An attempt was made to apply a socket-expecting function to a non-socket file.")
@@ -88,13 +88,13 @@ ERROR_DEFINE(NetworkIsUnreachable,                  NetworkConectionErrorExitCod
 ERROR_DEFINE(NetworkDroppedConnectionOnReset,       NetworkConectionErrorExitCode,  "The host you were connected to crashed and rebooted.")
 ERROR_DEFINE(SoftwareCausedConnectionAbort,         NetworkConectionErrorExitCode,  "A network connection was aborted locally.")
 ERROR_DEFINE(ConnectionResetByPeer,                 NetworkConectionErrorExitCode,  "A network connection was closed for reasons outside the control of the local host.")
-ERROR_DEFINE(NoBufferSpaceAvailable,                OtherErrorExitCode,             "An operation was not performed because the system lacked sufficient buffer space or because a queue was full.")
+ERROR_DEFINE_WITH_KIND(NoBufferSpaceAvailable,              ERROR_KIND(Transient),  OtherErrorExitCode,             "An operation was not performed because the system lacked sufficient buffer space or because a queue was full.")
 ERROR_DEFINE(SocketIsAlreadyConnected,              NetworkConectionErrorExitCode,  "A connect request was made on an already connected socket.")
 ERROR_DEFINE(SocketIsNotConnected,                  NetworkConectionErrorExitCode,  "A request to send or receive data was disallowed because the socket was not connected and no address was supplied.")
 ERROR_DEFINE(CannotSendAfterSocketShutdown,         NetworkConectionErrorExitCode,  "A request to send data was disallowed because the socket had already been shut down.")
 ERROR_DEFINE(DestinationAddressRequired,            InvalidRequestExitCode,         "A required address was omitted from an operation on a socket.")
 ERROR_DEFINE(TooManyReferences,                     OtherErrorExitCode,             "A splice cannot be completed, because there are too many references.")
-ERROR_DEFINE(ConnectionTimedOut,                    NetworkConectionErrorExitCode,  "A connect or send request failed because the connected party did not properly respond after a period of time.")
+ERROR_DEFINE_WITH_KIND(ConnectionTimedOut,                  ERROR_KIND(Transient),  NetworkConectionErrorExitCode,  "A connect or send request failed because the connected party did not properly respond after a period of time.")
 ERROR_DEFINE(ConnectionRefused,                     NetworkConectionErrorExitCode,  "No connection could be made because the target machine actively refused it.")
 ERROR_DEFINE(TooManyLevelsOfSymbolicLinks,          FileOperationFailedExitCode,    "Too many levels of symbolic links were encountered in looking up a file name.")
 ERROR_DEFINE(FileNameTooLong,                       FileOperationFailedExitCode,    "FileName or host name exceeded the limit of characters")
@@ -126,7 +126,7 @@ ERROR_DEFINE(MultihopAttempted,                     OtherErrorExitCode,
 ERROR_DEFINE(NoDataAvailable,                       OtherErrorExitCode,             "No message is available.")
 ERROR_DEFINE(LinkHasBeenServed,                     FileOperationFailedExitCode,    "The link connection to a remote machine is gone.")
 ERROR_DEFINE(NoMessageOfDesiredType,                OtherErrorExitCode,             "No message of desired type could be found.")
-ERROR_DEFINE(OutOfStreamsResources,                 OtherErrorExitCode,             "The buffer could not be allocated due to insufficient STREAMs memory resources.")
+ERROR_DEFINE_WITH_KIND(OutOfStreamsResources,               ERROR_KIND(Transient),  OtherErrorExitCode,             "The buffer could not be allocated due to insufficient STREAMs memory resources.")
 ERROR_DEFINE(NotAStream,                            OtherErrorExitCode,             "A STREAM is not associeted with the specified file descriptor.")
 ERROR_DEFINE(ValueTooLarge,                         MathRelatedErrorExitCode,       "A numerical result of a function was too large to be stored in the caller provided space.")
 ERROR_DEFINE(ProtocolError,                         OtherErrorExitCode,             "Some protocol error occured (This error is device-specyfic, but is generaly not related to hardware faliure. For more information refer to the manufacturer's manual.")
@@ -143,14 +143,14 @@ ERROR_DEFINE(MalformedMachObject,                   InvalidRequestExitCode,
 ERROR_DEFINE(DeviceError,                           OtherErrorExitCode,             "A device error has occured.")
 ERROR_DEFINE(NoSuchPolicy,                          InvalidRequestExitCode,         "No such policy registered.")
 ERROR_DEFINE(DevicePowerIsOff,                      OtherErrorExitCode,             "The device power is off.")
-ERROR_DEFINE(FullInterfaceOutputQueue,              OtherErrorExitCode,             "Interface output queue is full.")
+ERROR_DEFINE_WITH_KIND(FullInterfaceOutputQueue,            ERROR_KIND(Transient),  OtherErrorExitCode,             "Interface output queue is full.")
 ERROR_DEFINE(SharedLibraryVersionMismatch,          OtherErrorExitCode,             "The version of the shared library on the system does not match the version which was expected.")
 ERROR_DEFINE(IPSecProcessingFailure,                NetworkConectionErrorExitCode,  "IPsec subsystem error.") 
 ERROR_DEFINE(NotPermittedInCapabilityMode,          InvalidRequestExitCode,         "The system call or operation is not permitted for capability mode processes.")
 ERROR_DEFINE(IntegrityCheckFailed,                  OtherErrorExitCode,             "An integrity check failed and detected inconsistencies in data questioned.")
 ERROR_DEFINE(CapabilitiesInsufficient,              InvalidRequestExitCode,         "An operation requires greater privilege than the capability allows.")
 /* Folowing error codes are defined in the linux kernel, but not documented enough to make a consistent error message. Their messages and exit codes can change in the future. */
-ERROR_DEFINE(InterruptedSyscallShouldBeRestarted,   OtherErrorExitCode,             "Interrupted system call should be restarted.")
+ERROR_DEFINE_WITH_KIND(InterruptedSyscallShouldBeRestarted, ERROR_KIND(Retryable),  OtherErrorExitCode,             "Interrupted system call should be restarted.")
 ERROR_DEFINE(ChannelNumberOutOfRange,               OtherErrorExitCode,             "Channel number out of range.")
 ERROR_DEFINE(Level2NotSynchronized,                 OtherErrorExitCode,             "Level 2 not synchronized.")
 ERROR_DEFINE(Level3Halted,                          OtherErrorExitCode,             "Level 3 halted.")
@@ -292,7 +292,7 @@ const ___ERRNO_BIND ___errno_binds[] = {
     { EWOULDBLOCK,      ERR(ResourceUnavailable) },
 };
 
-const int ___errno_binds_size = sizeof(___errno_binds);
+const int ___errno_binds_size = sizeof(___errno_binds) / sizeof(___errno_binds[0]);
 
 #elif defined(__DragonFly__)
 
@@ -399,7 +399,7 @@ const ___ERRNO_BIND ___errno_binds[] = {
     { EOPNOTSUPP,       ERR(NotSupported) }
 };
 
-const int ___errno_binds_size = sizeof(___errno_binds);
+const int ___errno_binds_size = sizeof(___errno_binds) / sizeof(___errno_binds[0]);
 
 #elif (defined(__APPLE__) && defined(__MACH__))
 
@@ -513,7 +513,7 @@ const ___ERRNO_BIND ___errno_binds[] = {
     { EXDEV,            ERR(InvalidCrossDeviceLink) }
 };
 
-const int ___errno_binds_size = sizeof(___errno_binds);
+const int ___errno_binds_size = sizeof(___errno_binds) / sizeof(___errno_binds[0]);
 
 #elif defined(__OpenBSD__)
 
@@ -616,7 +616,7 @@ const ___ERRNO_BIND ___errno_binds[] = {
     { EXDEV,            ERR(InvalidCrossDeviceLink) }
 };
 
-const int ___errno_binds_size = sizeof(___errno_binds);
+const int ___errno_binds_size = sizeof(___errno_binds) / sizeof(___errno_binds[0]);
 
 #elif defined(__FreeBSD__)
 
@@ -722,7 +722,7 @@ const ___ERRNO_BIND ___errno_binds[] = {
     { EXDEV,            ERR(InvalidCrossDeviceLink) }
 };
 
-const int ___errno_binds_size = sizeof(___errno_binds);
+const int ___errno_binds_size = sizeof(___errno_binds) / sizeof(___errno_binds[0]);
 #elif defined(__NetBSD__)
 
 const ___ERRNO_BIND ___errno_binds[] = {
@@ -827,7 +827,7 @@ const ___ERRNO_BIND ___errno_binds[] = {
     { EOPNOTSUPP,       ERR(NotSupported) }
 };
 
-const int ___errno_binds_size = sizeof(___errno_binds);
+const int ___errno_binds_size = sizeof(___errno_binds) / sizeof(___errno_binds[0]);
 
 #elif defined(__linux__)
 
@@ -959,7 +959,7 @@ const ___ERRNO_BIND ___errno_binds[] = {
     { EXFULL,           ERR(ExchangeFull) }
 };
 
-const int ___errno_binds_size = sizeof(___errno_binds);
+const int ___errno_binds_size = sizeof(___errno_binds) / sizeof(___errno_binds[0]);
 
 #elif defined(__unix__) || defined(__unix)
 /* POSIX.1-2008 */
@@ -1048,7 +1048,7 @@ const ___ERRNO_BIND ___errno_binds[] = {
     { EXDEV,            ERR(InvalidCrossDeviceLink) }
 };
 
-const int ___errno_binds_size = sizeof(___errno_binds);
+const int ___errno_binds_size = sizeof(___errno_binds) / sizeof(___errno_binds[0]);
 
 #else
 #error "LIBC/LIBM ports not supported by target."
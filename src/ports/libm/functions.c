@@ -0,0 +1,264 @@
+/*
+    PORTS/FUNCTIONS.C - Math functions reporting domain and range errors
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <ports/libm/functions.h>
+#include <ports/libc/errors.h>
+#include <compiler.h>
+
+#include <fenv.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+    Built with -fno-math-errno, so sqrt is a single instruction and its array
+    loops are vectorized. The remaining functions are calls into libm, they
+    still set errno, the results just don't depend on it.
+*/
+#if defined(__clang__) || !defined(__GNUC__)
+#pragma STDC FENV_ACCESS ON
+#endif
+
+#ifndef FE_INVALID
+#define FE_INVALID 0
+#endif
+
+#ifndef FE_DIVBYZERO
+#define FE_DIVBYZERO 0
+#endif
+
+#ifndef FE_OVERFLOW
+#define FE_OVERFLOW 0
+#endif
+
+#define ___LIBM_EXCEPTIONS (FE_INVALID | FE_DIVBYZERO | FE_OVERFLOW)
+
+/*
+    GCC ignores FENV_ACCESS, and could move the computation across the fenv
+    calls. The barrier pins the value in a register at that point.
+*/
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__SSE2_MATH__))
+#define ___LIBM_BARRIER(x) __asm__ __volatile__("" : "+x"(x))
+#elif defined(__GNUC__) && defined(__aarch64__)
+#define ___LIBM_BARRIER(x) __asm__ __volatile__("" : "+w"(x))
+#elif defined(__GNUC__)
+#define ___LIBM_BARRIER(x) __asm__ __volatile__("" : "+m"(x))
+#else
+#define ___LIBM_BARRIER(x) ((void) 0)
+#endif
+
+/*
+    On x86-64 float and double math runs on SSE, so the flags can be read from
+    MXCSR directly. fetestexcept also reads the x87 status word, which makes it
+    several times slower.
+*/
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__SSE2_MATH__) &&      \
+    FE_INVALID == 0x01 && FE_DIVBYZERO == 0x04 && FE_OVERFLOW == 0x08
+#define ___LIBM_TEST(excepts) ((int) __builtin_ia32_stmxcsr() & (excepts))
+#else
+#define ___LIBM_TEST(excepts) fetestexcept(excepts)
+#endif
+
+/* The array versions leave their results in memory */
+#if defined(__GNUC__)
+#define ___LIBM_MEMORY_BARRIER() __asm__ __volatile__("" ::: "memory")
+#else
+#define ___LIBM_MEMORY_BARRIER() ((void) 0)
+#endif
+
+/*
+    The flags are sticky, so they are normally clear, and testing them is much
+    cheaper than clearing them. Flags raised by the caller are put aside for
+    the call, and restored afterwards.
+*/
+static inline int ___libm_begin(fexcept_t* saved)
+{
+    int raised = ___LIBM_TEST(___LIBM_EXCEPTIONS);
+
+    if (___RESULT_UNLIKELY(raised != 0)) {
+        fegetexceptflag(saved, raised);
+        feclearexcept(raised);
+    }
+
+    return raised;
+}
+
+static inline const Error* ___libm_end(int raised, const fexcept_t* saved)
+{
+    ___LIBM_MEMORY_BARRIER();
+    int flags = ___LIBM_TEST(___LIBM_EXCEPTIONS);
+
+    if (___RESULT_UNLIKELY(raised != 0)) fesetexceptflag(saved, raised);
+
+    if (___RESULT_LIKELY(flags == 0)) return NULL;
+    if (flags & FE_INVALID) return ERR(NumericalArgumentOutOfDomain);
+    return ERR(NumericalArgumentOutOfRange);
+}
+
+/* NaN from a number is a domain error, infinity from finite numbers a range one */
+#define ___LIBM_CLASSIFY(result, arguments_nan, arguments_finite)               \
+    (isnan(result) && !(arguments_nan) ? LIBM_DOMAIN_ERROR :                    \
+     isinf(result) && (arguments_finite) ? LIBM_RANGE_ERROR : LIBM_OK)
+
+/*
+    out may be one of the arguments, so the mask keeps what the classification
+    needs to know about them, before the results overwrite them
+*/
+#define ___LIBM_ARGUMENTS_NAN       0x10
+#define ___LIBM_ARGUMENTS_FINITE    0x20
+
+#define ___LIBM_ARGUMENTS(arguments_nan, arguments_finite)                      \
+    (((arguments_nan) ? ___LIBM_ARGUMENTS_NAN : 0) |                            \
+     ((arguments_finite) ? ___LIBM_ARGUMENTS_FINITE : 0))
+
+#define ___LIBM_CLASSIFY_MASK(result, arguments)                                \
+    ___LIBM_CLASSIFY(result, (arguments) & ___LIBM_ARGUMENTS_NAN,               \
+                     (arguments) & ___LIBM_ARGUMENTS_FINITE)
+
+#define ___LIBM_DEFINE_UNARY_TYPE(name, type, suffix)                           \
+    Result(type) ___libm_## name ## suffix(int src_line, char* src_file,        \
+                                           const char* src_function, type x)    \
+    {                                                                           \
+        fexcept_t saved;                                                        \
+        int raised = ___libm_begin(&saved);                                     \
+                                                                                \
+        ___LIBM_BARRIER(x);                                                     \
+        type value = name ## suffix(x);                                         \
+        ___LIBM_BARRIER(value);                                                 \
+                                                                                \
+        return ___RESULT_## type ##_declare(___libm_end(raised, &saved),        \
+                                            src_line, src_file, src_function,   \
+                                            value);                             \
+    }                                                                           \
+                                                                                \
+    Result(void) ___libm_## name ## suffix ##_array(int src_line,               \
+                                                    char* src_file,             \
+                                                    const char* src_function,   \
+                                                    type* out,                  \
+                                                    const type* x,              \
+                                                    size_t count,               \
+                                                    uint8_t* restrict mask)     \
+    {                                                                           \
+        fexcept_t saved;                                                        \
+        int raised = ___libm_begin(&saved);                                     \
+                                                                                \
+        if (mask != NULL)                                                       \
+            for (size_t i = 0; i < count; i++)                                  \
+                mask[i] = ___LIBM_ARGUMENTS(isnan(x[i]), isfinite(x[i]));       \
+                                                                                \
+        for (size_t i = 0; i < count; i++) out[i] = name ## suffix(x[i]);       \
+                                                                                \
+        const Error* error = ___libm_end(raised, &saved);                       \
+                                                                                \
+        if (___RESULT_LIKELY(error == NULL)) {                                  \
+            if (mask != NULL) memset(mask, LIBM_OK, count);                     \
+            return result_OK(void);                                             \
+        }                                                                       \
+                                                                                \
+        if (mask != NULL)                                                       \
+            for (size_t i = 0; i < count; i++)                                  \
+                mask[i] = ___LIBM_CLASSIFY_MASK(out[i], mask[i]);               \
+                                                                                \
+        return ___RESULT_void_declare(error, src_line, src_file,                \
+                                      src_function);                            \
+    }                                                                           \
+
+#define ___LIBM_DEFINE_BINARY_TYPE(name, type, suffix)                          \
+    Result(type) ___libm_## name ## suffix(int src_line, char* src_file,        \
+                                           const char* src_function,            \
+                                           type x, type y)                      \
+    {                                                                           \
+        fexcept_t saved;                                                        \
+        int raised = ___libm_begin(&saved);                                     \
+                                                                                \
+        ___LIBM_BARRIER(x);                                                     \
+        ___LIBM_BARRIER(y);                                                     \
+        type value = name ## suffix(x, y);                                      \
+        ___LIBM_BARRIER(value);                                                 \
+                                                                                \
+        return ___RESULT_## type ##_declare(___libm_end(raised, &saved),        \
+                                            src_line, src_file, src_function,   \
+                                            value);                             \
+    }                                                                           \
+                                                                                \
+    Result(void) ___libm_## name ## suffix ##_array(int src_line,               \
+                                                    char* src_file,             \
+                                                    const char* src_function,   \
+                                                    type* out,                  \
+                                                    const type* x,              \
+                                                    const type* y,              \
+                                                    size_t count,               \
+                                                    uint8_t* restrict mask)     \
+    {                                                                           \
+        fexcept_t saved;                                                        \
+        int raised = ___libm_begin(&saved);                                     \
+                                                                                \
+        if (mask != NULL)                                                       \
+            for (size_t i = 0; i < count; i++)                                  \
+                mask[i] = ___LIBM_ARGUMENTS(isnan(x[i]) || isnan(y[i]),         \
+                                            isfinite(x[i]) && isfinite(y[i]));  \
+                                                                                \
+        for (size_t i = 0; i < count; i++)                                      \
+            out[i] = name ## suffix(x[i], y[i]);                                \
+                                                                                \
+        const Error* error = ___libm_end(raised, &saved);                       \
+                                                                                \
+        if (___RESULT_LIKELY(error == NULL)) {                                  \
+            if (mask != NULL) memset(mask, LIBM_OK, count);                     \
+            return result_OK(void);                                             \
+        }                                                                       \
+                                                                                \
+        if (mask != NULL)                                                       \
+            for (size_t i = 0; i < count; i++)                                  \
+                mask[i] = ___LIBM_CLASSIFY_MASK(out[i], mask[i]);               \
+                                                                                \
+        return ___RESULT_void_declare(error, src_line, src_file,                \
+                                      src_function);                            \
+    }                                                                           \
+
+#define ___LIBM_DEFINE_UNARY(name)                                              \
+    ___LIBM_DEFINE_UNARY_TYPE(name, double, )                                   \
+    ___LIBM_DEFINE_UNARY_TYPE(name, float, f)                                   \
+
+#define ___LIBM_DEFINE_BINARY(name)                                             \
+    ___LIBM_DEFINE_BINARY_TYPE(name, double, )                                  \
+    ___LIBM_DEFINE_BINARY_TYPE(name, float, f)                                  \
+
+___LIBM_DEFINE_UNARY(sqrt)
+___LIBM_DEFINE_UNARY(exp)
+___LIBM_DEFINE_UNARY(exp2)
+___LIBM_DEFINE_UNARY(expm1)
+___LIBM_DEFINE_UNARY(log)
+___LIBM_DEFINE_UNARY(log2)
+___LIBM_DEFINE_UNARY(log10)
+___LIBM_DEFINE_UNARY(log1p)
+___LIBM_DEFINE_UNARY(sin)
+___LIBM_DEFINE_UNARY(cos)
+___LIBM_DEFINE_UNARY(tan)
+___LIBM_DEFINE_UNARY(asin)
+___LIBM_DEFINE_UNARY(acos)
+___LIBM_DEFINE_UNARY(sinh)
+___LIBM_DEFINE_UNARY(cosh)
+___LIBM_DEFINE_UNARY(acosh)
+___LIBM_DEFINE_UNARY(atanh)
+___LIBM_DEFINE_UNARY(tgamma)
+
+___LIBM_DEFINE_BINARY(pow)
+___LIBM_DEFINE_BINARY(hypot)
+___LIBM_DEFINE_BINARY(fmod)
@@ -0,0 +1,315 @@
+/*
+    PORTS/ALLOCATORS.C - Allocations returning results
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <ports/memory/allocators.h>
+#include <ports/libc/errors.h>
+#include <compiler.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+ERROR_DEFINE(MemoryLimitExceeded,   MemoryRelatedErrorExitCode, "The allocation would exceed the capacity of the allocator.")
+
+#define ___MEMORY_ERR(error)                                                    \
+    ___RESULT_void_ptr_declare(ERR(error), src_line, src_file, src_function,    \
+                               NULL)                                            \
+
+#define ___MEMORY_IS_POWER_OF_TWO(x) ((x) != 0 && ((x) & ((x) - 1)) == 0)
+
+/* The data of a block starts after the header, aligned for any type */
+#define ___MEMORY_HEADER_SIZE                                                   \
+    ((sizeof(___MEMORY_BLOCK) + _Alignof(max_align_t) - 1)                      \
+     & ~(_Alignof(max_align_t) - 1))                                            \
+
+Result(void_ptr) ___memory_malloc(int src_line, char* src_file,
+                                  const char* src_function, size_t size)
+{
+    void* pointer = malloc(size);
+
+    if (___RESULT_UNLIKELY(pointer == NULL && size != 0))
+        return ___MEMORY_ERR(NotEnoughMemory);
+
+    return ___MEMORY_OK(pointer);
+}
+
+Result(void_ptr) ___memory_calloc(int src_line, char* src_file,
+                                  const char* src_function, size_t count,
+                                  size_t size)
+{
+    void* pointer = calloc(count, size);
+
+    if (___RESULT_UNLIKELY(pointer == NULL && count != 0 && size != 0))
+        return ___MEMORY_ERR(NotEnoughMemory);
+
+    return ___MEMORY_OK(pointer);
+}
+
+Result(void_ptr) ___memory_realloc(int src_line, char* src_file,
+                                   const char* src_function, void* pointer,
+                                   size_t size)
+{
+    void* resized = realloc(pointer, size);
+
+    if (___RESULT_UNLIKELY(resized == NULL && size != 0))
+        return ___MEMORY_ERR(NotEnoughMemory);
+
+    return ___MEMORY_OK(resized);
+}
+
+Result(void_ptr) ___memory_aligned_alloc(int src_line, char* src_file,
+                                         const char* src_function,
+                                         size_t alignment, size_t size)
+{
+    if (!___MEMORY_IS_POWER_OF_TWO(alignment))
+        return ___MEMORY_ERR(InvalidArgument);
+
+    /* C11 wants the size to be a multiple of the alignment */
+    size_t rounded = (size + alignment - 1) & ~(alignment - 1);
+    if (rounded < size) return ___MEMORY_ERR(NotEnoughMemory);
+
+    if (alignment < sizeof(void*)) alignment = sizeof(void*);
+
+    void* pointer = aligned_alloc(alignment, rounded);
+
+    if (___RESULT_UNLIKELY(pointer == NULL && rounded != 0))
+        return ___MEMORY_ERR(NotEnoughMemory);
+
+    return ___MEMORY_OK(pointer);
+}
+
+static ___MEMORY_BLOCK* ___memory_block_new(MemoryStats* stats,
+                                            size_t capacity, size_t size,
+                                            const Error** error)
+{
+    if (stats->bytes_reserved > capacity
+        || size > capacity - stats->bytes_reserved) {
+        *error = ERR(MemoryLimitExceeded);
+        return NULL;
+    }
+
+    ___MEMORY_BLOCK* block = malloc(size);
+    if (block == NULL) {
+        *error = ERR(NotEnoughMemory);
+        return NULL;
+    }
+
+    block->size = size;
+    stats->bytes_reserved += size;
+    stats->blocks++;
+
+    return block;
+}
+
+static void ___memory_blocks_free(___MEMORY_BLOCK* block, MemoryStats* stats)
+{
+    while (block != NULL) {
+        ___MEMORY_BLOCK* next = block->next;
+
+        stats->bytes_reserved -= block->size;
+        stats->blocks--;
+        free(block);
+
+        block = next;
+    }
+}
+
+void memory_arena_init(MemoryArena* arena, size_t block_size, size_t capacity)
+{
+    *arena = (MemoryArena) {
+        .cursor = 0,
+        .end = 0,
+        .blocks = NULL,
+        .block_size = block_size ? block_size : MEMORY_ARENA_BLOCK_SIZE,
+        .capacity = capacity ? capacity : SIZE_MAX,
+        .stats = { 0 },
+    };
+}
+
+Result(void_ptr) ___memory_arena_grow(int src_line, char* src_file,
+                                      const char* src_function,
+                                      MemoryArena* arena, size_t size,
+                                      size_t alignment)
+{
+    if (!___MEMORY_IS_POWER_OF_TWO(alignment))
+        return ___MEMORY_ERR(InvalidArgument);
+
+    size_t taken = size + (size == 0);
+    size_t padding = alignment > _Alignof(max_align_t)
+                     ? alignment - _Alignof(max_align_t) : 0;
+    size_t needed = ___MEMORY_HEADER_SIZE + padding + taken;
+
+    if (needed < taken) {
+        arena->stats.failures++;
+        return ___MEMORY_ERR(NotEnoughMemory);
+    }
+
+    const Error* error = NULL;
+    bool oversized = needed > arena->block_size;
+    ___MEMORY_BLOCK* block = ___memory_block_new(
+        &arena->stats, arena->capacity,
+        oversized ? needed : arena->block_size, &error);
+
+    if (block == NULL) {
+        arena->stats.failures++;
+        return ___RESULT_void_ptr_declare(error, src_line, src_file,
+                                          src_function, NULL);
+    }
+
+    uintptr_t data = (uintptr_t) block + ___MEMORY_HEADER_SIZE;
+    uintptr_t start = (data + alignment - 1) & ~(alignment - 1);
+
+    /* Oversized blocks go behind the current one, which stays in use */
+    if (oversized && arena->blocks != NULL) {
+        block->next = arena->blocks->next;
+        arena->blocks->next = block;
+    } else {
+        block->next = arena->blocks;
+        arena->blocks = block;
+        arena->cursor = start + taken;
+        arena->end = (uintptr_t) block + block->size;
+    }
+
+    arena->stats.allocations++;
+    arena->stats.bytes_in_use += size;
+
+    return ___MEMORY_OK((void*) start);
+}
+
+void memory_arena_reset(MemoryArena* arena)
+{
+    arena->stats = memory_arena_stats(arena);
+
+    if (arena->blocks != NULL) {
+        ___memory_blocks_free(arena->blocks->next, &arena->stats);
+        arena->blocks->next = NULL;
+        arena->cursor = (uintptr_t) arena->blocks + ___MEMORY_HEADER_SIZE;
+    }
+
+    arena->stats.releases++;
+    arena->stats.bytes_in_use = 0;
+}
+
+void memory_arena_free(MemoryArena* arena)
+{
+    ___memory_blocks_free(arena->blocks, &arena->stats);
+
+    arena->blocks = NULL;
+    arena->cursor = arena->end = 0;
+    arena->stats.bytes_in_use = 0;
+}
+
+/* The fast path doesn't track the peak, it only grows until a reset */
+MemoryStats memory_arena_stats(const MemoryArena* arena)
+{
+    MemoryStats stats = arena->stats;
+
+    if (stats.bytes_in_use > stats.peak_bytes_in_use)
+        stats.peak_bytes_in_use = stats.bytes_in_use;
+
+    return stats;
+}
+
+void memory_pool_init(MemoryPool* pool, size_t object_size,
+                      size_t objects_per_block, size_t capacity)
+{
+    size_t alignment = object_size >= _Alignof(max_align_t)
+                       ? _Alignof(max_align_t) : sizeof(void*);
+
+    if (object_size < sizeof(void*)) object_size = sizeof(void*);
+    object_size = (object_size + alignment - 1) & ~(alignment - 1);
+
+    *pool = (MemoryPool) {
+        .free_list = NULL,
+        .cursor = 0,
+        .end = 0,
+        .blocks = NULL,
+        .object_size = object_size,
+        .objects_per_block = objects_per_block ? objects_per_block
+                                               : MEMORY_POOL_OBJECTS_PER_BLOCK,
+        .capacity = capacity ? capacity : SIZE_MAX,
+        .stats = { 0 },
+    };
+}
+
+Result(void_ptr) ___memory_pool_grow(int src_line, char* src_file,
+                                     const char* src_function,
+                                     MemoryPool* pool)
+{
+    if (pool->stats.allocations - pool->stats.releases >= pool->capacity) {
+        pool->stats.failures++;
+        return ___MEMORY_ERR(MemoryLimitExceeded);
+    }
+
+    size_t objects = pool->objects_per_block;
+
+    /* Don't reserve a block beyond the capacity */
+    if (pool->capacity != SIZE_MAX) {
+        size_t live = pool->stats.allocations - pool->stats.releases;
+
+        if (objects > pool->capacity - live) objects = pool->capacity - live;
+    }
+
+    if (objects > (SIZE_MAX - ___MEMORY_HEADER_SIZE) / pool->object_size) {
+        pool->stats.failures++;
+        return ___MEMORY_ERR(NotEnoughMemory);
+    }
+
+    const Error* error = NULL;
+    ___MEMORY_BLOCK* block = ___memory_block_new(
+        &pool->stats, SIZE_MAX,
+        ___MEMORY_HEADER_SIZE + objects * pool->object_size, &error);
+
+    if (block == NULL) {
+        pool->stats.failures++;
+        return ___RESULT_void_ptr_declare(error, src_line, src_file,
+                                          src_function, NULL);
+    }
+
+    block->next = pool->blocks;
+    pool->blocks = block;
+
+    uintptr_t object = (uintptr_t) block + ___MEMORY_HEADER_SIZE;
+
+    pool->cursor = object + pool->object_size;
+    pool->end = (uintptr_t) block + block->size;
+
+    pool->stats.allocations++;
+    pool->stats.bytes_in_use += pool->object_size;
+    if (pool->stats.bytes_in_use > pool->stats.peak_bytes_in_use)
+        pool->stats.peak_bytes_in_use = pool->stats.bytes_in_use;
+
+    return ___MEMORY_OK((void*) object);
+}
+
+void memory_pool_free(MemoryPool* pool)
+{
+    ___memory_blocks_free(pool->blocks, &pool->stats);
+
+    pool->free_list = NULL;
+    pool->blocks = NULL;
+    pool->cursor = pool->end = 0;
+    pool->stats.releases = pool->stats.allocations;
+    pool->stats.bytes_in_use = 0;
+}
+
+MemoryStats memory_pool_stats(const MemoryPool* pool)
+{
+    return pool->stats;
+}
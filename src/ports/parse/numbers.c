@@ -0,0 +1,479 @@
+/*
+    PORTS/NUMBERS.C - Parsing numbers from text
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/* strtod_l is a GNU extension in glibc */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <ports/parse/numbers.h>
+#include <ports/libc/errors.h>
+#include <compiler.h>
+#include <error.h>
+
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GLIBC__) || defined(__APPLE__) || defined(__FreeBSD__) ||         \
+    defined(__NetBSD__) || defined(__OpenBSD__)
+#define ___PARSE_HAS_STRTOD_L
+#include <locale.h>
+#if defined(__APPLE__) || defined(__FreeBSD__)
+#include <xlocale.h>
+#endif
+#endif
+
+ERROR_DEFINE(ParseEmpty,            InvalidRequestExitCode,     "There was no number to parse.")
+ERROR_DEFINE(ParseInvalidDigit,     InvalidRequestExitCode,     "The text did not start with a valid number.")
+ERROR_DEFINE(ParseOverflow,         MathRelatedErrorExitCode,   "The parsed number could not be represented in its type.")
+
+#define ___PARSE_IS_DIGIT(c) ((unsigned char) ((c) - '0') < 10)
+
+/*
+    Eight digits at a time, with the bytes of a 64 bit word (little endian).
+    See "Fast numerical parsing" of simdjson, D. Lemire, 2020.
+*/
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define ___PARSE_SWAR
+#endif
+
+#ifdef ___PARSE_SWAR
+
+static inline uint64_t ___parse_load8(const char* text)
+{
+    uint64_t word;
+
+    memcpy(&word, text, sizeof(word));
+    return word;
+}
+
+static inline bool ___parse_is_eight_digits(uint64_t word)
+{
+    return ((word & 0xF0F0F0F0F0F0F0F0u) |
+            (((word + 0x0606060606060606u) & 0xF0F0F0F0F0F0F0F0u) >> 4))
+           == 0x3333333333333333u;
+}
+
+static inline uint32_t ___parse_eight_digits(uint64_t word)
+{
+    word -= 0x3030303030303030u;
+    word = (word * 10) + (word >> 8);
+    word = (((word & 0x000000FF000000FFu) * 0x000F424000000064u) +
+            (((word >> 16) & 0x000000FF000000FFu) * 0x0000271000000001u)) >> 32;
+
+    return (uint32_t) word;
+}
+
+#endif
+
+/*
+    Takes all of the digits at the start of the text. Below 19 digits the value
+    can't overflow 64 bits, so the checks start after that.
+*/
+static inline size_t ___parse_digits(const char* text, size_t length,
+                                     uint64_t* value, bool* overflow)
+{
+    uint64_t result = 0;
+    size_t i = 0;
+
+#ifdef ___PARSE_SWAR
+    while (i <= 8 && length - i >= 8) {
+        uint64_t word = ___parse_load8(text + i);
+
+        if (!___parse_is_eight_digits(word)) break;
+
+        result = result * 100000000u + ___parse_eight_digits(word);
+        i += 8;
+    }
+#endif
+
+    for (; i < length && ___PARSE_IS_DIGIT(text[i]); i++) {
+        unsigned int digit = (unsigned int) (text[i] - '0');
+
+        if (i >= 19 && result > (UINT64_MAX - digit) / 10) {
+            *overflow = true;
+            continue;
+        }
+
+        result = result * 10 + digit;
+    }
+
+    *value = result;
+    return i;
+}
+
+static inline const Error* ___parse_unsigned(const char* text, size_t length,
+                                             uint64_t max, uint64_t* value,
+                                             size_t* consumed)
+{
+    size_t ignored;
+    if (consumed == NULL) consumed = &ignored;
+
+    *value = 0;
+    *consumed = 0;
+
+    if (___RESULT_UNLIKELY(length == 0)) return ERR(ParseEmpty);
+
+    bool overflow = false;
+    size_t digits = ___parse_digits(text, length, value, &overflow);
+
+    if (___RESULT_UNLIKELY(digits == 0)) return ERR(ParseInvalidDigit);
+
+    *consumed = digits;
+
+    if (___RESULT_UNLIKELY(overflow || *value > max)) {
+        *value = max;
+        return ERR(ParseOverflow);
+    }
+
+    return NULL;
+}
+
+const Error* ___result_parse_unsigned(const char* text, size_t length,
+                                      uint64_t max, uint64_t* value,
+                                      size_t* consumed)
+{
+    return ___parse_unsigned(text, length, max, value, consumed);
+}
+
+static inline const Error* ___parse_signed(const char* text, size_t length,
+                                           uint64_t max, uint64_t* value,
+                                           size_t* consumed)
+{
+    size_t ignored;
+    if (consumed == NULL) consumed = &ignored;
+
+    *value = 0;
+    *consumed = 0;
+
+    if (___RESULT_UNLIKELY(length == 0)) return ERR(ParseEmpty);
+
+    bool negative = text[0] == '-';
+    if (negative && length == 1) return ERR(ParseEmpty);
+
+    bool overflow = false;
+    uint64_t magnitude;
+    size_t digits = ___parse_digits(text + negative, length - negative,
+                                    &magnitude, &overflow);
+
+    if (___RESULT_UNLIKELY(digits == 0)) return ERR(ParseInvalidDigit);
+
+    *consumed = digits + negative;
+
+    uint64_t limit = max + negative;
+    if (___RESULT_UNLIKELY(overflow || magnitude > limit)) {
+        *value = negative ? 0 - limit : limit;
+        return ERR(ParseOverflow);
+    }
+
+    *value = negative ? 0 - magnitude : magnitude;
+    return NULL;
+}
+
+const Error* ___result_parse_signed(const char* text, size_t length,
+                                    uint64_t max, uint64_t* value,
+                                    size_t* consumed)
+{
+    return ___parse_signed(text, length, max, value, consumed);
+}
+
+#ifdef ___PARSE_HAS_STRTOD_L
+
+static locale_t ___parse_c_locale(void)
+{
+    static locale_t c_locale = (locale_t) 0;
+
+    locale_t current = __atomic_load_n(&c_locale, __ATOMIC_ACQUIRE);
+    if (___RESULT_LIKELY(current != (locale_t) 0)) return current;
+
+    locale_t created = newlocale(LC_ALL_MASK, "C", (locale_t) 0);
+    if (created == (locale_t) 0) return (locale_t) 0;
+
+    if (!__atomic_compare_exchange_n(&c_locale, &current, created, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        freelocale(created);
+        return current;
+    }
+
+    return created;
+}
+
+#endif
+
+/* The slow path, for numbers that can't be converted exactly right away */
+static const Error* ___parse_double_slow(const char* text, size_t length,
+                                         double* value)
+{
+    char buffer[128];
+    char* copy = length < sizeof(buffer) ? buffer : malloc(length + 1);
+
+    if (copy == NULL) return ERR(NotEnoughMemory);
+
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+
+#ifdef ___PARSE_HAS_STRTOD_L
+    locale_t c_locale = ___parse_c_locale();
+    *value = c_locale != (locale_t) 0 ? strtod_l(copy, NULL, c_locale)
+                                      : strtod(copy, NULL);
+#else
+    *value = strtod(copy, NULL);
+#endif
+
+    if (copy != buffer) free(copy);
+
+    if (___RESULT_UNLIKELY(isinf(*value))) return ERR(ParseOverflow);
+    return NULL;
+}
+
+static bool ___parse_word(const char* text, size_t length, const char* word)
+{
+    size_t size = strlen(word);
+
+    if (length < size) return false;
+
+    for (size_t i = 0; i < size; i++)
+        if ((text[i] | 0x20) != word[i]) return false;
+
+    return true;
+}
+
+/* Powers of ten exactly representable as doubles */
+static const double ___parse_powers[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static const Error* ___parse_double(const char* text, size_t length,
+                                    double* value, size_t* consumed)
+{
+    *value = 0;
+    *consumed = 0;
+
+    if (___RESULT_UNLIKELY(length == 0)) return ERR(ParseEmpty);
+
+    size_t i = text[0] == '-';
+    bool negative = i == 1;
+
+    if (___RESULT_UNLIKELY(i == length)) return ERR(ParseEmpty);
+
+    if (!___PARSE_IS_DIGIT(text[i]) && text[i] != '.') {
+        if (___parse_word(text + i, length - i, "infinity")) {
+            *value = negative ? -INFINITY : INFINITY;
+            *consumed = i + 8;
+            return NULL;
+        }
+
+        if (___parse_word(text + i, length - i, "inf")) {
+            *value = negative ? -INFINITY : INFINITY;
+            *consumed = i + 3;
+            return NULL;
+        }
+
+        if (___parse_word(text + i, length - i, "nan")) {
+            *value = negative ? -NAN : NAN;
+            *consumed = i + 3;
+            return NULL;
+        }
+
+        return ERR(ParseInvalidDigit);
+    }
+
+    /* 19 significant digits fit in the mantissa, the rest only scale it */
+    uint64_t mantissa = 0;
+    unsigned int significant = 0;
+    int64_t exponent = 0;
+    bool truncated = false;
+    size_t digits = 0;
+
+    for (; i < length && text[i] == '0'; i++) digits++;
+
+    for (; i < length && ___PARSE_IS_DIGIT(text[i]); i++, digits++) {
+        if (significant < 19) {
+            mantissa = mantissa * 10 + (uint64_t) (text[i] - '0');
+            significant++;
+        } else {
+            truncated |= text[i] != '0';
+            exponent++;
+        }
+    }
+
+    if (i < length && text[i] == '.') {
+        size_t fraction = ++i;
+
+        if (significant == 0)
+            for (; i < length && text[i] == '0'; i++) exponent--;
+
+#ifdef ___PARSE_SWAR
+        while (significant + 8 <= 19 && length - i >= 8) {
+            uint64_t word = ___parse_load8(text + i);
+
+            if (!___parse_is_eight_digits(word)) break;
+
+            mantissa = mantissa * 100000000u + ___parse_eight_digits(word);
+            significant += significant != 0 || mantissa != 0 ? 8 : 0;
+            exponent -= 8;
+            i += 8;
+        }
+#endif
+
+        for (; i < length && ___PARSE_IS_DIGIT(text[i]); i++) {
+            if (significant < 19) {
+                mantissa = mantissa * 10 + (uint64_t) (text[i] - '0');
+                significant += significant != 0 || mantissa != 0;
+                exponent--;
+            } else {
+                truncated |= text[i] != '0';
+            }
+        }
+
+        digits += i - fraction;
+    }
+
+    /* A lone dot is not a number */
+    if (___RESULT_UNLIKELY(digits == 0)) return ERR(ParseInvalidDigit);
+
+    if (i < length && (text[i] | 0x20) == 'e') {
+        size_t start = i++;
+        bool negative_exponent = false;
+
+        if (i < length && (text[i] == '-' || text[i] == '+'))
+            negative_exponent = text[i++] == '-';
+
+        if (i < length && ___PARSE_IS_DIGIT(text[i])) {
+            int64_t written = 0;
+
+            for (; i < length && ___PARSE_IS_DIGIT(text[i]); i++)
+                if (written < 100000000)
+                    written = written * 10 + (text[i] - '0');
+
+            exponent += negative_exponent ? -written : written;
+        } else {
+            /* Not an exponent, the e belongs to the rest of the text */
+            i = start;
+        }
+    }
+
+    *consumed = i;
+
+    /* Clinger's fast path, both numbers are exact, so there is one rounding */
+#if FLT_EVAL_METHOD == 0
+    if (!truncated && mantissa <= (UINT64_C(1) << 53) &&
+        exponent >= -22 && exponent <= 22) {
+        double result = (double) mantissa;
+
+        if (exponent < 0) result /= ___parse_powers[-exponent];
+        else result *= ___parse_powers[exponent];
+
+        *value = negative ? -result : result;
+        return NULL;
+    }
+#endif
+
+    return ___parse_double_slow(text, i, value);
+}
+
+Result(double) ___result_parse_double(int src_line, char* src_file,
+                                      const char* src_function,
+                                      const char* text, size_t length,
+                                      size_t* consumed)
+{
+    size_t ignored;
+    if (consumed == NULL) consumed = &ignored;
+
+    double value;
+    const Error* error = ___parse_double(text, length, &value, consumed);
+
+    return ___RESULT_double_declare(error, src_line, src_file, src_function,
+                                    value);
+}
+
+/*
+    The numbers end at the first character that is not a part of them, so
+    parsing finds the delimiters on the way, and the text is read only once.
+*/
+#define ___PARSE_DEFINE_COLUMN(type, parse)                                     \
+    Result(size_t) ___result_parse_## type ##_column(int src_line,              \
+                                                     char* src_file,            \
+                                                     const char* src_function,  \
+                                                     const char* text,          \
+                                                     size_t length,             \
+                                                     char delimiter,            \
+                                                     type* out, size_t count,   \
+                                                     size_t* consumed)          \
+    {                                                                           \
+        size_t ignored;                                                         \
+        if (consumed == NULL) consumed = &ignored;                              \
+                                                                                \
+        size_t offset = 0;                                                      \
+        size_t field = 0;                                                       \
+        const Error* error = NULL;                                              \
+                                                                                \
+        while (field < count && offset < length) {                              \
+            size_t taken = 0;                                                   \
+            error = text[offset] == delimiter                                   \
+                ? ERR(ParseEmpty)                                               \
+                : parse(text + offset, length - offset, &out[field], &taken);   \
+                                                                                \
+            offset += taken;                                                    \
+                                                                                \
+            if (error == NULL && offset < length && text[offset] != delimiter)  \
+                error = ERR(ParseInvalidDigit);                                 \
+                                                                                \
+            if (___RESULT_UNLIKELY(error != NULL)) break;                       \
+                                                                                \
+            if (++field == count || offset == length) break;                    \
+                                                                                \
+            /* A delimiter always starts another field */                       \
+            if (___RESULT_UNLIKELY(++offset == length)) {                       \
+                error = ERR(ParseEmpty);                                        \
+                break;                                                          \
+            }                                                                   \
+        }                                                                       \
+                                                                                \
+        *consumed = offset;                                                     \
+                                                                                \
+        return ___RESULT_size_t_declare(error, src_line, src_file,              \
+                                        src_function, field);                   \
+    }                                                                           \
+
+static inline const Error* ___parse_int64_t(const char* text, size_t length,
+                                            int64_t* value, size_t* consumed)
+{
+    uint64_t parsed;
+    const Error* error = ___parse_signed(text, length, INT64_MAX, &parsed,
+                                         consumed);
+
+    *value = (int64_t) parsed;
+    return error;
+}
+
+static inline const Error* ___parse_uint64_t(const char* text, size_t length,
+                                             uint64_t* value, size_t* consumed)
+{
+    return ___parse_unsigned(text, length, UINT64_MAX, value, consumed);
+}
+
+___PARSE_DEFINE_COLUMN(int64_t, ___parse_int64_t)
+___PARSE_DEFINE_COLUMN(uint64_t, ___parse_uint64_t)
+___PARSE_DEFINE_COLUMN(double, ___parse_double)
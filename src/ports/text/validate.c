@@ -0,0 +1,415 @@
+/*
+    PORTS/VALIDATE.C - Validating untrusted text
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <ports/text/validate.h>
+#include <compiler.h>
+#include <error.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ___TEXT_X86
+#include <immintrin.h>
+#endif
+
+ERROR_DEFINE_WITH_KIND(InvalidUtf8,         ERROR_KIND(InvalidText),    InvalidRequestExitCode, "The text is not valid UTF-8.")
+ERROR_DEFINE_WITH_KIND(NonAsciiCharacter,   ERROR_KIND(InvalidText),    InvalidRequestExitCode, "The text contains a character outside of ASCII.")
+ERROR_DEFINE_WITH_KIND(UnexpectedNulByte,   ERROR_KIND(InvalidText),    InvalidRequestExitCode, "The text contains a NUL byte.")
+
+typedef size_t (*___TEXT_KERNEL)(const unsigned char* text, size_t length);
+
+#define ___TEXT_HIGH_BITS 0x8080808080808080u
+
+static inline uint64_t ___text_load8(const unsigned char* text)
+{
+    uint64_t word;
+
+    memcpy(&word, text, sizeof(word));
+    return word;
+}
+
+/* Scalar kernels, also used for the tails and to locate the exact offset */
+
+static size_t ___text_ascii_scalar(const unsigned char* text, size_t length)
+{
+    size_t i = 0;
+
+    for (; length - i >= 8; i += 8)
+        if (___text_load8(text + i) & ___TEXT_HIGH_BITS) break;
+
+    for (; i < length; i++)
+        if (text[i] >= 0x80) break;
+
+    return i;
+}
+
+static size_t ___text_utf8_scalar(const unsigned char* text, size_t length)
+{
+    size_t i = 0;
+
+    while (i < length) {
+        if (length - i >= 8 && !(___text_load8(text + i) & ___TEXT_HIGH_BITS)) {
+            i += 8;
+            continue;
+        }
+
+        unsigned char lead = text[i];
+
+        if (lead < 0x80) {
+            i++;
+            continue;
+        }
+
+        /* The second byte has a narrower range after some of the leads */
+        unsigned char low = 0x80, high = 0xBF;
+        size_t size;
+
+        if (lead < 0xC2) return i;
+        else if (lead < 0xE0) size = 2;
+        else if (lead < 0xF0) {
+            size = 3;
+            if (lead == 0xE0) low = 0xA0;
+            if (lead == 0xED) high = 0x9F;
+        } else if (lead < 0xF5) {
+            size = 4;
+            if (lead == 0xF0) low = 0x90;
+            if (lead == 0xF4) high = 0x8F;
+        } else return i;
+
+        if (length - i < size) return i;
+        if (text[i + 1] < low || text[i + 1] > high) return i;
+
+        for (size_t j = 2; j < size; j++)
+            if ((text[i + j] & 0xC0) != 0x80) return i;
+
+        i += size;
+    }
+
+    return length;
+}
+
+/*
+    Goes back from a block to the last lead byte before it, the sequence it
+    starts can cross into the block, or be cut short right before it.
+*/
+static size_t ___text_utf8_boundary(const unsigned char* text, size_t offset)
+{
+    for (size_t i = 1; i <= 3 && i <= offset; i++) {
+        unsigned char byte = text[offset - i];
+
+        if (byte >= 0xC0) return offset - i;
+        if (byte < 0x80) break;
+    }
+
+    return offset;
+}
+
+static size_t ___text_utf8_resume(const unsigned char* text, size_t length,
+                                  size_t offset)
+{
+    offset = ___text_utf8_boundary(text, offset);
+    return offset + ___text_utf8_scalar(text + offset, length - offset);
+}
+
+static size_t ___text_nul(const unsigned char* text, size_t length)
+{
+    /* memchr is vectorized, and dispatched by the cpu in libc already */
+    const unsigned char* nul = memchr(text, 0, length);
+
+    return nul == NULL ? length : (size_t) (nul - text);
+}
+
+#ifdef ___TEXT_X86
+
+__attribute__((target("sse2")))
+static size_t ___text_ascii_sse2(const unsigned char* text, size_t length)
+{
+    size_t i = 0;
+
+    for (; length - i >= 64; i += 64) {
+        __m128i a = _mm_loadu_si128((const __m128i*) (text + i));
+        __m128i b = _mm_loadu_si128((const __m128i*) (text + i + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*) (text + i + 32));
+        __m128i d = _mm_loadu_si128((const __m128i*) (text + i + 48));
+
+        if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b),
+                                           _mm_or_si128(c, d))))
+            break;
+    }
+
+    return i + ___text_ascii_scalar(text + i, length - i);
+}
+
+__attribute__((target("avx2")))
+static size_t ___text_ascii_avx2(const unsigned char* text, size_t length)
+{
+    size_t i = 0;
+
+    for (; length - i >= 128; i += 128) {
+        __m256i a = _mm256_loadu_si256((const __m256i*) (text + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*) (text + i + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i*) (text + i + 64));
+        __m256i d = _mm256_loadu_si256((const __m256i*) (text + i + 96));
+
+        if (_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(a, b),
+                                                 _mm256_or_si256(c, d))))
+            break;
+    }
+
+    return i + ___text_ascii_scalar(text + i, length - i);
+}
+
+/*
+    UTF-8 validation with lookup tables, as in "Validating UTF-8 In Less Than
+    One Instruction Per Byte", J. Keiser, D. Lemire, 2021. Every pair of bytes
+    is classified by the high nibble of the first one, its low nibble, and the
+    high nibble of the second one. The three lookups share a bit only for an
+    invalid pair. The third and fourth bytes of the sequences are checked by
+    the positions of the leads.
+
+    The blocks only tell if there is an error, the scalar kernel then finds it
+    from the start of the block.
+*/
+#define ___TEXT_TOO_SHORT       (1 << 0)
+#define ___TEXT_TOO_LONG        (1 << 1)
+#define ___TEXT_OVERLONG_3      (1 << 2)
+#define ___TEXT_TOO_LARGE       (1 << 3)
+#define ___TEXT_SURROGATE       (1 << 4)
+#define ___TEXT_OVERLONG_2      (1 << 5)
+#define ___TEXT_TOO_LARGE_1000  (1 << 6)
+#define ___TEXT_OVERLONG_4      (1 << 6)
+#define ___TEXT_TWO_CONTS       (1 << 7)
+#define ___TEXT_CARRY           (___TEXT_TOO_SHORT | ___TEXT_TOO_LONG |         \
+                                 ___TEXT_TWO_CONTS)
+
+#define ___TEXT_TABLE(...) _mm256_setr_epi8(__VA_ARGS__, __VA_ARGS__)
+
+__attribute__((target("avx2")))
+static inline __m256i ___text_prev(__m256i input, __m256i previous, int count)
+{
+    __m256i shifted = _mm256_permute2x128_si256(previous, input, 0x21);
+
+    switch (count) {
+    case 1: return _mm256_alignr_epi8(input, shifted, 15);
+    case 2: return _mm256_alignr_epi8(input, shifted, 14);
+    default: return _mm256_alignr_epi8(input, shifted, 13);
+    }
+}
+
+__attribute__((target("avx2")))
+static inline __m256i ___text_high_nibbles(__m256i bytes)
+{
+    return _mm256_and_si256(_mm256_srli_epi16(bytes, 4), _mm256_set1_epi8(0x0F));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i ___text_utf8_errors(__m256i input, __m256i previous)
+{
+    const __m256i byte_1_high_table = ___TEXT_TABLE(
+        ___TEXT_TOO_LONG, ___TEXT_TOO_LONG, ___TEXT_TOO_LONG, ___TEXT_TOO_LONG,
+        ___TEXT_TOO_LONG, ___TEXT_TOO_LONG, ___TEXT_TOO_LONG, ___TEXT_TOO_LONG,
+        ___TEXT_TWO_CONTS, ___TEXT_TWO_CONTS, ___TEXT_TWO_CONTS,
+        ___TEXT_TWO_CONTS,
+        ___TEXT_TOO_SHORT | ___TEXT_OVERLONG_2,
+        ___TEXT_TOO_SHORT,
+        ___TEXT_TOO_SHORT | ___TEXT_OVERLONG_3 | ___TEXT_SURROGATE,
+        ___TEXT_TOO_SHORT | ___TEXT_TOO_LARGE | ___TEXT_TOO_LARGE_1000 |
+            ___TEXT_OVERLONG_4);
+
+    const __m256i byte_1_low_table = ___TEXT_TABLE(
+        ___TEXT_CARRY | ___TEXT_OVERLONG_3 | ___TEXT_OVERLONG_2 |
+            ___TEXT_OVERLONG_4,
+        ___TEXT_CARRY | ___TEXT_OVERLONG_2,
+        ___TEXT_CARRY,
+        ___TEXT_CARRY,
+        ___TEXT_CARRY | ___TEXT_TOO_LARGE,
+        ___TEXT_CARRY | ___TEXT_TOO_LARGE | ___TEXT_TOO_LARGE_1000,
+        ___TEXT_CARRY | ___TEXT_TOO_LARGE | ___TEXT_TOO_LARGE_1000,
+        ___TEXT_CARRY | ___TEXT_TOO_LARGE | ___TEXT_TOO_LARGE_1000,
+        ___TEXT_CARRY | ___TEXT_TOO_LARGE | ___TEXT_TOO_LARGE_1000,
+        ___TEXT_CARRY | ___TEXT_TOO_LARGE | ___TEXT_TOO_LARGE_1000,
+        ___TEXT_CARRY | ___TEXT_TOO_LARGE | ___TEXT_TOO_LARGE_1000,
+        ___TEXT_CARRY | ___TEXT_TOO_LARGE | ___TEXT_TOO_LARGE_1000,
+        ___TEXT_CARRY | ___TEXT_TOO_LARGE | ___TEXT_TOO_LARGE_1000,
+        ___TEXT_CARRY | ___TEXT_TOO_LARGE | ___TEXT_TOO_LARGE_1000 |
+            ___TEXT_SURROGATE,
+        ___TEXT_CARRY | ___TEXT_TOO_LARGE | ___TEXT_TOO_LARGE_1000,
+        ___TEXT_CARRY | ___TEXT_TOO_LARGE | ___TEXT_TOO_LARGE_1000);
+
+    const __m256i byte_2_high_table = ___TEXT_TABLE(
+        ___TEXT_TOO_SHORT, ___TEXT_TOO_SHORT, ___TEXT_TOO_SHORT,
+        ___TEXT_TOO_SHORT, ___TEXT_TOO_SHORT, ___TEXT_TOO_SHORT,
+        ___TEXT_TOO_SHORT, ___TEXT_TOO_SHORT,
+        ___TEXT_TOO_LONG | ___TEXT_OVERLONG_2 | ___TEXT_TWO_CONTS |
+            ___TEXT_OVERLONG_3 | ___TEXT_TOO_LARGE_1000 | ___TEXT_OVERLONG_4,
+        ___TEXT_TOO_LONG | ___TEXT_OVERLONG_2 | ___TEXT_TWO_CONTS |
+            ___TEXT_OVERLONG_3 | ___TEXT_TOO_LARGE,
+        ___TEXT_TOO_LONG | ___TEXT_OVERLONG_2 | ___TEXT_TWO_CONTS |
+            ___TEXT_SURROGATE | ___TEXT_TOO_LARGE,
+        ___TEXT_TOO_LONG | ___TEXT_OVERLONG_2 | ___TEXT_TWO_CONTS |
+            ___TEXT_SURROGATE | ___TEXT_TOO_LARGE,
+        ___TEXT_TOO_SHORT, ___TEXT_TOO_SHORT, ___TEXT_TOO_SHORT,
+        ___TEXT_TOO_SHORT);
+
+    __m256i prev1 = ___text_prev(input, previous, 1);
+
+    __m256i special = _mm256_and_si256(
+        _mm256_and_si256(
+            _mm256_shuffle_epi8(byte_1_high_table, ___text_high_nibbles(prev1)),
+            _mm256_shuffle_epi8(byte_1_low_table,
+                                _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)))),
+        _mm256_shuffle_epi8(byte_2_high_table, ___text_high_nibbles(input)));
+
+    /* The third and fourth bytes of a sequence have to be continuations */
+    __m256i third = _mm256_subs_epu8(___text_prev(input, previous, 2),
+                                     _mm256_set1_epi8((char) (0xE0 - 0x80)));
+    __m256i fourth = _mm256_subs_epu8(___text_prev(input, previous, 3),
+                                      _mm256_set1_epi8((char) (0xF0 - 0x80)));
+    __m256i continuation = _mm256_and_si256(_mm256_or_si256(third, fourth),
+                                            _mm256_set1_epi8((char) 0x80));
+
+    return _mm256_xor_si256(continuation, special);
+}
+
+/* The last bytes of a block start a sequence, that has to continue */
+__attribute__((target("avx2")))
+static inline __m256i ___text_utf8_incomplete(__m256i input)
+{
+    const __m256i max = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char) (0xF0 - 1), (char) (0xE0 - 1), (char) (0xC0 - 1));
+
+    return _mm256_subs_epu8(input, max);
+}
+
+__attribute__((target("avx2")))
+static size_t ___text_utf8_avx2(const unsigned char* text, size_t length)
+{
+    __m256i previous = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; length - i >= 64; i += 64) {
+        __m256i a = _mm256_loadu_si256((const __m256i*) (text + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*) (text + i + 32));
+        __m256i errors;
+
+        if (!_mm256_movemask_epi8(_mm256_or_si256(a, b))) {
+            errors = incomplete;
+            incomplete = _mm256_setzero_si256();
+        } else {
+            errors = _mm256_or_si256(___text_utf8_errors(a, previous),
+                                     ___text_utf8_errors(b, a));
+            incomplete = ___text_utf8_incomplete(b);
+        }
+
+        if (!_mm256_testz_si256(errors, errors)) break;
+
+        previous = b;
+    }
+
+    return ___text_utf8_resume(text, length, i);
+}
+
+#endif
+
+/* Picks the kernels at the first call, racing threads pick the same ones */
+static size_t ___text_utf8_dispatch(const unsigned char* text, size_t length);
+static size_t ___text_ascii_dispatch(const unsigned char* text, size_t length);
+
+static ___TEXT_KERNEL ___text_utf8_kernel = &___text_utf8_dispatch;
+static ___TEXT_KERNEL ___text_ascii_kernel = &___text_ascii_dispatch;
+
+static size_t ___text_utf8_dispatch(const unsigned char* text, size_t length)
+{
+    ___TEXT_KERNEL kernel = &___text_utf8_scalar;
+
+#ifdef ___TEXT_X86
+    if (__builtin_cpu_supports("avx2")) kernel = &___text_utf8_avx2;
+#endif
+
+    __atomic_store_n(&___text_utf8_kernel, kernel, __ATOMIC_RELAXED);
+    return kernel(text, length);
+}
+
+static size_t ___text_ascii_dispatch(const unsigned char* text, size_t length)
+{
+    ___TEXT_KERNEL kernel = &___text_ascii_scalar;
+
+#ifdef ___TEXT_X86
+    if (__builtin_cpu_supports("avx2")) kernel = &___text_ascii_avx2;
+    else if (__builtin_cpu_supports("sse2")) kernel = &___text_ascii_sse2;
+#endif
+
+    __atomic_store_n(&___text_ascii_kernel, kernel, __ATOMIC_RELAXED);
+    return kernel(text, length);
+}
+
+static Result(size_t) ___text_result(int src_line, char* src_file,
+                                     const char* src_function, size_t offset,
+                                     size_t length, const Error* error)
+{
+    if (___RESULT_LIKELY(offset == length))
+        return (Result(size_t)) {
+            .value = length,
+            .error = NULL,
+            .src_file = src_file,
+            .src_line = src_line,
+            .src_function = src_function,
+        };
+
+    return ___RESULT_size_t_declare(error, src_line, src_file, src_function,
+                                    offset);
+}
+
+Result(size_t) ___text_validate_utf8(int src_line, char* src_file,
+                                     const char* src_function,
+                                     const char* text, size_t length)
+{
+    ___TEXT_KERNEL kernel = __atomic_load_n(&___text_utf8_kernel,
+                                            __ATOMIC_RELAXED);
+
+    return ___text_result(src_line, src_file, src_function,
+                          kernel((const unsigned char*) text, length), length,
+                          ERR(InvalidUtf8));
+}
+
+Result(size_t) ___text_validate_ascii(int src_line, char* src_file,
+                                      const char* src_function,
+                                      const char* text, size_t length)
+{
+    ___TEXT_KERNEL kernel = __atomic_load_n(&___text_ascii_kernel,
+                                            __ATOMIC_RELAXED);
+
+    return ___text_result(src_line, src_file, src_function,
+                          kernel((const unsigned char*) text, length), length,
+                          ERR(NonAsciiCharacter));
+}
+
+Result(size_t) ___text_validate_no_nul(int src_line, char* src_file,
+                                       const char* src_function,
+                                       const char* text, size_t length)
+{
+    return ___text_result(src_line, src_file, src_function,
+                          ___text_nul((const unsigned char*) text, length),
+                          length, ERR(UnexpectedNulByte));
+}
@@ -17,16 +17,126 @@
 */
 
 #include <result.h>
+#include <errorset.h>
 
+#include <limits.h>
 #include <wchar.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
-/* RESULT_DEFINE(void) */
-#define ___RESULT_void_declare(error, src_line, src_file, src_function, ...)    \
-    ___RESULT_void_declare_real(error, src_line, src_file, src_function)
+#ifdef RESULT_BACKTRACE
+#include <backtrace.h>
+#endif
+
+#include "usdt.h"
+
+void ___RESULT_panic_unwrap(int src_line, char* src_file,
+                            const char* src_function, const void* origin)
+{
+    Result(void) self;
+    memcpy(&self, origin, sizeof(self));
+
+    ___RESULT_USDT(unwrap_failed, self.error, self.error->message,
+                   self.error->exit_code, src_file, src_line, src_function,
+                   self.src_file, self.src_line);
+
+#ifdef RESULT_BACKTRACE
+    ___result_backtrace_panicking(self.error);
+#endif
+
+    ___result_panic(panic_function,
+                    src_line,
+                    src_file,
+                    src_function,
+                    self.error->exit_code,
+                    "Tried to unwrap from an error result."
+                    "\n\tError: %s (from %s at %s:%d)",
+                    self.error->message,
+                    self.src_function,
+                    self.src_file,
+                    self.src_line
+        );
+
+#ifdef RESULT_PANIC_NORETURN
+    exit(self.error->exit_code);
+#endif
+}
+
+void ___RESULT_panic_expect(int src_line, char* src_file,
+                            const char* src_function, const void* origin,
+                            const char* error)
+{
+    Result(void) self;
+    memcpy(&self, origin, sizeof(self));
+
+    ___RESULT_USDT(expect_failed, self.error, error, self.error->exit_code,
+                   src_file, src_line, src_function, self.src_file,
+                   self.src_line);
+
+#ifdef RESULT_BACKTRACE
+    ___result_backtrace_panicking(self.error);
+#endif
+
+    ___result_panic(panic_function,
+                    src_line,
+                    src_file,
+                    src_function,
+                    6,
+                    "%s: %s (from %s at %s:%d)",
+                    error,
+                    self.error->message,
+                    self.src_function,
+                    self.src_file,
+                    self.src_line
+        );
+
+#ifdef RESULT_PANIC_NORETURN
+    exit(6);
+#endif
+}
+
+void ___RESULT_panic_unwrap_err(int src_line, char* src_file,
+                                const char* src_function)
+{
+    ___RESULT_USDT(unwrap_failed, NULL, NULL, 0, src_file, src_line,
+                   src_function, NULL, 0);
+
+    ___result_panic(panic_function,
+                    src_line,
+                    src_file,
+                    src_function,
+                    6,
+                    "Tried to unwrap an error from an ok result."
+        );
+
+#ifdef RESULT_PANIC_NORETURN
+    exit(6);
+#endif
+}
+
+void ___RESULT_panic_expect_err(int src_line, char* src_file,
+                                const char* src_function, const char* error)
+{
+    ___RESULT_USDT(expect_failed, NULL, error, 0, src_file, src_line,
+                   src_function, NULL, 0);
+
+    ___result_panic(panic_function,
+                    src_line,
+                    src_file,
+                    src_function,
+                    6,
+                    "%s",
+                    error
+        );
 
+#ifdef RESULT_PANIC_NORETURN
+    exit(6);
+#endif
+}
+
+/* RESULT_DEFINE(void) */
 Result(void) ___RESULT_void_declare_real(const Error* error,
                                          int src_line, char* src_file,
                                          const char* src_function)
@@ -38,6 +148,8 @@ Result(void) ___RESULT_void_declare_real(const Error* error,
         .src_function = src_function,
     };
 
+    ___RESULT_ERROR_HOOK(error, src_line, src_file, src_function);
+
     return result;
 }
 
@@ -45,17 +157,7 @@ void ___RESULT_void_unwrap(int src_line, char* src_file,
                            const char* src_function, Result(void) self)
 {
     if (is_err(self))
-        panic_function(src_line,
-                       src_file,
-                       src_function,
-                       self.error->exit_code,
-                       "Tried to unwrap from an error result."
-                       "\n\tError: %s (from %s at %s:%d)",
-                       self.error->message,
-                       self.src_function,
-                       self.src_file,
-                       self.src_line
-            );
+        ___RESULT_panic_unwrap(src_line, src_file, src_function, &self.error);
 }
 
 void ___RESULT_void_unwrap_or(Result(void) result)
@@ -68,17 +170,8 @@ void ___RESULT_void_expect(int src_line, char* src_file,
                            const char* error)
 {
     if (is_err(self))
-        panic_function(src_line,
-                       src_file,
-                       src_function,
-                       6,
-                       "%s: %s (from %s at %s:%d)",
-                       error,
-                       self.error->message,
-                       self.src_function,
-                       self.src_file,
-                       self.src_line
-            );
+        ___RESULT_panic_expect(src_line, src_file, src_function, &self.error,
+                               error);
 }
 
 const Error* ___RESULT_void_expect_err(int src_line, char* src_file,
@@ -87,13 +180,7 @@ const Error* ___RESULT_void_expect_err(int src_line, char* src_file,
                                        const char* error)
 {
     if (is_ok(self))
-        panic_function(src_line,
-                       src_file,
-                       src_function,
-                       6,
-                       "%s",
-                       error
-            );
+        ___RESULT_panic_expect_err(src_line, src_file, src_function, error);
 
     return self.error;
 }
@@ -103,12 +190,7 @@ const Error* ___RESULT_void_unwrap_err(int src_line, char* src_file,
                                        Result(void) self)
 {
     if (is_ok(self))
-        panic_function(src_line,
-                       src_file,
-                       src_function,
-                       6,
-                       "Tried to unwrap an error from an ok result."
-            );
+        ___RESULT_panic_unwrap_err(src_line, src_file, src_function);
 
     return self.error;
 }
@@ -173,39 +255,109 @@ bool ___RESULT_void_is_ok_and(Result(void) self, bool (*c)(void))
     return is_ok(self) && (*c)();
 }
 
-RESULT_DEFINE(char)
+Result(void) ___RESULT_void_retry(const RetryPolicy* policy, RetryStats* stats,
+                                  Result(void) (*c)(void*), void* context)
+{
+    ___RESULT_RETRY_STATE state;
+    Result(void) result;
+
+    ___result_retry_begin(policy, &state);
+    do
+        result = (*c)(context);
+    while (___result_retry_again(policy, &state, result.error));
+    ___result_retry_end(&state, stats);
+
+    return result;
+}
+
+/*
+    Every value representation gets a single implementation, the remaining
+    types with the same size and signedness alias it (see RESULT_DEFINE_ALIAS).
+*/
 RESULT_DEFINE(char_ptr)
+RESULT_DEFINE(bool)
 RESULT_DEFINE(int8_t)
 RESULT_DEFINE(int16_t)
 RESULT_DEFINE(int32_t)
 RESULT_DEFINE(int64_t)
-RESULT_DEFINE(int_fast8_t)
-RESULT_DEFINE(int_fast16_t)
-RESULT_DEFINE(int_fast32_t)
-RESULT_DEFINE(int_fast64_t)
-RESULT_DEFINE(int_least8_t)
-RESULT_DEFINE(int_least16_t)
-RESULT_DEFINE(int_least32_t)
-RESULT_DEFINE(int_least64_t)
-RESULT_DEFINE(intmax_t)
-RESULT_DEFINE(intptr_t)
 RESULT_DEFINE(uint8_t)
 RESULT_DEFINE(uint16_t)
 RESULT_DEFINE(uint32_t)
 RESULT_DEFINE(uint64_t)
-RESULT_DEFINE(uint_fast8_t)
-RESULT_DEFINE(uint_fast16_t)
-RESULT_DEFINE(uint_fast32_t)
-RESULT_DEFINE(uint_fast64_t)
-RESULT_DEFINE(uint_least8_t)
-RESULT_DEFINE(uint_least16_t)
-RESULT_DEFINE(uint_least32_t)
-RESULT_DEFINE(uint_least64_t)
-RESULT_DEFINE(uintmax_t)
-RESULT_DEFINE(uintptr_t)
-RESULT_DEFINE(bool)
-RESULT_DEFINE(int)
-RESULT_DEFINE(short)
-RESULT_DEFINE(size_t)
-RESULT_DEFINE(ptrdiff_t)
-RESULT_DEFINE(wchar_t)
+RESULT_DEFINE(float)
+RESULT_DEFINE(double)
+RESULT_DEFINE(str_slice)
+
+/* The aliases differ from their targets in the value type only */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wattribute-alias"
+#endif
+
+RESULT_DEFINE_ALIAS(void_ptr, char_ptr)
+RESULT_DEFINE_ALIAS(ErrorSet_ptr, char_ptr)
+RESULT_DEFINE_ALIAS(byte_slice, str_slice)
+
+/*
+    Picks the exact-width type to alias by the width the compiler predefines
+    for the type (__INT_WIDTH__ and friends), and its signedness.
+*/
+#ifdef __INT_WIDTH__
+#define ___RESULT_ALIAS_WIDTH(type, sign, width)                                \
+    RESULT_DEFINE_ALIAS(type, sign ## width ## _t)
+#define ___RESULT_ALIAS_INT(type, width) ___RESULT_ALIAS_WIDTH(type, int, width)
+#define ___RESULT_ALIAS_UINT(type, width)                                       \
+    ___RESULT_ALIAS_WIDTH(type, uint, width)
+#else
+#define ___RESULT_ALIAS_INT(type, width) RESULT_DEFINE(type)
+#define ___RESULT_ALIAS_UINT(type, width) RESULT_DEFINE(type)
+#endif
+
+#if CHAR_MIN < 0
+RESULT_DEFINE_ALIAS(char, int8_t)
+#else
+RESULT_DEFINE_ALIAS(char, uint8_t)
+#endif
+
+___RESULT_ALIAS_INT(int_fast8_t, __INT_FAST8_WIDTH__)
+___RESULT_ALIAS_INT(int_fast16_t, __INT_FAST16_WIDTH__)
+___RESULT_ALIAS_INT(int_fast32_t, __INT_FAST32_WIDTH__)
+___RESULT_ALIAS_INT(int_fast64_t, __INT_FAST64_WIDTH__)
+___RESULT_ALIAS_INT(int_least8_t, __INT_LEAST8_WIDTH__)
+___RESULT_ALIAS_INT(int_least16_t, __INT_LEAST16_WIDTH__)
+___RESULT_ALIAS_INT(int_least32_t, __INT_LEAST32_WIDTH__)
+___RESULT_ALIAS_INT(int_least64_t, __INT_LEAST64_WIDTH__)
+___RESULT_ALIAS_INT(intmax_t, __INTMAX_WIDTH__)
+___RESULT_ALIAS_INT(intptr_t, __INTPTR_WIDTH__)
+___RESULT_ALIAS_INT(int, __INT_WIDTH__)
+___RESULT_ALIAS_INT(short, __SHRT_WIDTH__)
+___RESULT_ALIAS_INT(ptrdiff_t, __PTRDIFF_WIDTH__)
+___RESULT_ALIAS_INT(long, __LONG_WIDTH__)
+___RESULT_ALIAS_INT(long_long, __LONG_LONG_WIDTH__)
+
+___RESULT_ALIAS_UINT(uint_fast8_t, __INT_FAST8_WIDTH__)
+___RESULT_ALIAS_UINT(uint_fast16_t, __INT_FAST16_WIDTH__)
+___RESULT_ALIAS_UINT(uint_fast32_t, __INT_FAST32_WIDTH__)
+___RESULT_ALIAS_UINT(uint_fast64_t, __INT_FAST64_WIDTH__)
+___RESULT_ALIAS_UINT(uint_least8_t, __INT_LEAST8_WIDTH__)
+___RESULT_ALIAS_UINT(uint_least16_t, __INT_LEAST16_WIDTH__)
+___RESULT_ALIAS_UINT(uint_least32_t, __INT_LEAST32_WIDTH__)
+___RESULT_ALIAS_UINT(uint_least64_t, __INT_LEAST64_WIDTH__)
+___RESULT_ALIAS_UINT(uintmax_t, __INTMAX_WIDTH__)
+___RESULT_ALIAS_UINT(uintptr_t, __INTPTR_WIDTH__)
+___RESULT_ALIAS_UINT(size_t, __SIZE_WIDTH__)
+___RESULT_ALIAS_UINT(unsigned_char, __SCHAR_WIDTH__)
+___RESULT_ALIAS_UINT(unsigned_short, __SHRT_WIDTH__)
+___RESULT_ALIAS_UINT(unsigned_int, __INT_WIDTH__)
+___RESULT_ALIAS_UINT(unsigned_long, __LONG_WIDTH__)
+___RESULT_ALIAS_UINT(unsigned_long_long, __LONG_LONG_WIDTH__)
+
+#if WCHAR_MIN < 0
+___RESULT_ALIAS_INT(wchar_t, __WCHAR_WIDTH__)
+#else
+___RESULT_ALIAS_UINT(wchar_t, __WCHAR_WIDTH__)
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
@@ -0,0 +1,106 @@
+/*
+    RETRY.C - Repeating calls that fail with retryable errors
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <retry.h>
+#include <compiler.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "clock.h"
+
+/* splitmix64, the state lives in the caller, so there is nothing to lock */
+static uint64_t ___result_retry_random(uint64_t* seed)
+{
+    uint64_t z = (*seed += 0x9e3779b97f4a7c15u);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+    return z ^ (z >> 31);
+}
+
+void ___result_retry_begin(const RetryPolicy* policy,
+                           ___RESULT_RETRY_STATE* state)
+{
+    state->attempts = 0;
+    state->waits = 0;
+    state->started_ns = ___result_clock_ns();
+    state->slept_ns = 0;
+    state->backoff_ns = policy->initial_backoff_ns;
+    state->seed = state->started_ns ^ (uint64_t) (uintptr_t) state;
+}
+
+bool ___result_retry_again(const RetryPolicy* policy,
+                           ___RESULT_RETRY_STATE* state, const Error* error)
+{
+    state->attempts++;
+
+    if (___RESULT_LIKELY(error == NULL)) return false;
+    if (!error_is_kind(error, Retryable)) return false;
+    if (policy->max_attempts != 0 && state->attempts >= policy->max_attempts)
+        return false;
+
+    uint64_t elapsed = 0;
+    if (policy->deadline_ns != 0) {
+        elapsed = ___result_clock_ns() - state->started_ns;
+
+        if (elapsed >= policy->deadline_ns) return false;
+    }
+
+    /* Interrupted calls don't wait for anything */
+    if (!error_is_kind(error, Transient)) return true;
+
+    unsigned int wait = state->waits++;
+
+    if (wait < policy->spin_attempts) {
+        ___RESULT_CPU_RELAX();
+        return true;
+    }
+
+    if (wait < policy->spin_attempts + policy->yield_attempts) {
+        ___result_yield();
+        return true;
+    }
+
+    uint64_t sleep_ns = state->backoff_ns;
+    if (policy->jitter && sleep_ns != 0)
+        sleep_ns = ___result_retry_random(&state->seed) % (sleep_ns + 1);
+
+    if (policy->deadline_ns != 0 && elapsed + sleep_ns >= policy->deadline_ns)
+        return false;
+
+    ___result_sleep_ns(sleep_ns);
+    state->slept_ns += sleep_ns;
+
+    uint64_t next = state->backoff_ns * policy->backoff_multiplier;
+    if (next > policy->max_backoff_ns || next < state->backoff_ns)
+        next = policy->max_backoff_ns;
+    state->backoff_ns = next;
+
+    return true;
+}
+
+void ___result_retry_end(const ___RESULT_RETRY_STATE* state,
+                         RetryStats* stats)
+{
+    if (stats == NULL) return;
+
+    stats->attempts = state->attempts;
+    stats->elapsed_ns = ___result_clock_ns() - state->started_ns;
+    stats->slept_ns = state->slept_ns;
+}
@@ -0,0 +1,195 @@
+/*
+    STATS.C - Error counters shared with other processes
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stats.h>
+#include <hooks.h>
+#include <ports/ports.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Slots probed before an error or an exit code is dropped */
+#define ___RESULT_STATS_PROBES 32
+
+static _Atomic(ResultStatsMap*) ___result_stats_map = NULL;
+static int ___result_stats_fd = -1;
+static char ___result_stats_name[256];
+
+#define ___STATS_ERR(error)                                                     \
+    ___RESULT_ERR_RAW(int, ____result_bind_errno_to_error(error))
+
+static inline uint64_t ___result_stats_hash(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdu;
+    return key ^ (key >> 33);
+}
+
+/*
+    Finds the slot of the key, or claims an empty one (and sets claimed),
+    the slot is NULL when the probes ran out.
+*/
+#define ___STATS_SLOT(slots, size, wanted, slot, claimed)                       \
+    do {                                                                        \
+        uint64_t ___index = ___result_stats_hash(wanted);                       \
+                                                                                \
+        slot = NULL;                                                            \
+        claimed = false;                                                        \
+        for (int ___probe = 0; ___probe < ___RESULT_STATS_PROBES; ___probe++) { \
+            __typeof__(&(slots)[0]) ___slot = &(slots)[___index++ & (size - 1)];\
+            uint64_t ___key = atomic_load_explicit(&___slot->key,               \
+                                                   memory_order_acquire);       \
+                                                                                \
+            if (___key == 0                                                     \
+                && atomic_compare_exchange_strong_explicit(                     \
+                       &___slot->key, &___key, wanted, memory_order_acq_rel,    \
+                       memory_order_acquire)) {                                 \
+                slot = ___slot;                                                 \
+                claimed = true;                                                 \
+                break;                                                          \
+            }                                                                   \
+                                                                                \
+            if (___key == (wanted)) {                                           \
+                slot = ___slot;                                                 \
+                break;                                                          \
+            }                                                                   \
+        }                                                                       \
+    } while (0)
+
+void ___result_stats_error(const Error* error)
+{
+    ResultStatsMap* map = atomic_load_explicit(&___result_stats_map,
+                                               memory_order_acquire);
+    if (map == NULL) return;
+
+    uint64_t key = (uint64_t) (uintptr_t) error;
+    ResultStatsError* slot;
+    bool claimed;
+    ___STATS_SLOT(map->errors, RESULT_STATS_ERRORS, key, slot, claimed);
+
+    if (slot != NULL) {
+        /* Readers skip the slot until the claimer describes the error */
+        if (___RESULT_UNLIKELY(claimed)) {
+            slot->exit_code = error->exit_code;
+            strncpy(slot->message, error->message,
+                    RESULT_STATS_MESSAGE_SIZE - 1);
+            atomic_store_explicit(&slot->ready, 1, memory_order_release);
+        }
+
+        atomic_fetch_add_explicit(&slot->count, 1, memory_order_relaxed);
+    } else {
+        atomic_fetch_add_explicit(&map->dropped, 1, memory_order_relaxed);
+    }
+
+    ResultStatsExitCode* code;
+    key = (uint32_t) error->exit_code | (uint64_t) 1 << 32;
+    ___STATS_SLOT(map->exit_codes, RESULT_STATS_EXIT_CODES, key, code, claimed);
+
+    if (code != NULL)
+        atomic_fetch_add_explicit(&code->count, 1, memory_order_relaxed);
+}
+
+Result(int) result_stats_export(const char* name)
+{
+    if (atomic_load(&___result_stats_map) != NULL)
+        return result_ERR(int, AlreadyInProgress);
+
+    int fd;
+
+    if (name == NULL) {
+#if defined(__linux__)
+        fd = memfd_create("result-stats", MFD_CLOEXEC);
+#else
+        return result_ERR(int, NotSupported);
+#endif
+    } else {
+        if (strlen(name) >= sizeof(___result_stats_name))
+            return result_ERR(int, FileNameTooLong);
+
+        fd = shm_open(name, O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+    }
+
+    if (fd < 0) return ___STATS_ERR(errno);
+
+    ResultStatsMap* map = MAP_FAILED;
+
+    if (ftruncate(fd, sizeof(ResultStatsMap)) == 0)
+        map = mmap(NULL, sizeof(ResultStatsMap), PROT_READ | PROT_WRITE,
+                   MAP_SHARED, fd, 0);
+
+    if (map == MAP_FAILED) {
+        int c_err = errno;
+
+        close(fd);
+        if (name != NULL) shm_unlink(name);
+        return ___STATS_ERR(c_err);
+    }
+
+    /* An existing object can hold the counters of an earlier process */
+    memset(map, 0, sizeof(*map));
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    map->major = RESULT_STATS_MAJOR;
+    map->minor = RESULT_STATS_MINOR;
+    map->size = sizeof(ResultStatsMap);
+    map->errors_size = RESULT_STATS_ERRORS;
+    map->exit_codes_size = RESULT_STATS_EXIT_CODES;
+    map->pid = (int64_t) getpid();
+    map->started_ns = (uint64_t) now.tv_sec * 1000000000u
+                      + (uint64_t) now.tv_nsec;
+    atomic_store_explicit(&map->magic, RESULT_STATS_MAGIC,
+                          memory_order_release);
+
+    ___result_stats_fd = fd;
+    if (name != NULL) strcpy(___result_stats_name, name);
+
+    atomic_store_explicit(&___result_stats_map, map, memory_order_release);
+    __atomic_fetch_or(&___result_hooks, ___RESULT_HOOK_STATS, __ATOMIC_RELAXED);
+
+    return result_OK(int, fd);
+}
+
+void result_stats_unexport(void)
+{
+    __atomic_fetch_and(&___result_hooks, ~___RESULT_HOOK_STATS,
+                       __ATOMIC_RELAXED);
+
+    /* Threads may still be counting, so the mapping is never unmapped */
+    if (atomic_exchange(&___result_stats_map, NULL) == NULL) return;
+
+    if (___result_stats_name[0] != '\0') shm_unlink(___result_stats_name);
+    ___result_stats_name[0] = '\0';
+
+    close(___result_stats_fd);
+    ___result_stats_fd = -1;
+}
@@ -0,0 +1,121 @@
+/*
+    STATSMAP.C - Reader of the error counters of other processes
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <statsmap.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+    The reader is a library of its own, it doesn't link with libresult, so a
+    monitor carries none of the hooks. Its errors and results are built here,
+    without the errno bindings of the ports and without the error hooks.
+*/
+ERROR_DEFINE(StatsLayoutMismatch,   InvalidRequestExitCode,     "The shared statistics have an unknown layout.")
+ERROR_DEFINE(StatsNotFound,         FileOperationFailedExitCode, "There are no shared statistics by that name.")
+ERROR_DEFINE(StatsAccessDenied,     PermissionErrorExitCode,    "The shared statistics can't be read with these permissions.")
+ERROR_DEFINE(StatsUnavailable,      OtherErrorExitCode,         "The shared statistics couldn't be mapped.")
+
+#define ___STATS_RESULT(result_error)                                           \
+    (Result(void)) {                                                            \
+        .error = (result_error),                                                \
+        .src_file = __FILE__,                                                   \
+        .src_line = __LINE__,                                                   \
+        .src_function = __func__,                                               \
+    }                                                                           \
+
+static const Error* ___stats_errno_error(int c_err)
+{
+    switch (c_err) {
+    case ENOENT:
+    case ENAMETOOLONG:
+    case ENOTDIR:
+        return ERR(StatsNotFound);
+    case EACCES:
+    case EPERM:
+        return ERR(StatsAccessDenied);
+    default:
+        return ERR(StatsUnavailable);
+    }
+}
+
+Result(void) result_stats_attach(ResultStatsReader* reader, const char* name)
+{
+    /* A name is a single component starting with a slash, like shm_open */
+    bool shared = name[0] == '/' && strchr(name + 1, '/') == NULL;
+    int fd = shared ? shm_open(name, O_RDONLY | O_CLOEXEC, 0)
+                    : open(name, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+        return ___STATS_RESULT(___stats_errno_error(errno));
+
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        int c_err = errno;
+
+        close(fd);
+        return ___STATS_RESULT(___stats_errno_error(c_err));
+    }
+
+    /* Later minor versions only add fields, the map can be larger than ours */
+    if ((size_t) status.st_size < RESULT_STATS_SIZE_1_0) {
+        close(fd);
+        return ___STATS_RESULT(ERR(StatsLayoutMismatch));
+    }
+
+    void* map = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_SHARED, fd,
+                     0);
+    int c_err = errno;
+    close(fd);
+
+    if (map == MAP_FAILED)
+        return ___STATS_RESULT(___stats_errno_error(c_err));
+
+    const ResultStatsMap* stats = map;
+
+    if (atomic_load_explicit(&stats->magic, memory_order_acquire)
+            != RESULT_STATS_MAGIC
+        || stats->major != RESULT_STATS_MAJOR
+        || stats->size < RESULT_STATS_SIZE_1_0
+        || stats->size > (size_t) status.st_size
+        || stats->errors_size != RESULT_STATS_ERRORS
+        || stats->exit_codes_size != RESULT_STATS_EXIT_CODES) {
+        munmap(map, (size_t) status.st_size);
+        return ___STATS_RESULT(ERR(StatsLayoutMismatch));
+    }
+
+    reader->map = stats;
+    reader->size = (size_t) status.st_size;
+
+    return ___STATS_RESULT(NULL);
+}
+
+void result_stats_detach(ResultStatsReader* reader)
+{
+    if (reader->map != NULL) munmap((void*) reader->map, reader->size);
+
+    reader->map = NULL;
+    reader->size = 0;
+}
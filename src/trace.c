@@ -0,0 +1,275 @@
+/*
+    TRACE.C - Sampled tracing of error results
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <trace.h>
+#include <hooks.h>
+#include <ports/ports.h>
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#include "clock.h"
+
+typedef struct {
+    uint64_t        timestamp_ns;
+    const Error*    error;
+    const char*     src_file;
+    const char*     src_function;
+    int             src_line;
+    uint32_t        thread_id;
+} ___RESULT_TRACE_RECORD;
+
+/*
+    Every thread writes to its own ring, and publishes records by bumping the
+    head. Readers copy the records, and drop the ones the writer could have
+    overwritten in the meantime. Rings of exited threads are reused.
+*/
+typedef struct ___RESULT_TRACE_RING {
+    struct ___RESULT_TRACE_RING*    next;
+    atomic_bool                     in_use;
+    _Atomic uint64_t                head;
+    ___RESULT_TRACE_RECORD          records[RESULT_TRACE_RING_SIZE];
+} ___RESULT_TRACE_RING;
+
+static _Atomic(___RESULT_TRACE_RING*) ___result_trace_rings = NULL;
+static atomic_uint ___result_trace_rate = 0;
+
+static _Thread_local ___RESULT_TRACE_RING* ___result_trace_ring = NULL;
+static _Thread_local unsigned int ___result_trace_countdown = 0;
+static _Thread_local uint32_t ___result_trace_thread_id = 0;
+
+static pthread_key_t ___result_trace_key;
+static pthread_once_t ___result_trace_once = PTHREAD_ONCE_INIT;
+
+static void ___result_trace_release(void* ring)
+{
+    atomic_store_explicit(&((___RESULT_TRACE_RING*) ring)->in_use, false,
+                          memory_order_release);
+}
+
+static void ___result_trace_init_key(void)
+{
+    pthread_key_create(&___result_trace_key, &___result_trace_release);
+}
+
+static uint32_t ___result_trace_current_thread(void)
+{
+#if defined(__linux__)
+    return (uint32_t) syscall(SYS_gettid);
+#else
+    return (uint32_t) (uintptr_t) pthread_self();
+#endif
+}
+
+static ___RESULT_TRACE_RING* ___result_trace_claim_ring(void)
+{
+    ___RESULT_TRACE_RING* ring = atomic_load_explicit(&___result_trace_rings,
+                                                      memory_order_acquire);
+
+    for (; ring != NULL; ring = ring->next) {
+        bool free = false;
+
+        if (atomic_compare_exchange_strong(&ring->in_use, &free, true)) break;
+    }
+
+    if (ring == NULL) {
+        ring = calloc(1, sizeof(*ring));
+        if (ring == NULL) return NULL;
+
+        atomic_init(&ring->in_use, true);
+        atomic_init(&ring->head, 0);
+
+        ring->next = atomic_load_explicit(&___result_trace_rings,
+                                          memory_order_relaxed);
+        while (!atomic_compare_exchange_weak(&___result_trace_rings,
+                                             &ring->next, ring));
+    }
+
+    pthread_once(&___result_trace_once, &___result_trace_init_key);
+    pthread_setspecific(___result_trace_key, ring);
+
+    ___result_trace_thread_id = ___result_trace_current_thread();
+    return ring;
+}
+
+void ___result_trace_error(const Error* error, int src_line,
+                           const char* src_file, const char* src_function)
+{
+    unsigned int rate = atomic_load_explicit(&___result_trace_rate,
+                                             memory_order_relaxed);
+    if (rate == 0) return;
+
+    if (___result_trace_countdown > 1) {
+        ___result_trace_countdown--;
+        return;
+    }
+    ___result_trace_countdown = rate;
+
+    ___RESULT_TRACE_RING* ring = ___result_trace_ring;
+    if (___RESULT_UNLIKELY(ring == NULL)) {
+        ring = ___result_trace_ring = ___result_trace_claim_ring();
+        if (ring == NULL) return;
+    }
+
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    ___RESULT_TRACE_RECORD* record = &ring->records[head % RESULT_TRACE_RING_SIZE];
+
+    record->timestamp_ns = ___result_clock_ns();
+    record->error = error;
+    record->src_file = src_file;
+    record->src_function = src_function;
+    record->src_line = src_line;
+    record->thread_id = ___result_trace_thread_id;
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void result_trace_start(unsigned int rate)
+{
+    atomic_store(&___result_trace_rate, rate);
+
+    if (rate == 0)
+        __atomic_fetch_and(&___result_hooks, ~___RESULT_HOOK_TRACE,
+                           __ATOMIC_RELAXED);
+    else
+        __atomic_fetch_or(&___result_hooks, ___RESULT_HOOK_TRACE,
+                          __ATOMIC_RELAXED);
+}
+
+void result_trace_stop(void)
+{
+    result_trace_start(0);
+}
+
+static size_t ___result_trace_collect(___RESULT_TRACE_RECORD* out, size_t size)
+{
+    size_t count = 0;
+
+    for (___RESULT_TRACE_RING* ring = atomic_load(&___result_trace_rings);
+         ring != NULL; ring = ring->next) {
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        uint64_t first = head > RESULT_TRACE_RING_SIZE
+                         ? head - RESULT_TRACE_RING_SIZE : 0;
+        size_t start = count;
+
+        for (uint64_t i = first; i < head && count < size; i++)
+            out[count++] = ring->records[i % RESULT_TRACE_RING_SIZE];
+
+        /* Drop the records overwritten while copying */
+        uint64_t now = atomic_load_explicit(&ring->head, memory_order_acquire);
+        uint64_t valid = now >= RESULT_TRACE_RING_SIZE
+                         ? now - RESULT_TRACE_RING_SIZE + 1 : 0;
+
+        if (valid > first) {
+            size_t drop = (size_t) (valid - first);
+            if (drop > count - start) drop = count - start;
+
+            for (size_t i = start; i + drop < count; i++) out[i] = out[i + drop];
+            count -= drop;
+        }
+    }
+
+    return count;
+}
+
+static int ___result_trace_compare(const void* a, const void* b)
+{
+    uint64_t x = ((const ___RESULT_TRACE_RECORD*) a)->timestamp_ns;
+    uint64_t y = ((const ___RESULT_TRACE_RECORD*) b)->timestamp_ns;
+
+    return (x > y) - (x < y);
+}
+
+static void ___result_trace_write_string(FILE* file, const char* string)
+{
+    fputc('"', file);
+
+    for (; string != NULL && *string != '\0'; string++) {
+        unsigned char c = (unsigned char) *string;
+
+        if (c == '"' || c == '\\') fprintf(file, "\\%c", c);
+        else if (c < 0x20) fprintf(file, "\\u%04x", c);
+        else fputc(c, file);
+    }
+
+    fputc('"', file);
+}
+
+Result(void) result_trace_dump(const char* path)
+{
+    size_t size = 0;
+
+    for (___RESULT_TRACE_RING* ring = atomic_load(&___result_trace_rings);
+         ring != NULL; ring = ring->next)
+        size += RESULT_TRACE_RING_SIZE;
+
+    ___RESULT_TRACE_RECORD* records = malloc((size ? size : 1) * sizeof(*records));
+    if (records == NULL) return result_ERR(void, NotEnoughMemory);
+
+    size_t count = ___result_trace_collect(records, size);
+    qsort(records, count, sizeof(*records), &___result_trace_compare);
+
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        int c_err = errno;
+
+        free(records);
+        return ___RESULT_ERR_RAW(void, ____result_bind_errno_to_error(c_err));
+    }
+
+    long pid = (long) getpid();
+
+    fprintf(file, "{\"traceEvents\":[");
+    for (size_t i = 0; i < count; i++) {
+        const ___RESULT_TRACE_RECORD* record = &records[i];
+
+        fprintf(file, "%s\n{\"name\":", i == 0 ? "" : ",");
+        ___result_trace_write_string(file, record->error->message);
+        fprintf(file,
+                ",\"cat\":\"error\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%llu.%03u,"
+                "\"pid\":%ld,\"tid\":%lu,\"args\":{\"exit_code\":%d,\"file\":",
+                (unsigned long long) (record->timestamp_ns / 1000),
+                (unsigned int) (record->timestamp_ns % 1000),
+                pid,
+                (unsigned long) record->thread_id,
+                record->error->exit_code);
+        ___result_trace_write_string(file, record->src_file);
+        fprintf(file, ",\"line\":%d,\"function\":", record->src_line);
+        ___result_trace_write_string(file, record->src_function);
+        fprintf(file, "}}");
+    }
+    fprintf(file, "\n],\"displayTimeUnit\":\"ns\"}\n");
+
+    free(records);
+
+    if (fclose(file) != 0)
+        return ___RESULT_ERR_RAW(void, ____result_bind_errno_to_error(errno));
+
+    return result_OK(void);
+}
@@ -0,0 +1,29 @@
+/*
+    USDT.C - Static tracepoints for bpftrace, perf and SystemTap
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "usdt.h"
+
+/* The tracer finds the semaphores through the notes of the probes */
+#define ___RESULT_USDT_SEMAPHORE(name)                                          \
+    __attribute__((section(".probes"))) unsigned short                          \
+    result_## name ##_semaphore = 0
+
+___RESULT_USDT_SEMAPHORE(error);
+___RESULT_USDT_SEMAPHORE(unwrap_failed);
+___RESULT_USDT_SEMAPHORE(expect_failed);
+___RESULT_USDT_SEMAPHORE(panic);
@@ -0,0 +1,64 @@
+/*
+    USDT.H - Static tracepoints for bpftrace, perf and SystemTap
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__USDT___
+#define ___RESULT__USDT___
+
+#include <hooks.h>
+
+/*
+    Probes of the "result" provider. Every probe has a semaphore, that the
+    tracer bumps while it's attached, and the arguments are only computed
+    when it's set. Without a tracer a probe costs a load and a not taken
+    branch, the probe itself is a nop.
+
+        error           error, message, exit code, file, line, function
+        unwrap_failed   error, message, exit code, file, line, function,
+                        origin file, origin line (NULL error for unwrap_err)
+        expect_failed   the same, with the message of the caller
+        panic           exit code, message, file, line, function
+
+    The names don't collide with the shortcuts, the probe macros would
+    expand them.
+*/
+#ifdef RESULT_USDT
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+extern unsigned short result_unwrap_failed_semaphore;
+extern unsigned short result_expect_failed_semaphore;
+extern unsigned short result_panic_semaphore;
+
+#define ___RESULT_USDT_ENABLED(name)                                            \
+    ___RESULT_UNLIKELY(___RESULT_LOAD_RELAXED(result_## name ##_semaphore) != 0)
+
+#define ___RESULT_USDT(name, ...)                                               \
+    do {                                                                        \
+        if (___RESULT_USDT_ENABLED(name))                                       \
+            STAP_PROBEV(result, name, __VA_ARGS__);                             \
+    } while (0)
+
+#else
+
+#define ___RESULT_USDT_ENABLED(name) 0
+#define ___RESULT_USDT(name, ...) ((void) 0)
+
+#endif
+
+#endif
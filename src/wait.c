@@ -0,0 +1,134 @@
+/*
+    WAIT.C - Blocking on atomic words
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/* syscall and the monotonic clock outside of the GNU dialects */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <wait.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "clock.h"
+
+uint64_t ___result_deadline(uint64_t timeout_ns)
+{
+    if (timeout_ns == RESULT_WAIT_FOREVER) return RESULT_WAIT_FOREVER;
+
+    uint64_t deadline = ___result_clock_ns() + timeout_ns;
+    return deadline < timeout_ns ? RESULT_WAIT_FOREVER : deadline;
+}
+
+/* The time left until the deadline, 0 when it passed */
+static uint64_t ___result_remaining(uint64_t deadline_ns)
+{
+    uint64_t now = ___result_clock_ns();
+    return deadline_ns > now ? deadline_ns - now : 0;
+}
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+bool ___result_wait(_Atomic uint32_t* word, uint32_t expected,
+                    uint64_t deadline_ns)
+{
+    if (deadline_ns == RESULT_WAIT_FOREVER) {
+        syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+        return true;
+    }
+
+    uint64_t timeout_ns = ___result_remaining(deadline_ns);
+    if (timeout_ns == 0) return false;
+
+    struct timespec timeout = {
+        .tv_sec = (time_t) (timeout_ns / 1000000000u),
+        .tv_nsec = (long) (timeout_ns % 1000000000u),
+    };
+
+    if (syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, expected, &timeout, NULL,
+                0) == -1 && errno == ETIMEDOUT)
+        return false;
+
+    return true;
+}
+
+void ___result_wake(_Atomic uint32_t* word)
+{
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, INT32_MAX, NULL, NULL, 0);
+}
+
+#else
+
+#include <pthread.h>
+
+/*
+    A single condition variable for all of the words. Wakes are rare (only
+    with waiters), and the waiters check their own word after waking.
+*/
+static pthread_mutex_t ___result_wait_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ___result_wait_cond = PTHREAD_COND_INITIALIZER;
+
+bool ___result_wait(_Atomic uint32_t* word, uint32_t expected,
+                    uint64_t deadline_ns)
+{
+    uint64_t timeout_ns = ___result_remaining(deadline_ns);
+    bool woken = true;
+
+    if (timeout_ns == 0) return false;
+
+    pthread_mutex_lock(&___result_wait_lock);
+
+    if (atomic_load(word) == expected) {
+        if (deadline_ns == RESULT_WAIT_FOREVER) {
+            pthread_cond_wait(&___result_wait_cond, &___result_wait_lock);
+        } else {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+
+            uint64_t ns = (uint64_t) deadline.tv_nsec + timeout_ns % 1000000000u;
+            deadline.tv_sec += (time_t) (timeout_ns / 1000000000u + ns / 1000000000u);
+            deadline.tv_nsec = (long) (ns % 1000000000u);
+
+            woken = pthread_cond_timedwait(&___result_wait_cond,
+                                           &___result_wait_lock,
+                                           &deadline) == 0;
+        }
+    }
+
+    pthread_mutex_unlock(&___result_wait_lock);
+    return woken;
+}
+
+void ___result_wake(_Atomic uint32_t* word)
+{
+    (void) word;
+
+    pthread_mutex_lock(&___result_wait_lock);
+    pthread_cond_broadcast(&___result_wait_cond);
+    pthread_mutex_unlock(&___result_wait_lock);
+}
+
+#endif
@@ -0,0 +1,134 @@
+/*
+    ALLOCATORS.C - Tests of the arena and pool allocators
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <ports/memory/allocators.h>
+#include <ports/libc/errors.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+
+static void test_arena_zero_size(void)
+{
+    MemoryArena arena;
+    memory_arena_init(&arena, 0, 0);
+
+    /* A fresh arena has no block yet, the first allocation makes one */
+    Result(void_ptr) first = memory_arena_alloc(&arena, 0, 1);
+    Result(void_ptr) second = memory_arena_alloc(&arena, 0, 1);
+
+    TEST_CHECK(is_ok(first) && first.value != NULL);
+    TEST_CHECK(is_ok(second) && second.value != NULL);
+    TEST_CHECK(first.value != second.value);
+    TEST_CHECK(memory_arena_stats(&arena).bytes_in_use == 0);
+    TEST_CHECK(memory_arena_stats(&arena).allocations == 2);
+
+    memory_arena_free(&arena);
+}
+
+static void test_arena(void)
+{
+    MemoryArena arena;
+    memory_arena_init(&arena, 256, 1024);
+
+    Result(void_ptr) small = memory_arena_alloc(&arena, 24, 8);
+    Result(void_ptr) aligned = memory_arena_alloc(&arena, 8, 64);
+
+    TEST_CHECK(is_ok(small) && ((uintptr_t) small.value & 7) == 0);
+    TEST_CHECK(is_ok(aligned) && ((uintptr_t) aligned.value & 63) == 0);
+    memset(small.value, 0xAB, 24);
+
+    TEST_CHECK(memory_arena_alloc(&arena, 8, 3).error
+               == ERR(InvalidArgument));
+
+    /* Larger than a block, but within the capacity */
+    TEST_CHECK(is_ok(memory_arena_alloc(&arena, 512, 8)));
+    TEST_CHECK(memory_arena_alloc(&arena, 4096, 8).error
+               == ERR(MemoryLimitExceeded));
+    TEST_CHECK(memory_arena_stats(&arena).failures == 1);
+
+    memory_arena_reset(&arena);
+    TEST_CHECK(memory_arena_stats(&arena).bytes_in_use == 0);
+    TEST_CHECK(memory_arena_stats(&arena).blocks == 1);
+    TEST_CHECK(is_ok(memory_arena_alloc(&arena, 16, 8)));
+
+    memory_arena_free(&arena);
+    TEST_CHECK(memory_arena_stats(&arena).bytes_reserved == 0);
+}
+
+static void test_pool(void)
+{
+    MemoryPool pool;
+    memory_pool_init(&pool, 24, 4, 6);
+
+    void* objects[6];
+    for (int i = 0; i < 6; i++) {
+        Result(void_ptr) object = memory_pool_alloc(&pool);
+
+        TEST_CHECK(is_ok(object) && object.value != NULL);
+        objects[i] = object.value;
+    }
+
+    TEST_CHECK(memory_pool_alloc(&pool).error == ERR(MemoryLimitExceeded));
+
+    memory_pool_release(&pool, objects[2]);
+    Result(void_ptr) reused = memory_pool_alloc(&pool);
+    TEST_CHECK(is_ok(reused) && reused.value == objects[2]);
+
+    MemoryStats stats = memory_pool_stats(&pool);
+    TEST_CHECK(stats.allocations == 7 && stats.releases == 1);
+    TEST_CHECK(stats.failures == 1 && stats.blocks == 2);
+
+    memory_pool_free(&pool);
+    TEST_CHECK(memory_pool_stats(&pool).bytes_reserved == 0);
+}
+
+static void test_libc(void)
+{
+    Result(void_ptr) block = memory_aligned_alloc(64, 100);
+
+    TEST_CHECK(is_ok(block) && ((uintptr_t) block.value & 63) == 0);
+    free(block.value);
+
+    TEST_CHECK(memory_aligned_alloc(48, 100).error == ERR(InvalidArgument));
+    TEST_CHECK(memory_calloc(SIZE_MAX, 2).error == ERR(NotEnoughMemory));
+
+    int line = __LINE__ + 1;
+    Result(void_ptr) huge = memory_malloc(SIZE_MAX);
+
+    TEST_CHECK(huge.error == ERR(NotEnoughMemory));
+    TEST_CHECK(huge.src_line == line);
+    TEST_CHECK(strcmp(huge.src_function, "test_libc") == 0);
+    TEST_CHECK(strcmp(huge.src_file, __FILE__) == 0);
+
+    Result(void_ptr) resized = memory_realloc(NULL, 16);
+
+    TEST_CHECK(is_ok(resized) && resized.src_line == line + 7);
+    free(resized.value);
+}
+
+int main(void)
+{
+    test_arena_zero_size();
+    test_arena();
+    test_pool();
+    test_libc();
+
+    return TEST_EXIT_STATUS();
+}
@@ -0,0 +1,250 @@
+/*
+    BACKTRACE.C - Tests of the backtraces and their symbolizer
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+    test_backtrace <result-symbolize>
+
+    The symbolizer runs with a fake addr2line, that prints the module and the
+    address it was asked for, so the parsing of the printed frames is checked
+    without debug information.
+*/
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <backtrace.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "test.h"
+
+#define PATH_SIZE 4096
+
+static char directory[] = "/tmp/result-backtrace-XXXXXX";
+
+__attribute__((noinline))
+static void capture_twice(ResultBacktrace* all, ResultBacktrace* skipped)
+{
+    result_backtrace_capture(all, 0);
+    result_backtrace_capture(skipped, 1);
+    __asm__ __volatile__("" : : : "memory");
+}
+
+static void test_capture(void)
+{
+    ResultBacktrace all, skipped;
+
+    capture_twice(&all, &skipped);
+
+    /* capture_twice, this test, main and the start of the program */
+    TEST_CHECK(all.count >= 3 && all.count <= RESULT_BACKTRACE_DEPTH);
+    for (unsigned int i = 0; i < all.count; i++)
+        TEST_CHECK(all.frames[i] != NULL);
+
+    /* Skipping a frame drops capture_twice, the callers are the same */
+    TEST_CHECK(skipped.count == all.count - 1);
+    TEST_CHECK(skipped.frames[0] == all.frames[1]);
+}
+
+static void write_file(const char* path, const char* text, mode_t mode)
+{
+    FILE* file = fopen(path, "w");
+
+    TEST_CHECK(file != NULL);
+    if (file == NULL) return;
+
+    fputs(text, file);
+    fclose(file);
+    chmod(path, mode);
+}
+
+/* The last occurrence of the needle, like the symbolizer looks for it */
+static const char* find_last(const char* text, const char* needle)
+{
+    const char* last = NULL;
+
+    for (const char* found = strstr(text, needle); found != NULL;
+         found = strstr(found + 1, needle))
+        last = found;
+
+    return last;
+}
+
+/* Runs the symbolizer over the text, and returns what it printed */
+static char* symbolize(const char* symbolizer, const char* text)
+{
+    char input[PATH_SIZE], command[3 * PATH_SIZE];
+    char* output = NULL;
+    size_t size = 0;
+
+    snprintf(input, sizeof(input), "%s/input", directory);
+    write_file(input, text, 0600);
+
+    snprintf(command, sizeof(command),
+             "ADDR2LINE=%s/addr2line '%s' -d %s/debug %s", directory,
+             symbolizer, directory, input);
+
+    FILE* pipe = popen(command, "r");
+    FILE* copy = open_memstream(&output, &size);
+    int c;
+
+    TEST_CHECK(pipe != NULL && copy != NULL);
+    if (pipe == NULL || copy == NULL) return NULL;
+
+    while ((c = fgetc(pipe)) != EOF) fputc(c, copy);
+
+    TEST_CHECK(pclose(pipe) == 0);
+    fclose(copy);
+    return output;
+}
+
+/* The printed frames of this program go through the symbolizer as they are */
+static void test_print_round_trip(const char* symbolizer)
+{
+    ResultBacktrace backtrace, skipped;
+    char* printed = NULL;
+    size_t size = 0;
+    char executable[PATH_SIZE];
+
+    ssize_t length = readlink("/proc/self/exe", executable,
+                              sizeof(executable) - 1);
+    executable[length > 0 ? length : 0] = '\0';
+
+    capture_twice(&backtrace, &skipped);
+
+    FILE* file = open_memstream(&printed, &size);
+    result_backtrace_print(file, &backtrace);
+    fclose(file);
+
+    char* output = symbolize(symbolizer, printed);
+    if (output == NULL) return;
+
+    unsigned int frames = 0, own_frames = 0;
+    char* next = output;
+    char* lines;
+
+    for (char* line = strtok_r(printed, "\n", &lines); line != NULL;
+         line = strtok_r(NULL, "\n", &lines)) {
+        unsigned int frame;
+        unsigned long long address, offset;
+        int consumed = -1;
+
+        sscanf(line, " #%u 0x%llx %n", &frame, &address, &consumed);
+        TEST_CHECK(consumed > 0 && frame == frames);
+        TEST_CHECK(address == (unsigned long long) backtrace.frames[frame]);
+
+        /* The frame is copied, and followed by what addr2line printed */
+        TEST_CHECK(strncmp(next, line, strlen(line)) == 0);
+        next = strchr(next, '\n') + 1;
+
+        const char* plus = find_last(line, "+0x");
+        TEST_CHECK(plus != NULL && sscanf(plus, "+0x%llx", &offset) == 1);
+
+        char expected[PATH_SIZE + 64];
+        snprintf(expected, sizeof(expected), "        [%.*s] 0x%llx\n",
+                 (int) (plus - line - consumed), line + consumed, offset - 1);
+        TEST_CHECK(strncmp(next, expected, strlen(expected)) == 0);
+        next += strlen(expected);
+
+        if (strncmp(line + consumed, executable, strlen(executable)) == 0) {
+            own_frames++;
+            TEST_CHECK(strstr(line, " (build-id ") != NULL);
+        }
+
+        frames++;
+    }
+
+    TEST_CHECK(frames == backtrace.count && own_frames >= 2);
+    TEST_CHECK(*next == '\0');
+
+    free(output);
+    free(printed);
+}
+
+/* Paths with spaces and "+0x" in them, build-ids with and without debug info */
+static void test_symbolize_lines(const char* symbolizer)
+{
+    char text[4 * PATH_SIZE], expected[4 * PATH_SIZE];
+
+    snprintf(text, sizeof(text),
+             "Backtrace of the panic:\n"
+             "    #0  0x00007f0000001000 %1$s/with space/lib name.so+0x1000\n"
+             "    #1  0x00007f0000002000 %1$s/with space/a+0x b.so+0x2000"
+             " (build-id abcdef)\n"
+             "    #2  0x00007f0000003000 %1$s/with space/lib name.so+0x30"
+             " (build-id 0123)\n"
+             "    #3  0x00007f0000004000\n",
+             directory);
+
+    snprintf(expected, sizeof(expected),
+             "Backtrace of the panic:\n"
+             "    #0  0x00007f0000001000 %1$s/with space/lib name.so+0x1000\n"
+             "        [%1$s/with space/lib name.so] 0xfff\n"
+             "    #1  0x00007f0000002000 %1$s/with space/a+0x b.so+0x2000"
+             " (build-id abcdef)\n"
+             "        [%1$s/debug/.build-id/ab/cdef.debug] 0x1fff\n"
+             "    #2  0x00007f0000003000 %1$s/with space/lib name.so+0x30"
+             " (build-id 0123)\n"
+             "        [%1$s/with space/lib name.so] 0x2f\n"
+             "    #3  0x00007f0000004000\n",
+             directory);
+
+    char* output = symbolize(symbolizer, text);
+    if (output == NULL) return;
+
+    TEST_CHECK(strcmp(output, expected) == 0);
+    free(output);
+}
+
+int main(int argc, char** argv)
+{
+    char path[PATH_SIZE];
+
+    test_capture();
+
+    TEST_CHECK(argc == 2 && mkdtemp(directory) != NULL);
+    if (argc != 2) return TEST_EXIT_STATUS();
+
+    /* addr2line -f -C -i -p -e <module> <address> */
+    snprintf(path, sizeof(path), "%s/addr2line", directory);
+    write_file(path, "#!/bin/sh\nprintf '[%s] %s\\n' \"$6\" \"$7\"\n", 0700);
+
+    snprintf(path, sizeof(path), "%s/debug", directory);
+    mkdir(path, 0700);
+    snprintf(path, sizeof(path), "%s/debug/.build-id", directory);
+    mkdir(path, 0700);
+    snprintf(path, sizeof(path), "%s/debug/.build-id/ab", directory);
+    mkdir(path, 0700);
+    snprintf(path, sizeof(path), "%s/debug/.build-id/ab/cdef.debug",
+             directory);
+    write_file(path, "", 0600);
+
+    test_print_round_trip(argv[1]);
+    test_symbolize_lines(argv[1]);
+
+    snprintf(path, sizeof(path), "rm -rf '%s'", directory);
+    TEST_CHECK(system(path) == 0);
+
+    return TEST_EXIT_STATUS();
+}
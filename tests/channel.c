@@ -0,0 +1,173 @@
+/*
+    CHANNEL.C - Tests of the channels
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <channel.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "test.h"
+
+#define PRODUCERS 4
+#define ITEMS 20000
+
+ERROR_DEFINE(TestFailure, OtherErrorExitCode, "The test failed on purpose.")
+
+CHANNEL_DECLARE(int)
+
+static void test_push_pop(void)
+{
+    Channel(int) channel;
+    Result(int) item;
+
+    /* The capacity rounds up to a power of two */
+    TEST_CHECK(is_ok(channel_init(int, &channel, 3)));
+
+    for (int i = 0; i < 4; i++)
+        TEST_CHECK(is_ok(channel_try_push(int, &channel, result_OK(int, i))));
+
+    TEST_CHECK(channel_try_push(int, &channel, result_OK(int, 4)).error
+               == ERR(ResourceUnavailable));
+    TEST_CHECK(channel_push(int, &channel, result_OK(int, 4), 1000000).error
+               == ERR(TimerExpired));
+
+    for (int i = 0; i < 4; i++) {
+        TEST_CHECK(is_ok(channel_try_pop(int, &channel, &item)));
+        TEST_CHECK(is_ok(item) && item.value == i);
+    }
+
+    TEST_CHECK(channel_try_pop(int, &channel, &item).error
+               == ERR(ResourceUnavailable));
+    TEST_CHECK(channel_pop(int, &channel, &item, 1000000).error
+               == ERR(TimerExpired));
+
+    /* Errors travel like values */
+    TEST_CHECK(is_ok(channel_try_push(int, &channel,
+                                      result_ERR(int, TestFailure))));
+    TEST_CHECK(is_ok(channel_try_pop(int, &channel, &item)));
+    TEST_CHECK(item.error == ERR(TestFailure));
+
+    channel_destroy(int, &channel);
+}
+
+static void test_close_drains(void)
+{
+    Channel(int) channel;
+    Result(int) items[8];
+    Result(int) item;
+
+    TEST_CHECK(is_ok(channel_init(int, &channel, 8)));
+
+    for (int i = 0; i < 3; i++) items[i] = result_OK(int, i);
+    TEST_CHECK(channel_push_batch(int, &channel, items, 3, 0).value == 3);
+
+    channel_close(int, &channel);
+
+    TEST_CHECK(channel_try_push(int, &channel, result_OK(int, 3)).error
+               == ERR(ChannelClosed));
+
+    /* The items pushed before the close are still popped, then it's closed */
+    Result(size_t) popped = channel_pop_batch(int, &channel, items, 8, 0);
+    TEST_CHECK(is_ok(popped) && popped.value == 3);
+    TEST_CHECK(items[0].value == 0 && items[2].value == 2);
+
+    TEST_CHECK(channel_pop(int, &channel, &item, RESULT_WAIT_FOREVER).error
+               == ERR(ChannelClosed));
+    TEST_CHECK(channel_pop_batch(int, &channel, items, 8, 0).error
+               == ERR(ChannelClosed));
+
+    channel_destroy(int, &channel);
+}
+
+static Channel(int) shared;
+static bool seen[PRODUCERS * ITEMS];
+
+static void* produce(void* context)
+{
+    int first = *(int*) context;
+
+    for (int i = first; i < first + ITEMS; i++)
+        if (is_err(channel_push(int, &shared, result_OK(int, i),
+                                RESULT_WAIT_FOREVER)))
+            return (void*) 1;
+
+    return NULL;
+}
+
+/* Pops until the channel is closed and drained, the value counts repeats */
+static void* consume(void* context)
+{
+    Result(int) item = result_OK(int, 0);
+    intptr_t repeats = 0;
+
+    (void) context;
+
+    while (is_ok(channel_pop(int, &shared, &item, RESULT_WAIT_FOREVER))) {
+        if (seen[item.value]) repeats++;
+        seen[item.value] = true;
+    }
+
+    return (void*) repeats;
+}
+
+static void test_threads(void)
+{
+    pthread_t producers[PRODUCERS];
+    pthread_t consumer;
+    int firsts[PRODUCERS];
+
+    TEST_CHECK(is_ok(channel_init(int, &shared, 64)));
+    TEST_CHECK(pthread_create(&consumer, NULL, &consume, NULL) == 0);
+
+    for (int i = 0; i < PRODUCERS; i++) {
+        firsts[i] = i * ITEMS;
+        TEST_CHECK(pthread_create(&producers[i], NULL, &produce,
+                                  &firsts[i]) == 0);
+    }
+
+    for (int i = 0; i < PRODUCERS; i++) {
+        void* failed;
+
+        pthread_join(producers[i], &failed);
+        TEST_CHECK(failed == NULL);
+    }
+
+    channel_close(int, &shared);
+
+    void* repeats;
+    pthread_join(consumer, &repeats);
+    TEST_CHECK(repeats == NULL);
+
+    bool all = true;
+    for (int i = 0; i < PRODUCERS * ITEMS; i++)
+        if (!seen[i]) all = false;
+
+    TEST_CHECK(all);
+
+    channel_destroy(int, &shared);
+}
+
+int main(void)
+{
+    test_push_pop();
+    test_close_drains();
+    test_threads();
+
+    return TEST_EXIT_STATUS();
+}
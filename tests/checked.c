@@ -0,0 +1,190 @@
+/*
+    CHECKED.C - Tests of the checked arithmetic
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <checked.h>
+
+#include <limits.h>
+#include <stdint.h>
+#include <wchar.h>
+
+#include "test.h"
+
+#define OVERFLOWS(result) ((result).error == ERR(IntegerOverflow))
+#define EQUALS(result, expected) (is_ok(result) && (result).value == (expected))
+
+/* Out of range of the narrower types without overflowing the widest ones */
+static intmax_t below(intmax_t value) { return value - (value > INTMAX_MIN); }
+static uintmax_t above(uintmax_t value) { return value + (value < UINTMAX_MAX); }
+
+/* The operations at the edges of the range, for every type */
+#define TEST_EDGES(type, min, max)                                              \
+    do {                                                                        \
+        const type lowest = (min), highest = (max), one = 1, two = 2;           \
+                                                                                \
+        TEST_CHECK(EQUALS(result_checked_add(type, highest - one, one),         \
+                          highest));                                            \
+        TEST_CHECK(OVERFLOWS(result_checked_add(type, highest, one)));          \
+        TEST_CHECK(EQUALS(result_checked_sub(type, lowest + one, one),          \
+                          lowest));                                             \
+        TEST_CHECK(OVERFLOWS(result_checked_sub(type, lowest, one)));           \
+        TEST_CHECK(EQUALS(result_checked_mul(type, highest / two, two),         \
+                          highest - highest % two));                            \
+        TEST_CHECK(OVERFLOWS(result_checked_mul(type, highest, two)));          \
+        TEST_CHECK(OVERFLOWS(result_checked_shl(type, highest, 1)));            \
+        TEST_CHECK(OVERFLOWS(result_checked_shl(type, one,                      \
+                                                sizeof(type) * CHAR_BIT)));     \
+        TEST_CHECK(EQUALS(result_checked_shl(type, 0,                           \
+                                             sizeof(type) * CHAR_BIT), 0));     \
+                                                                                \
+        if ((min) != 0) {                                                       \
+            TEST_CHECK(OVERFLOWS(result_checked_mul(type, lowest, -one)));      \
+            TEST_CHECK(OVERFLOWS(result_checked_sub(type, 0, lowest)));         \
+        }                                                                       \
+                                                                                \
+        TEST_CHECK(EQUALS(result_checked_cast(type, (intmax_t) lowest),         \
+                          lowest));                                             \
+        TEST_CHECK(EQUALS(result_checked_cast(type, (uintmax_t) highest),       \
+                          highest));                                            \
+        if (sizeof(type) < sizeof(uintmax_t))                                   \
+            TEST_CHECK(OVERFLOWS(result_checked_cast(                           \
+                type, above((uintmax_t) highest))));                            \
+        if ((min) == 0)                                                         \
+            TEST_CHECK(OVERFLOWS(result_checked_cast(type, -1)));               \
+        else if (sizeof(type) < sizeof(intmax_t))                               \
+            TEST_CHECK(OVERFLOWS(result_checked_cast(                           \
+                type, below((intmax_t) lowest))));                              \
+    } while (0)
+
+static void test_edges(void)
+{
+    TEST_EDGES(char, CHAR_MIN, CHAR_MAX);
+    TEST_EDGES(short, SHRT_MIN, SHRT_MAX);
+    TEST_EDGES(int, INT_MIN, INT_MAX);
+    TEST_EDGES(long, LONG_MIN, LONG_MAX);
+    TEST_EDGES(long_long, LLONG_MIN, LLONG_MAX);
+    TEST_EDGES(unsigned_char, 0, UCHAR_MAX);
+    TEST_EDGES(unsigned_short, 0, USHRT_MAX);
+    TEST_EDGES(unsigned_int, 0, UINT_MAX);
+    TEST_EDGES(unsigned_long, 0, ULONG_MAX);
+    TEST_EDGES(unsigned_long_long, 0, ULLONG_MAX);
+
+    TEST_EDGES(int8_t, INT8_MIN, INT8_MAX);
+    TEST_EDGES(int16_t, INT16_MIN, INT16_MAX);
+    TEST_EDGES(int32_t, INT32_MIN, INT32_MAX);
+    TEST_EDGES(int64_t, INT64_MIN, INT64_MAX);
+    TEST_EDGES(uint8_t, 0, UINT8_MAX);
+    TEST_EDGES(uint16_t, 0, UINT16_MAX);
+    TEST_EDGES(uint32_t, 0, UINT32_MAX);
+    TEST_EDGES(uint64_t, 0, UINT64_MAX);
+
+    TEST_EDGES(int_fast8_t, INT_FAST8_MIN, INT_FAST8_MAX);
+    TEST_EDGES(int_fast16_t, INT_FAST16_MIN, INT_FAST16_MAX);
+    TEST_EDGES(int_fast32_t, INT_FAST32_MIN, INT_FAST32_MAX);
+    TEST_EDGES(int_fast64_t, INT_FAST64_MIN, INT_FAST64_MAX);
+    TEST_EDGES(int_least8_t, INT_LEAST8_MIN, INT_LEAST8_MAX);
+    TEST_EDGES(int_least16_t, INT_LEAST16_MIN, INT_LEAST16_MAX);
+    TEST_EDGES(int_least32_t, INT_LEAST32_MIN, INT_LEAST32_MAX);
+    TEST_EDGES(int_least64_t, INT_LEAST64_MIN, INT_LEAST64_MAX);
+    TEST_EDGES(uint_fast8_t, 0, UINT_FAST8_MAX);
+    TEST_EDGES(uint_fast16_t, 0, UINT_FAST16_MAX);
+    TEST_EDGES(uint_fast32_t, 0, UINT_FAST32_MAX);
+    TEST_EDGES(uint_fast64_t, 0, UINT_FAST64_MAX);
+    TEST_EDGES(uint_least8_t, 0, UINT_LEAST8_MAX);
+    TEST_EDGES(uint_least16_t, 0, UINT_LEAST16_MAX);
+    TEST_EDGES(uint_least32_t, 0, UINT_LEAST32_MAX);
+    TEST_EDGES(uint_least64_t, 0, UINT_LEAST64_MAX);
+
+    TEST_EDGES(intmax_t, INTMAX_MIN, INTMAX_MAX);
+    TEST_EDGES(uintmax_t, 0, UINTMAX_MAX);
+    TEST_EDGES(intptr_t, INTPTR_MIN, INTPTR_MAX);
+    TEST_EDGES(uintptr_t, 0, UINTPTR_MAX);
+    TEST_EDGES(size_t, 0, SIZE_MAX);
+    TEST_EDGES(ptrdiff_t, PTRDIFF_MIN, PTRDIFF_MAX);
+    TEST_EDGES(wchar_t, WCHAR_MIN, WCHAR_MAX);
+}
+
+static void test_narrowing(void)
+{
+    TEST_CHECK(EQUALS(result_checked_cast(uint16_t, 65535), 65535));
+    TEST_CHECK(OVERFLOWS(result_checked_cast(uint16_t, 65536)));
+    TEST_CHECK(OVERFLOWS(result_checked_cast(int8_t, 128u)));
+    TEST_CHECK(EQUALS(result_checked_cast(int8_t, -128), -128));
+
+    /* Large unsigned values are not taken for negative ones */
+    TEST_CHECK(OVERFLOWS(result_checked_cast(int64_t, UINT64_MAX)));
+    TEST_CHECK(OVERFLOWS(result_checked_cast(long_long, ULLONG_MAX)));
+    TEST_CHECK(EQUALS(result_checked_cast(unsigned_long_long, ULLONG_MAX),
+                      ULLONG_MAX));
+}
+
+/* Batches fail at every position, in the vector part and the tail of blocks */
+#define TEST_BATCH(type, op, a_value, b_value, failing, fail_a, fail_b)         \
+    do {                                                                        \
+        enum { COUNT = 300 };                                                   \
+        type a[COUNT], b[COUNT], out[COUNT];                                    \
+        const size_t positions[] = { 0, 7, 255, 256, 290, 297, 299 };           \
+                                                                                \
+        for (size_t p = 0; p < sizeof(positions) / sizeof(*positions); p++) {   \
+            for (size_t i = 0; i < COUNT; i++) {                                \
+                a[i] = (a_value);                                               \
+                b[i] = (b_value);                                               \
+                out[i] = 0;                                                     \
+            }                                                                   \
+            a[positions[p]] = (fail_a);                                         \
+            b[positions[p]] = (fail_b);                                         \
+                                                                                \
+            Result(size_t) batch = result_checked_## op ##_array(               \
+                type, out, a, b, COUNT);                                        \
+                                                                                \
+            TEST_CHECK(OVERFLOWS(batch) && batch.value == positions[p]);        \
+            TEST_CHECK(positions[p] == 0 || out[positions[p] - 1] == (failing));\
+            TEST_CHECK(out[positions[p]] == 0);                                 \
+        }                                                                       \
+                                                                                \
+        for (size_t i = 0; i < COUNT; i++) {                                    \
+            a[i] = (a_value);                                                   \
+            b[i] = (b_value);                                                   \
+        }                                                                       \
+                                                                                \
+        /* In place, the result replaces the first input */                     \
+        Result(size_t) batch = result_checked_## op ##_array(                   \
+            type, a, a, b, COUNT);                                              \
+        TEST_CHECK(EQUALS(batch, (size_t) COUNT) && a[COUNT - 1] == (failing)); \
+    } while (0)
+
+static void test_batches(void)
+{
+    TEST_BATCH(int8_t, add, 3, 4, 7, INT8_MAX, 1);
+    TEST_BATCH(int16_t, sub, -3, 4, -7, INT16_MIN, 1);
+    TEST_BATCH(int32_t, mul, 3, -4, -12, INT32_MIN, -1);
+    TEST_BATCH(int64_t, add, -3, -4, -7, INT64_MIN, -1);
+    TEST_BATCH(uint8_t, sub, 7, 4, 3, 0, 1);
+    TEST_BATCH(uint32_t, add, 3, 4, 7, UINT32_MAX, 1);
+    TEST_BATCH(uint64_t, mul, 3, 4, 12, UINT64_MAX, 2);
+    TEST_BATCH(long, sub, 3, 4, -1, LONG_MIN, 1);
+    TEST_BATCH(unsigned_short, mul, 3, 4, 12, USHRT_MAX, 2);
+}
+
+int main(void)
+{
+    test_edges();
+    test_narrowing();
+    test_batches();
+
+    return TEST_EXIT_STATUS();
+}
@@ -0,0 +1,100 @@
+/*
+    ERROR.C - Tests of the error kinds
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <result.h>
+
+#include "test.h"
+
+/* Kinds of the program take the bits past the ones of the library */
+ERROR_KIND_DEFINE(Storage,                  16, 0)
+ERROR_KIND_DEFINE(DiskFull,                 30, ERROR_KIND(Storage))
+
+ERROR_DEFINE(TestFailure, OtherErrorExitCode, "The test failed on purpose.")
+ERROR_DEFINE(CustomCode, 42, "An exit code outside of the groups.")
+ERROR_DEFINE_WITH_KIND(OutOfSpace, ERROR_KIND(DiskFull) | ERROR_KIND(Transient),
+                       FileOperationFailedExitCode, "The disk is full.")
+
+static void test_port_kinds(void)
+{
+    /* Interrupted calls can be repeated at once */
+    TEST_CHECK(error_is_kind(ERR(InterruptedSysCall), Retryable));
+    TEST_CHECK(!error_is_kind(ERR(InterruptedSysCall), Transient));
+
+    /* Transient errors are retryable, their parent kind */
+    TEST_CHECK(error_is_kind(ERR(ResourceUnavailable), Transient));
+    TEST_CHECK(error_is_kind(ERR(ResourceUnavailable), Retryable));
+    TEST_CHECK(error_is_kind(ERR(ConnectionTimedOut), Transient));
+    TEST_CHECK(error_is_kind(ERR(DeviceOrResourceBusy), Retryable));
+
+    TEST_CHECK(!error_is_kind(ERR(FileDoesNotExist), Retryable));
+    TEST_CHECK(!error_is_kind(ERR(NotEnoughMemory), Transient));
+}
+
+static void test_exit_code_kinds(void)
+{
+    TEST_CHECK(error_is_kind(ERR(FileDoesNotExist), FileOperationFailed));
+    TEST_CHECK(error_is_kind(ERR(NotEnoughMemory), MemoryRelatedError));
+    TEST_CHECK(error_is_kind(ERR(ConnectionTimedOut), NetworkConnectionError));
+    TEST_CHECK(error_is_kind(ERR(InvalidArgument), InvalidRequest));
+    TEST_CHECK(error_is_kind(ERR(TestFailure), OtherError));
+
+    /* Every error is in the group of its exit code only */
+    TEST_CHECK(!error_is_kind(ERR(FileDoesNotExist), OtherError));
+    TEST_CHECK(!error_is_kind(ERR(TestFailure), FileOperationFailed));
+
+    TEST_CHECK((ERR(CustomCode))->kinds == 0);
+}
+
+static void test_program_kinds(void)
+{
+    TEST_CHECK(ERROR_KIND(DiskFull) == ((1 << 30) | (1 << 16)));
+
+    TEST_CHECK(error_is_kind(ERR(OutOfSpace), DiskFull));
+    TEST_CHECK(error_is_kind(ERR(OutOfSpace), Storage));
+    TEST_CHECK(error_is_kind(ERR(OutOfSpace), Transient));
+    TEST_CHECK(error_is_kind(ERR(OutOfSpace), Retryable));
+    TEST_CHECK(error_is_kind(ERR(OutOfSpace), FileOperationFailed));
+
+    TEST_CHECK(!error_is_kind(ERR(TestFailure), Storage));
+    TEST_CHECK(!error_is_kind(ERR(FileDoesNotExist), DiskFull));
+}
+
+static void test_result_kinds(void)
+{
+    Result(int) failed = result_ERR(int, OutOfSpace);
+
+    TEST_CHECK(result_is_kind(failed, Storage));
+    TEST_CHECK(!result_is_kind(failed, MemoryRelatedError));
+
+    /* An ok result is of no kind */
+    Result(int) ok = result_OK(int, 1);
+
+    TEST_CHECK(!result_is_kind(ok, Retryable));
+    TEST_CHECK(!result_is_kind(ok, OtherError));
+    TEST_CHECK(!result_is_kind(ok, Storage));
+}
+
+int main(void)
+{
+    test_port_kinds();
+    test_exit_code_kinds();
+    test_program_kinds();
+    test_result_kinds();
+
+    return TEST_EXIT_STATUS();
+}
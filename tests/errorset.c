@@ -0,0 +1,102 @@
+/*
+    ERRORSET.C - Tests of the error sets
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <errorset.h>
+
+#include "test.h"
+
+ERROR_DEFINE(TestFailure, OtherErrorExitCode, "The test failed on purpose.")
+
+static Result(int) check(int value)
+{
+    if (value < 0) return result_ERR(int, TestFailure);
+    return result_OK(int, value);
+}
+
+static void test_collect(void)
+{
+    ErrorSet errors = ERROR_SET_INIT(2);
+
+    TEST_CHECK(error_set_collect(int, &errors, 0, check(1)));
+
+    Result(ErrorSet_ptr) folded = error_set_result(&errors);
+    TEST_CHECK(is_ok(folded) && folded.value == &errors);
+
+    TEST_CHECK(!error_set_collect(int, &errors, 1, check(-1)));
+
+    /* A single error is returned as it is */
+    folded = error_set_result(&errors);
+    TEST_CHECK(folded.error == ERR(TestFailure) && folded.value == &errors);
+    TEST_CHECK(folded.src_line == errors.entries[0].src_line);
+
+    /* The errors past the capacity are only counted */
+    error_set_collect(int, &errors, 2, check(-2));
+    error_set_collect(int, &errors, 3, check(-3));
+
+    folded = error_set_result(&errors);
+    TEST_CHECK(folded.error == ERR(MultipleErrors));
+    TEST_CHECK(folded.value->count == 2 && folded.value->overflow == 1);
+    TEST_CHECK(error_set_total(folded.value) == 3);
+    TEST_CHECK(folded.value->entries[1].index == 2);
+}
+
+static void test_no_capacity(void)
+{
+    ErrorSet errors;
+
+    error_set_init(&errors, NULL, 0);
+    TEST_CHECK(is_ok(error_set_result(&errors)));
+
+    /* The only error is counted, not stored */
+    TEST_CHECK(!error_set_collect(int, &errors, 0, check(-1)));
+    TEST_CHECK(errors.count == 0 && error_set_total(&errors) == 1);
+
+    Result(ErrorSet_ptr) folded = error_set_result(&errors);
+    TEST_CHECK(folded.error == ERR(MultipleErrors) && folded.value == &errors);
+}
+
+static void test_result_all(void)
+{
+    ErrorSetEntry entries[4];
+    ErrorSet errors;
+    Result(int) results[6];
+
+    error_set_init(&errors, entries, 4);
+
+    for (int i = 0; i < 6; i++) results[i] = check(i % 2 == 0 ? i : -i);
+
+    Result(ErrorSet_ptr) folded = result_all(int, &errors, results, 6);
+
+    TEST_CHECK(folded.error == ERR(MultipleErrors));
+    TEST_CHECK(folded.value == &errors && errors.count == 3);
+    TEST_CHECK(entries[0].index == 1 && entries[2].index == 5);
+
+    /* Merging honours the capacity of the target */
+    ErrorSet small = ERROR_SET_INIT(1);
+    error_set_merge(&small, &errors);
+    TEST_CHECK(small.count == 1 && small.overflow == 2);
+}
+
+int main(void)
+{
+    test_collect();
+    test_no_capacity();
+    test_result_all();
+
+    return TEST_EXIT_STATUS();
+}
@@ -0,0 +1,72 @@
+/*
+    FUTURE.C - Tests of futures and promises
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <future.h>
+
+#include <pthread.h>
+
+#include "test.h"
+
+FUTURE_DECLARE(int)
+
+static void* set_answer(void* context)
+{
+    Promise(int) promise = future_promise(int, (Future(int)*) context);
+
+    promise_set(int, promise, result_OK(int, 42));
+    return NULL;
+}
+
+static void test_not_ready(void)
+{
+    Future(int) future = FUTURE_INIT;
+
+    Result(int) polled = future_poll(int, &future);
+    TEST_CHECK(polled.error == ERR(ResourceUnavailable) && polled.value == 0);
+
+    Result(int) waited = future_wait(int, &future, 1000000);
+    TEST_CHECK(waited.error == ERR(TimerExpired) && waited.value == 0);
+    TEST_CHECK(!future_is_ready(int, &future));
+}
+
+static void test_handoff(void)
+{
+    Future(int) future = FUTURE_INIT;
+    pthread_t thread;
+
+    TEST_CHECK(pthread_create(&thread, NULL, &set_answer, &future) == 0);
+
+    Result(int) waited = future_wait(int, &future, RESULT_WAIT_FOREVER);
+    TEST_CHECK(is_ok(waited) && waited.value == 42);
+
+    pthread_join(thread, NULL);
+
+    /* The result is set once */
+    Promise(int) promise = future_promise(int, &future);
+    TEST_CHECK(promise_set(int, promise, result_OK(int, 1)).error
+               == ERR(PromiseAlreadySet));
+    TEST_CHECK(future_poll(int, &future).value == 42);
+}
+
+int main(void)
+{
+    test_not_ready();
+    test_handoff();
+
+    return TEST_EXIT_STATUS();
+}
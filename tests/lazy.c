@@ -0,0 +1,103 @@
+/*
+    LAZY.C - Tests of the lazy results
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <lazy.h>
+
+#include "test.h"
+
+ERROR_DEFINE(TestFailure, OtherErrorExitCode, "The test failed on purpose.")
+
+LAZY_DECLARE(int)
+
+static int calls = 0;
+
+static Result(int) count_calls(void* context)
+{
+    (void) context;
+
+    return result_OK(int, ++calls);
+}
+
+static Result(int) panic_first(void* context)
+{
+    if (++calls == 1) panicf(6, "Initializer of %s", (char*) context);
+
+    return result_OK(int, 42);
+}
+
+static Result(int) fail(void* context)
+{
+    (void) context;
+
+    calls++;
+    return result_ERR(int, TestFailure);
+}
+
+static Result(int) twice(int value)
+{
+    return result_OK(int, value * 2);
+}
+
+static void test_once(void)
+{
+    Lazy(int) lazy = LAZY_INIT(&count_calls, NULL, NULL);
+
+    calls = 0;
+    TEST_CHECK(!lazy_is_ready(int, &lazy));
+    TEST_CHECK(lazy_unwrap(int, &lazy) == 1);
+    TEST_CHECK(lazy_unwrap(int, &lazy) == 1 && calls == 1);
+    TEST_CHECK(lazy_and_then(int, &lazy, &twice).value == 2);
+
+    /* Without a policy an error is kept too */
+    Lazy(int) failing = LAZY_INIT(&fail, NULL, NULL);
+
+    calls = 0;
+    TEST_CHECK(lazy_get(int, &failing).error == ERR(TestFailure));
+    TEST_CHECK(lazy_is_err(int, &failing) && calls == 1);
+}
+
+static Result(void) get_lazy(void* context)
+{
+    lazy_get(int, (Lazy(int)*) context);
+    return result_OK();
+}
+
+static void test_panic(void)
+{
+    Lazy(int) lazy = LAZY_INIT(&panic_first, "the cell", NULL);
+    PanicRecord record;
+
+    calls = 0;
+    Result(void) caught = result_catch_panic_record(&get_lazy, &lazy, &record);
+
+    TEST_CHECK(caught.error == ERR(Panicked));
+    TEST_CHECK(record.exit_code == 6);
+    TEST_CHECK(strcmp(record.message, "Initializer of the cell") == 0);
+
+    /* The cell was released, the next caller runs the initializer again */
+    TEST_CHECK(!lazy_is_ready(int, &lazy));
+    TEST_CHECK(lazy_unwrap(int, &lazy) == 42 && calls == 2);
+}
+
+int main(void)
+{
+    test_once();
+    test_panic();
+
+    return TEST_EXIT_STATUS();
+}
@@ -0,0 +1,108 @@
+/*
+    LIBM.C - Tests of the libm port
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <ports/libm/functions.h>
+#include <ports/libc/errors.h>
+
+#include <math.h>
+#include <string.h>
+
+#include "test.h"
+
+static void test_scalar(void)
+{
+    Result(double) root = libm_sqrt(4.0);
+
+    TEST_CHECK(is_ok(root) && root.value == 2.0);
+
+    int line = __LINE__ + 1;
+    Result(double) domain = libm_sqrt(-1.0);
+
+    TEST_CHECK(domain.error == ERR(NumericalArgumentOutOfDomain));
+    TEST_CHECK(isnan(domain.value));
+    TEST_CHECK(domain.src_line == line);
+    TEST_CHECK(strcmp(domain.src_function, "test_scalar") == 0);
+    TEST_CHECK(strstr(domain.src_file, "libm.c") != NULL);
+
+    Result(float) range = libm_expf(1000.0f);
+
+    TEST_CHECK(range.error == ERR(NumericalArgumentOutOfRange));
+    TEST_CHECK(isinf(range.value));
+}
+
+static void test_array(void)
+{
+    double x[4] = { 1.0, -1.0, 0.0, 4.0 };
+    double out[4];
+    uint8_t mask[4];
+
+    int line = __LINE__ + 1;
+    Result(void) logs = libm_log_array(out, x, 4, mask);
+
+    TEST_CHECK(logs.error == ERR(NumericalArgumentOutOfDomain));
+    TEST_CHECK(logs.src_line == line);
+    TEST_CHECK(strcmp(logs.src_function, "test_array") == 0);
+    TEST_CHECK(mask[0] == LIBM_OK && mask[1] == LIBM_DOMAIN_ERROR);
+    TEST_CHECK(mask[2] == LIBM_RANGE_ERROR && mask[3] == LIBM_OK);
+
+    double y[4] = { 2.0, 2.0, 2.0, 2.0 };
+
+    TEST_CHECK(is_ok(libm_pow_array(out, x, y, 4, NULL)));
+    TEST_CHECK(out[3] == 16.0);
+}
+
+static void test_in_place(void)
+{
+    double x[5] = { 1.0, -1.0, 0.0, 4.0, NAN };
+    uint8_t mask[5];
+
+    /* The arguments are overwritten, the mask is still the one of them */
+    Result(void) logs = libm_log_array(x, x, 5, mask);
+
+    TEST_CHECK(logs.error == ERR(NumericalArgumentOutOfDomain));
+    TEST_CHECK(x[0] == 0.0 && isnan(x[1]) && isinf(x[2]));
+    TEST_CHECK(mask[0] == LIBM_OK && mask[1] == LIBM_DOMAIN_ERROR);
+    TEST_CHECK(mask[2] == LIBM_RANGE_ERROR && mask[3] == LIBM_OK);
+    TEST_CHECK(mask[4] == LIBM_OK);
+
+    float base[3] = { 2.0f, -8.0f, 0.0f };
+    float exponent[3] = { 3.0f, 0.5f, -1.0f };
+
+    Result(void) powers = libm_powf_array(exponent, base, exponent, 3, mask);
+
+    TEST_CHECK(is_err(powers));
+    TEST_CHECK(exponent[0] == 8.0f);
+    TEST_CHECK(mask[0] == LIBM_OK && mask[1] == LIBM_DOMAIN_ERROR);
+    TEST_CHECK(mask[2] == LIBM_RANGE_ERROR);
+
+    double roots[3] = { 9.0, -4.0, 16.0 };
+
+    TEST_CHECK(libm_sqrt_array(roots, roots, 3, mask).error
+               == ERR(NumericalArgumentOutOfDomain));
+    TEST_CHECK(roots[0] == 3.0 && roots[2] == 4.0);
+    TEST_CHECK(mask[0] == LIBM_OK && mask[1] == LIBM_DOMAIN_ERROR);
+}
+
+int main(void)
+{
+    test_scalar();
+    test_array();
+    test_in_place();
+
+    return TEST_EXIT_STATUS();
+}
@@ -0,0 +1,188 @@
+/*
+    LOG.C - Tests of the error log
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <log.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "src/logformat.h"
+#include "test.h"
+
+#define THREADS 4
+#define RECORDS 1000
+
+ERROR_DEFINE(TestFailure, OtherErrorExitCode, "The test failed on purpose.")
+
+typedef struct {
+    uint64_t    records;
+    uint64_t    dropped;
+    bool        valid;
+} LogCount;
+
+static bool read_exactly(FILE* file, void* data, size_t size)
+{
+    return fread(data, 1, size, file) == size;
+}
+
+static bool skip(FILE* file, long size)
+{
+    return fseek(file, size, SEEK_CUR) == 0;
+}
+
+/* Walks the entries of the log, any truncated or unknown entry is invalid */
+static LogCount count_log(const char* path)
+{
+    LogCount count = { 0, 0, false };
+    FILE* file = fopen(path, "rb");
+    char magic[sizeof(___RESULT_LOG_MAGIC) - 1];
+    uint32_t length;
+    uint32_t arguments;
+    uint64_t dropped;
+    int tag;
+
+    if (file == NULL) return count;
+
+    if (!read_exactly(file, magic, sizeof(magic))
+        || memcmp(magic, ___RESULT_LOG_MAGIC, sizeof(magic)) != 0)
+        goto done;
+
+    while ((tag = fgetc(file)) != EOF) {
+        switch (tag) {
+        case ___RESULT_LOG_ERROR:
+            if (!skip(file, 12) || !read_exactly(file, &length, 4)
+                || !skip(file, length))
+                goto done;
+            break;
+        case ___RESULT_LOG_STRING:
+            if (!skip(file, 8) || !read_exactly(file, &length, 4)
+                || !skip(file, length))
+                goto done;
+            break;
+        case ___RESULT_LOG_RECORD:
+            if (!skip(file, 40) || !read_exactly(file, &arguments, 4)
+                || !skip(file, (long) arguments * 8))
+                goto done;
+            count.records++;
+            break;
+        case ___RESULT_LOG_DROPPED:
+            if (!skip(file, 4) || !read_exactly(file, &dropped, 8)) goto done;
+            count.dropped += dropped;
+            break;
+        default:
+            goto done;
+        }
+    }
+
+    count.valid = true;
+
+done:
+    fclose(file);
+    return count;
+}
+
+static Result(int) fail(void)
+{
+    return result_ERR(int, TestFailure);
+}
+
+static void* log_records(void* context)
+{
+    (void) context;
+
+    for (int i = 0; i < RECORDS; i++) result_log(int, fail(), i);
+
+    return NULL;
+}
+
+static void test_records(const char* path)
+{
+    pthread_t threads[THREADS];
+
+    TEST_CHECK(is_ok(result_log_start(path)));
+    TEST_CHECK(result_log_start(path).error == ERR(AlreadyInProgress));
+
+    for (int i = 0; i < THREADS; i++)
+        pthread_create(&threads[i], NULL, &log_records, NULL);
+
+    for (int i = 0; i < THREADS; i++) pthread_join(threads[i], NULL);
+
+    TEST_CHECK(is_ok(result_log_stop()));
+
+    /* Every record is written or counted as dropped */
+    LogCount count = count_log(path);
+    TEST_CHECK(count.valid);
+    TEST_CHECK(count.records + count.dropped == THREADS * RECORDS);
+
+    /* Nothing is logged while stopped */
+    result_log(int, fail());
+    TEST_CHECK(is_ok(result_log_start(path)));
+    TEST_CHECK(is_ok(result_log_stop()));
+
+    count = count_log(path);
+    TEST_CHECK(count.valid && count.records == 0 && count.dropped == 0);
+}
+
+static atomic_bool logging = true;
+
+static void* log_until_told(void* context)
+{
+    (void) context;
+
+    while (atomic_load(&logging)) result_log(int, fail());
+
+    return NULL;
+}
+
+/* Stops and starts again while other threads keep logging */
+static void test_restart(const char* path)
+{
+    pthread_t threads[THREADS];
+
+    for (int i = 0; i < THREADS; i++)
+        pthread_create(&threads[i], NULL, &log_until_told, NULL);
+
+    for (int round = 0; round < 20; round++) {
+        TEST_CHECK(is_ok(result_log_start(path)));
+        usleep(2000);
+        TEST_CHECK(is_ok(result_log_stop()));
+        TEST_CHECK(count_log(path).valid);
+    }
+
+    atomic_store(&logging, false);
+    for (int i = 0; i < THREADS; i++) pthread_join(threads[i], NULL);
+}
+
+int main(void)
+{
+    char path[] = "/tmp/result-log-test-XXXXXX";
+    int descriptor = mkstemp(path);
+
+    TEST_CHECK(descriptor >= 0);
+    close(descriptor);
+
+    test_records(path);
+    test_restart(path);
+
+    unlink(path);
+    return TEST_EXIT_STATUS();
+}
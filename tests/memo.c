@@ -0,0 +1,116 @@
+/*
+    MEMO.C - Tests of the memoizing caches
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <memo.h>
+
+#include <stdio.h>
+
+#include "test.h"
+
+ERROR_DEFINE(TestFailure, OtherErrorExitCode, "The test failed on purpose.")
+ERROR_DEFINE_WITH_KIND(TestBusy, ERROR_KIND(Transient), OtherErrorExitCode,
+                       "The test was busy on purpose.")
+
+MEMO_DECLARE(int64_t)
+
+static int calls = 0;
+
+static Result(int64_t) length_of(str_slice key, void* context)
+{
+    (void) context;
+
+    calls++;
+    if (key.length == 0) return result_ERR(int64_t, TestFailure);
+    if (key.data[0] == '!') return result_ERR(int64_t, TestBusy);
+
+    return result_OK(int64_t, (int64_t) key.length);
+}
+
+static void fill(Memo(int64_t)* cache, int keys)
+{
+    char key[32];
+
+    for (int i = 0; i < keys; i++) {
+        snprintf(key, sizeof(key), "key-%d", i);
+        memo_get(int64_t, cache, str_slice_from_cstr(key), &length_of, NULL);
+    }
+}
+
+static void test_capacity(void)
+{
+    size_t capacities[] = { 1, 3, 20, 100 };
+
+    /* The shards add up to the capacity, they don't round it up */
+    for (size_t i = 0; i < sizeof(capacities) / sizeof(capacities[0]); i++) {
+        Memo(int64_t) cache;
+
+        TEST_CHECK(is_ok(memo_init(int64_t, &cache, capacities[i],
+                                   MEMO_FOREVER, MEMO_FOREVER)));
+        fill(&cache, 1000);
+        TEST_CHECK(memo_stats(&cache).entries == capacities[i]);
+        memo_destroy(&cache);
+    }
+
+    Memo(int64_t) cache;
+    TEST_CHECK(memo_init(int64_t, &cache, 0, MEMO_FOREVER, 0).error
+               == ERR(InvalidArgument));
+}
+
+static void test_get(void)
+{
+    Memo(int64_t) cache;
+    str_slice key = str_slice_from_cstr("abc");
+    str_slice empty = str_slice_from_cstr("");
+    str_slice busy = str_slice_from_cstr("!busy");
+
+    TEST_CHECK(is_ok(memo_init(int64_t, &cache, 64, MEMO_FOREVER,
+                               MEMO_FOREVER)));
+    calls = 0;
+
+    TEST_CHECK(memo_get(int64_t, &cache, key, &length_of, NULL).value == 3);
+    TEST_CHECK(memo_get(int64_t, &cache, key, &length_of, NULL).value == 3);
+    TEST_CHECK(calls == 1);
+
+    /* Errors are kept, transient ones are not */
+    memo_get(int64_t, &cache, empty, &length_of, NULL);
+    TEST_CHECK(memo_get(int64_t, &cache, empty, &length_of, NULL).error
+               == ERR(TestFailure));
+    TEST_CHECK(calls == 2);
+
+    memo_get(int64_t, &cache, busy, &length_of, NULL);
+    memo_get(int64_t, &cache, busy, &length_of, NULL);
+    TEST_CHECK(calls == 4);
+
+    memo_invalidate(&cache, key);
+    memo_get(int64_t, &cache, key, &length_of, NULL);
+    TEST_CHECK(calls == 5);
+
+    MemoStats stats = memo_stats(&cache);
+    TEST_CHECK(stats.hits == 2 && stats.error_hits == 1);
+    TEST_CHECK(stats.entries == 2);
+
+    memo_destroy(&cache);
+}
+
+int main(void)
+{
+    test_capacity();
+    test_get();
+
+    return TEST_EXIT_STATUS();
+}
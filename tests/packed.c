@@ -0,0 +1,194 @@
+/*
+    PACKED.C - Tests of the packed results
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <packed.h>
+#include <catch.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "test.h"
+
+#define THREADS 4
+
+/* More locations than fit in a chunk of the registry */
+#define LOCATIONS 5000
+
+ERROR_DEFINE(TestFailure, OtherErrorExitCode, "The test failed on purpose.")
+
+static int fail_line;
+
+static Result(int32_t) fail(void)
+{
+    fail_line = __LINE__ + 1;
+    return result_ERR(int32_t, TestFailure);
+}
+
+static Packed(int32_t) fail_packed(int which)
+{
+    if (which == 0) return packed_ERR(int32_t, TestFailure);
+
+    return packed_ERR(int32_t, TestFailure);
+}
+
+static void test_round_trip(void)
+{
+    Result(int32_t) full = fail();
+    Packed(int32_t) packed = packed_from_result(int32_t, full);
+
+    TEST_CHECK(packed_is_err(packed));
+    TEST_CHECK(packed_error(packed) == ERR(TestFailure));
+    TEST_CHECK(packed_is_kind(packed, OtherError));
+
+    /* The error comes back with the location it was created at */
+    Result(int32_t) back = packed_to_result(int32_t, packed);
+    TEST_CHECK(back.error == ERR(TestFailure) && back.src_line == fail_line);
+    TEST_CHECK(strcmp(back.src_file, __FILE__) == 0);
+    TEST_CHECK(strcmp(back.src_function, "fail") == 0);
+
+    back = packed_to_result(int32_t, fail_packed(0));
+    TEST_CHECK(back.error == ERR(TestFailure));
+    TEST_CHECK(strcmp(back.src_function, "fail_packed") == 0);
+
+    /* An ok one keeps its value, and points at the conversion */
+    packed = packed_from_result(int32_t, result_OK(int32_t, -7));
+    TEST_CHECK(packed_is_ok(packed) && packed_unwrap(int32_t, packed) == -7);
+
+    int line = __LINE__ + 1;
+    back = packed_to_result(int32_t, packed);
+    TEST_CHECK(is_ok(back) && back.value == -7 && back.src_line == line);
+
+    Packed(float) fraction = packed_OK(float, 0.25f);
+    TEST_CHECK(packed_unwrap(float, fraction) == 0.25f);
+}
+
+static void test_ids(void)
+{
+    Packed(int32_t) first = fail_packed(0);
+    Packed(int32_t) second = fail_packed(1);
+
+    /* The same error from two locations, two ids */
+    TEST_CHECK(packed_error(first) == packed_error(second));
+    TEST_CHECK(first.bits != second.bits);
+    TEST_CHECK(packed_to_result(int32_t, first).src_line
+               != packed_to_result(int32_t, second).src_line);
+
+    /* The same location again, the same id */
+    TEST_CHECK(fail_packed(0).bits == first.bits);
+    TEST_CHECK(packed_from_result(int32_t, fail()).bits
+               == packed_from_result(int32_t, fail()).bits);
+}
+
+static Result(void) unwrap_packed(void* context)
+{
+    (void) context;
+    packed_unwrap(int32_t, packed_from_result(int32_t, fail()));
+    return result_OK();
+}
+
+static Result(void) expect_packed(void* context)
+{
+    (void) context;
+    packed_expect(int32_t, fail_packed(0), "Expected a number");
+    return result_OK();
+}
+
+static void test_panics(void)
+{
+    Result(void) caught = result_catch_panic(&unwrap_packed, NULL);
+
+    TEST_CHECK(caught.error == ERR(Panicked));
+    TEST_CHECK(strcmp(caught.src_function, "unwrap_packed") == 0);
+    TEST_CHECK_STR_CONTAINS(result_last_panic().message,
+                            "Tried to unwrap from an error result.");
+    TEST_CHECK_STR_CONTAINS(result_last_panic().message,
+                            "The test failed on purpose. (from fail at");
+
+    caught = result_catch_panic(&expect_packed, NULL);
+    TEST_CHECK(caught.error == ERR(Panicked));
+    TEST_CHECK_STR_CONTAINS(result_last_panic().message,
+                            "Expected a number: The test failed on purpose.");
+}
+
+static uint64_t interned[THREADS][LOCATIONS];
+
+/* Every thread interns the same locations, from a different end */
+static void* intern(void* context)
+{
+    uint64_t* ids = context;
+    size_t thread = (size_t) (ids - interned[0]) / LOCATIONS;
+
+    for (size_t n = 0; n < LOCATIONS; n++) {
+        size_t i = thread % 2 ? LOCATIONS - 1 - n : n;
+        Result(int32_t) full = {
+            .error = ERR(TestFailure),
+            .src_file = __FILE__,
+            .src_line = (int) i + 1,
+            .src_function = __func__,
+        };
+
+        ids[i] = packed_from_result(int32_t, full).bits;
+
+        /* The origins of the other threads are read without a lock */
+        Result(int32_t) back = packed_to_result(int32_t,
+                                                (Packed(int32_t)) { ids[i] });
+        TEST_CHECK(back.src_line == (int) i + 1 && back.error == full.error);
+    }
+
+    return NULL;
+}
+
+static void test_threads(void)
+{
+    pthread_t threads[THREADS];
+
+    for (size_t i = 0; i < THREADS; i++)
+        pthread_create(&threads[i], NULL, &intern, interned[i]);
+
+    for (size_t i = 0; i < THREADS; i++) pthread_join(threads[i], NULL);
+
+    static bool seen[LOCATIONS];
+    uint64_t first = interned[0][0];
+
+    for (size_t i = 1; i < LOCATIONS; i++)
+        if (interned[0][i] < first) first = interned[0][i];
+
+    /*
+        All of the threads got the same ids, a different one per location,
+        handed out one after another
+    */
+    for (size_t i = 0; i < LOCATIONS; i++) {
+        for (size_t t = 1; t < THREADS; t++)
+            TEST_CHECK(interned[t][i] == interned[0][i]);
+
+        size_t id = (size_t) ((interned[0][i] - first) >> ___PACKED_ID_SHIFT);
+        TEST_CHECK(id < LOCATIONS && !seen[id]);
+        if (id < LOCATIONS) seen[id] = true;
+    }
+}
+
+int main(void)
+{
+    test_round_trip();
+    test_ids();
+    test_panics();
+    test_threads();
+
+    return TEST_EXIT_STATUS();
+}
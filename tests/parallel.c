@@ -0,0 +1,135 @@
+/*
+    PARALLEL.C - Tests of the parallel maps
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <parallel.h>
+#include <catch.h>
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "test.h"
+
+#define COUNT 10000
+
+ERROR_DEFINE(TestFailure, OtherErrorExitCode, "The test failed on purpose.")
+
+RESULT_PAR_MAP_DECLARE(int64_t, int64_t)
+
+static Result(int64_t) square(int64_t value)
+{
+    if (value == -1) return result_ERR(int64_t, TestFailure);
+    if (value == -2) panicf(9, "Panic at %d", -2);
+
+    return result_OK(int64_t, value * value);
+}
+
+typedef struct {
+    int64_t         in[COUNT];
+    int64_t         out[COUNT];
+    Result(size_t)  mapped;
+} Map;
+
+static void* map_all(void* context)
+{
+    Map* map = context;
+
+    for (int64_t i = 0; i < COUNT; i++) map->in[i] = i;
+
+    map->mapped = result_par_map(int64_t, int64_t, &square, map->in, map->out,
+                                 COUNT);
+    return NULL;
+}
+
+static void check_squares(const Map* map)
+{
+    bool squares = true;
+
+    for (int64_t i = 0; i < COUNT; i++)
+        if (map->out[i] != i * i) squares = false;
+
+    TEST_CHECK(is_ok(map->mapped) && map->mapped.value == COUNT);
+    TEST_CHECK(squares);
+}
+
+static void test_map(void)
+{
+    static Map map;
+
+    map_all(&map);
+    check_squares(&map);
+
+    /* The lowest failing index wins, like in a sequential loop */
+    map.in[7000] = -1;
+    map.in[300] = -1;
+    map.mapped = result_par_map(int64_t, int64_t, &square, map.in, map.out,
+                                COUNT);
+
+    TEST_CHECK(map.mapped.error == ERR(TestFailure));
+    TEST_CHECK(map.mapped.value == 300);
+}
+
+static void test_concurrent_maps(void)
+{
+    static Map maps[2];
+    pthread_t threads[2];
+
+    for (int i = 0; i < 2; i++)
+        TEST_CHECK(pthread_create(&threads[i], NULL, &map_all, &maps[i]) == 0);
+
+    for (int i = 0; i < 2; i++) {
+        pthread_join(threads[i], NULL);
+        check_squares(&maps[i]);
+    }
+}
+
+static Result(void) map_panic(void* context)
+{
+    Map* map = context;
+
+    for (int64_t i = 0; i < COUNT; i++) map->in[i] = i;
+    map->in[5000] = -2;
+
+    map->mapped = result_par_map(int64_t, int64_t, &square, map->in, map->out,
+                                 COUNT);
+    return result_OK();
+}
+
+static void test_panic(void)
+{
+    static Map map;
+    PanicRecord record;
+
+    Result(void) caught = result_catch_panic_record(&map_panic, &map, &record);
+
+    TEST_CHECK(caught.error == ERR(Panicked));
+    TEST_CHECK(record.exit_code == 9);
+    TEST_CHECK(strcmp(record.message, "Panic at -2") == 0);
+
+    /* The pool is released, the next map runs normally */
+    map_all(&map);
+    check_squares(&map);
+}
+
+int main(void)
+{
+    test_map();
+    test_concurrent_maps();
+    test_panic();
+
+    return TEST_EXIT_STATUS();
+}
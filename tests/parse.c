@@ -0,0 +1,132 @@
+/*
+    PARSE.C - Tests of the number parsers
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <ports/parse/numbers.h>
+#include <ports/libc/errors.h>
+
+#include <limits.h>
+#include <string.h>
+
+#include "test.h"
+
+#define TEXT(literal) literal, sizeof(literal) - 1
+
+static void test_integers(void)
+{
+    size_t consumed;
+    int line = __LINE__ + 1;
+    Result(uint16_t) port = parse_uint16_t(TEXT("8080/tcp"), &consumed);
+
+    TEST_CHECK(is_ok(port) && port.value == 8080 && consumed == 4);
+    TEST_CHECK(port.src_line == line);
+    TEST_CHECK(strcmp(port.src_function, "test_integers") == 0);
+
+    line = __LINE__ + 1;
+    Result(int8_t) small = parse_int8_t(TEXT("-129"), &consumed);
+
+    TEST_CHECK(small.error == ERR(ParseOverflow) && small.value == -128);
+    TEST_CHECK(small.src_line == line);
+    TEST_CHECK(strcmp(small.src_function, "test_integers") == 0);
+
+    TEST_CHECK(parse_int(TEXT(""), NULL).error == ERR(ParseEmpty));
+    TEST_CHECK(parse_int(TEXT("+1"), NULL).error == ERR(ParseInvalidDigit));
+    TEST_CHECK(parse_int(TEXT("-"), NULL).error == ERR(ParseEmpty));
+}
+
+static void test_base_types(void)
+{
+    TEST_CHECK(parse_char(TEXT("65"), NULL).value == 'A');
+    TEST_CHECK(parse_long(TEXT("-2147483649"), NULL).value == -2147483649L);
+    TEST_CHECK(parse_long_long(TEXT("-9223372036854775808"), NULL).value
+               == LLONG_MIN);
+    TEST_CHECK(parse_unsigned_char(TEXT("255"), NULL).value == UCHAR_MAX);
+    TEST_CHECK(parse_unsigned_char(TEXT("256"), NULL).error
+               == ERR(ParseOverflow));
+    TEST_CHECK(parse_unsigned_short(TEXT("65535"), NULL).value == USHRT_MAX);
+    TEST_CHECK(parse_unsigned_int(TEXT("4294967295"), NULL).value
+               == UINT_MAX);
+    TEST_CHECK(parse_unsigned_long(TEXT("-1"), NULL).error
+               == ERR(ParseInvalidDigit));
+    TEST_CHECK(parse_unsigned_long_long(TEXT("18446744073709551615"), NULL)
+               .value == ULLONG_MAX);
+    TEST_CHECK(parse_unsigned_long_long(TEXT("18446744073709551616"), NULL)
+               .error == ERR(ParseOverflow));
+}
+
+static void test_double(void)
+{
+    size_t consumed;
+    int line = __LINE__ + 1;
+    Result(double) number = parse_double(TEXT("1.5e3x"), &consumed);
+
+    TEST_CHECK(is_ok(number) && number.value == 1500.0 && consumed == 5);
+    TEST_CHECK(number.src_line == line);
+    TEST_CHECK(strcmp(number.src_function, "test_double") == 0);
+
+    TEST_CHECK(parse_double(TEXT("0.1"), NULL).value == 0.1);
+    TEST_CHECK(parse_double(TEXT("1e400"), NULL).error == ERR(ParseOverflow));
+    TEST_CHECK(parse_double(TEXT("."), NULL).error == ERR(ParseInvalidDigit));
+}
+
+static void test_columns(void)
+{
+    int64_t values[4];
+    size_t consumed;
+
+    Result(size_t) fields = parse_int64_t_column(TEXT("1,-2,3"), ',', values,
+                                                 4, &consumed);
+
+    TEST_CHECK(is_ok(fields) && fields.value == 3 && consumed == 6);
+    TEST_CHECK(values[0] == 1 && values[1] == -2 && values[2] == 3);
+
+    int line = __LINE__ + 1;
+    fields = parse_int64_t_column(TEXT("1,2,3,"), ',', values, 4, &consumed);
+
+    TEST_CHECK(fields.error == ERR(ParseEmpty));
+    TEST_CHECK(fields.value == 3 && consumed == 6);
+    TEST_CHECK(fields.src_line == line);
+
+    fields = parse_int64_t_column(TEXT("1,,3"), ',', values, 4, &consumed);
+    TEST_CHECK(fields.error == ERR(ParseEmpty) && fields.value == 1);
+
+    fields = parse_int64_t_column(TEXT("1,2x,3"), ',', values, 4, &consumed);
+    TEST_CHECK(fields.error == ERR(ParseInvalidDigit) && fields.value == 1);
+    TEST_CHECK(consumed == 3);
+
+    /* A full column leaves the rest of the text, delimiter included */
+    fields = parse_int64_t_column(TEXT("1,2,3"), ',', values, 2, &consumed);
+    TEST_CHECK(is_ok(fields) && fields.value == 2 && consumed == 3);
+
+    double numbers[2];
+    fields = parse_double_column(TEXT("0.5;2"), ';', numbers, 2, &consumed);
+    TEST_CHECK(is_ok(fields) && numbers[0] == 0.5 && numbers[1] == 2.0);
+
+    uint64_t counts[2];
+    fields = parse_uint64_t_column(TEXT("7;"), ';', counts, 2, &consumed);
+    TEST_CHECK(fields.error == ERR(ParseEmpty) && fields.value == 1);
+}
+
+int main(void)
+{
+    test_integers();
+    test_base_types();
+    test_double();
+    test_columns();
+
+    return TEST_EXIT_STATUS();
+}
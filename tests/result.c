@@ -0,0 +1,233 @@
+/*
+    RESULT.C - Tests of the result methods and their panic paths
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <result.h>
+#include <catch.h>
+
+#include "test.h"
+
+ERROR_DEFINE(TestFailure, OtherErrorExitCode, "The test failed on purpose.")
+
+static Result(int) fail(void)
+{
+    return result_ERR(int, TestFailure);
+}
+
+static int chain_calls = 0;
+
+static Result(int) add_one(int value)
+{
+    chain_calls++;
+    return result_OK(int, value + 1);
+}
+
+static Result(int) below_ten(int value)
+{
+    chain_calls++;
+    if (value >= 10) return result_ERR(int, TestFailure);
+
+    return result_OK(int, value);
+}
+
+static Result(void) unwrap_error(void* context)
+{
+    (void) context;
+    unwrap(int, fail());
+    return result_OK();
+}
+
+static Result(void) expect_error(void* context)
+{
+    (void) context;
+    expect(int, fail(), "Expected a number");
+    return result_OK();
+}
+
+static Result(void) unwrap_err_ok(void* context)
+{
+    (void) context;
+    unwrap_err(int, result_OK(int, 1));
+    return result_OK();
+}
+
+static Result(void) expect_err_ok(void* context)
+{
+    (void) context;
+    expect_err(int, result_OK(int, 1), "Expected an error");
+    return result_OK();
+}
+
+static void test_ok(void)
+{
+    Result(int) number = result_OK(int, 42);
+    Result(void) nothing = result_OK();
+
+    TEST_CHECK(is_ok(number) && !is_err(number));
+    TEST_CHECK(number.value == 42);
+    TEST_CHECK(is_ok(nothing));
+
+    /* Values with commas of their own pick the typed overload too */
+    Result(str_slice) text = result_OK(str_slice, (str_slice) { "abc", 3 });
+
+    TEST_CHECK(is_ok(text));
+    TEST_CHECK(text.value.length == 3 && text.value.data[0] == 'a');
+}
+
+static void test_err(void)
+{
+    Result(int) number = fail();
+
+    TEST_CHECK(is_err(number) && !is_ok(number));
+    TEST_CHECK(number.error == ERR(TestFailure));
+    TEST_CHECK(number.value == 0);
+    TEST_CHECK(strcmp(number.src_function, "fail") == 0);
+    TEST_CHECK(unwrap_or(int, number, 7) == 7);
+    TEST_CHECK(unwrap_err(int, number) == ERR(TestFailure));
+    TEST_CHECK(unwrap(int, result_OK(int, 3)) == 3);
+    TEST_CHECK(expect(int, result_OK(int, 4), "four") == 4);
+}
+
+static void test_chain(void)
+{
+    Result(int) (*stage)(int) = &add_one;
+    Result(int) chained = result_chain(int, result_OK(int, 1), add_one,
+                                       below_ten, stage);
+
+    TEST_CHECK(is_ok(chained) && chained.value == 3);
+    TEST_CHECK(chain_calls == 3);
+
+    /* The first error is returned, the later stages are not called */
+    chain_calls = 0;
+    chained = result_chain(int, result_OK(int, 9), add_one, below_ten,
+                           add_one, add_one);
+    TEST_CHECK(chained.error == ERR(TestFailure));
+    TEST_CHECK(chain_calls == 2);
+
+    chain_calls = 0;
+    chained = result_chain(int, fail(), add_one);
+    TEST_CHECK(chained.error == ERR(TestFailure) && chain_calls == 0);
+}
+
+static void test_panics(void)
+{
+    Result(void) caught = result_catch_panic(&unwrap_error, NULL);
+
+    TEST_CHECK(caught.error == ERR(Panicked));
+    TEST_CHECK(strcmp(caught.src_function, "unwrap_error") == 0);
+    TEST_CHECK(result_last_panic().exit_code == OtherErrorExitCode);
+    TEST_CHECK_STR_CONTAINS(result_last_panic().message,
+                            "Tried to unwrap from an error result.");
+    TEST_CHECK_STR_CONTAINS(result_last_panic().message,
+                            "The test failed on purpose. (from fail at");
+
+    caught = result_catch_panic(&expect_error, NULL);
+    TEST_CHECK(caught.error == ERR(Panicked));
+    TEST_CHECK_STR_CONTAINS(result_last_panic().message,
+                            "Expected a number: The test failed on purpose.");
+
+    caught = result_catch_panic(&unwrap_err_ok, NULL);
+    TEST_CHECK(caught.error == ERR(Panicked));
+    TEST_CHECK_STR_CONTAINS(result_last_panic().message,
+                            "Tried to unwrap an error from an ok result.");
+
+    caught = result_catch_panic(&expect_err_ok, NULL);
+    TEST_CHECK(caught.error == ERR(Panicked));
+    TEST_CHECK_STR_CONTAINS(result_last_panic().message, "Expected an error");
+}
+
+static int custom_panics = 0;
+static char custom_message[64];
+
+static void custom_panic(RESULT_PANIC_FUNCTION_PARAMTETERS)
+{
+    va_list arguments;
+    va_start(arguments, message);
+
+    (void) src_line;
+    (void) src_file;
+    (void) src_function;
+    (void) exit_code;
+
+    vsnprintf(custom_message, sizeof(custom_message), message, arguments);
+    va_end(arguments);
+
+    custom_panics++;
+}
+
+static Result(void) panic_with_code(void* context)
+{
+    panicf(*(int*) context, "Panic number %d", *(int*) context);
+    return result_OK();
+}
+
+static void test_panic_records(void)
+{
+    PanicRecord first;
+    PanicRecord second;
+    int code = 3;
+
+    Result(void) caught = result_catch_panic_record(&panic_with_code, &code,
+                                                    &first);
+    TEST_CHECK(caught.error == ERR(Panicked));
+
+    code = 4;
+    caught = result_catch_panic_record(&panic_with_code, &code, &second);
+    TEST_CHECK(caught.error == ERR(Panicked));
+
+    /* The record of the first panic outlives the second one */
+    TEST_CHECK(first.exit_code == 3 && second.exit_code == 4);
+    TEST_CHECK(strcmp(first.message, "Panic number 3") == 0);
+    TEST_CHECK(strcmp(second.message, "Panic number 4") == 0);
+    TEST_CHECK(strcmp(result_last_panic().message, "Panic number 4") == 0);
+
+    caught = result_catch_panic_record(&unwrap_error, NULL, NULL);
+    TEST_CHECK(caught.error == ERR(Panicked));
+}
+
+static void test_custom_panic_function(void)
+{
+    PanicFunction previous = panic_function;
+    panic_set_panic_function(&custom_panic);
+
+    /* Boundaries catch the panic before the custom function sees it */
+    int code = 5;
+    Result(void) caught = result_catch_panic(&panic_with_code, &code);
+
+    TEST_CHECK(caught.error == ERR(Panicked));
+    TEST_CHECK(custom_panics == 0);
+    TEST_CHECK(result_last_panic().exit_code == 5);
+
+    /* Outside of them it gets the formatted message */
+    panicf(7, "Outside %s", "of a boundary");
+    TEST_CHECK(custom_panics == 1);
+    TEST_CHECK(strcmp(custom_message, "Outside of a boundary") == 0);
+
+    panic_set_panic_function(previous);
+}
+
+int main(void)
+{
+    test_ok();
+    test_err();
+    test_chain();
+    test_panics();
+    test_panic_records();
+    test_custom_panic_function();
+
+    return TEST_EXIT_STATUS();
+}
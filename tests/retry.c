@@ -0,0 +1,147 @@
+/*
+    RETRY.C - Tests of result_retry
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <result.h>
+
+#include "test.h"
+
+ERROR_DEFINE(TestFailure, OtherErrorExitCode, "The test failed on purpose.")
+
+typedef struct {
+    int             calls;
+    int             failures;
+    const Error*    error;
+} Attempts;
+
+/* Fails with the error the given number of times, then succeeds */
+static Result(int) attempt(void* context)
+{
+    Attempts* attempts = context;
+
+    if (attempts->calls++ < attempts->failures)
+        return ___RESULT_ERR_RAW(int, attempts->error);
+
+    return result_OK(int, attempts->calls);
+}
+
+static RetryPolicy fast_policy(void)
+{
+    RetryPolicy policy = RETRY_POLICY_DEFAULT;
+
+    policy.initial_backoff_ns = 1000;
+    policy.max_backoff_ns = 4000;
+    policy.jitter = false;
+
+    return policy;
+}
+
+static void test_success_after_failures(void)
+{
+    RetryPolicy policy = fast_policy();
+    Attempts attempts = { .failures = 7, .error = ERR(ResourceUnavailable) };
+    RetryStats stats;
+
+    Result(int) result = result_retry(int, &policy, &stats, attempt, &attempts);
+
+    TEST_CHECK(is_ok(result) && result.value == 8);
+    TEST_CHECK(stats.attempts == 8);
+
+    /* 2 spins, 2 yields, then sleeps of 1, 2 and 4 us */
+    TEST_CHECK(stats.slept_ns == 7000);
+    TEST_CHECK(stats.elapsed_ns >= stats.slept_ns);
+}
+
+static void test_max_attempts(void)
+{
+    RetryPolicy policy = fast_policy();
+    policy.max_attempts = 3;
+
+    Attempts attempts = { .failures = 100, .error = ERR(ResourceUnavailable) };
+    RetryStats stats;
+
+    Result(int) result = result_retry(int, &policy, &stats, attempt, &attempts);
+
+    TEST_CHECK(result.error == ERR(ResourceUnavailable));
+    TEST_CHECK(attempts.calls == 3 && stats.attempts == 3);
+    TEST_CHECK(stats.slept_ns == 0);
+}
+
+static void test_deadline(void)
+{
+    RetryPolicy policy = fast_policy();
+    policy.max_attempts = 0;
+    policy.deadline_ns = 20000000;
+    policy.initial_backoff_ns = 1000000;
+    policy.max_backoff_ns = 1000000;
+
+    Attempts attempts = {
+        .failures = 1000000,
+        .error = ERR(ResourceUnavailable),
+    };
+    RetryStats stats;
+
+    Result(int) result = result_retry(int, &policy, &stats, attempt, &attempts);
+
+    TEST_CHECK(result.error == ERR(ResourceUnavailable));
+    TEST_CHECK(attempts.calls > 1 && attempts.calls < 1000);
+
+    /* No sleep is started past the deadline */
+    TEST_CHECK(stats.slept_ns < policy.deadline_ns);
+    TEST_CHECK(stats.elapsed_ns >= stats.slept_ns);
+}
+
+static void test_not_retryable(void)
+{
+    RetryPolicy policy = fast_policy();
+    Attempts attempts = { .failures = 5, .error = ERR(TestFailure) };
+    RetryStats stats;
+
+    Result(int) result = result_retry(int, &policy, &stats, attempt, &attempts);
+
+    TEST_CHECK(result.error == ERR(TestFailure));
+    TEST_CHECK(attempts.calls == 1 && stats.attempts == 1);
+    TEST_CHECK(stats.slept_ns == 0);
+}
+
+static void test_retryable_without_wait(void)
+{
+    RetryPolicy policy = fast_policy();
+    Attempts attempts = { .failures = 8, .error = ERR(InterruptedSysCall) };
+    RetryStats stats;
+
+    /* Interrupted calls are repeated at once, past the spins and yields */
+    Result(int) result = result_retry(int, &policy, &stats, attempt, &attempts);
+
+    TEST_CHECK(is_ok(result) && stats.attempts == 9);
+    TEST_CHECK(stats.slept_ns == 0);
+
+    attempts = (Attempts) { .failures = 0 };
+    result = result_retry(int, &policy, NULL, attempt, &attempts);
+    TEST_CHECK(is_ok(result) && attempts.calls == 1);
+}
+
+int main(void)
+{
+    test_success_after_failures();
+    test_max_attempts();
+    test_deadline();
+    test_not_retryable();
+    test_retryable_without_wait();
+
+    return TEST_EXIT_STATUS();
+}
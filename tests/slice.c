@@ -0,0 +1,164 @@
+/*
+    SLICE.C - Tests of the slices
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <slice.h>
+
+#include <string.h>
+
+#include "test.h"
+
+#define IS(slice, text) str_slice_equal(slice, str_slice_from_cstr(text))
+
+/* Splits the text and checks the tokens against the expected ones */
+static void check_split(const char* text, char delimiter,
+                        const char* const* expected, size_t count)
+{
+    str_slice rest = str_slice_from_cstr(text);
+    str_slice token;
+    size_t tokens = 0;
+
+    while (str_slice_split(&rest, delimiter, &token)) {
+        TEST_CHECK(tokens < count && IS(token, expected[tokens]));
+        tokens++;
+    }
+
+    TEST_CHECK(tokens == count);
+    TEST_CHECK(rest.data == NULL && rest.length == 0);
+}
+
+static void test_split(void)
+{
+    check_split("a,,b", ',', (const char* const[]) { "a", "", "b" }, 3);
+    check_split("", ',', (const char* const[]) { "" }, 1);
+    check_split(",", ',', (const char* const[]) { "", "" }, 2);
+    check_split("a,b,", ',', (const char* const[]) { "a", "b", "" }, 3);
+    check_split("abc", ',', (const char* const[]) { "abc" }, 1);
+
+    /* A used up rest gives no more tokens */
+    str_slice none = str_slice_from(NULL, 0);
+    str_slice token = str_slice_from_cstr("kept");
+    TEST_CHECK(!str_slice_split(&none, ',', &token) && IS(token, "kept"));
+}
+
+static void test_sub(void)
+{
+    str_slice text = str_slice_from_cstr("result");
+
+    Result(str_slice) middle = str_slice_sub(text, 1, 4);
+    TEST_CHECK(is_ok(middle) && IS(middle.value, "esu"));
+    TEST_CHECK(is_ok(str_slice_sub(text, 6, 6)));
+    TEST_CHECK(str_slice_sub(text, 6, 6).value.length == 0);
+    TEST_CHECK(IS(str_slice_sub(text, 0, 6).value, "result"));
+
+    int line = __LINE__ + 1;
+    Result(str_slice) past = str_slice_sub(text, 2, 7);
+    TEST_CHECK(past.error == ERR(SliceOutOfBounds) && past.src_line == line);
+    TEST_CHECK(str_slice_sub(text, 4, 3).error == ERR(SliceOutOfBounds));
+    TEST_CHECK(str_slice_sub(text, 7, 7).error == ERR(SliceOutOfBounds));
+
+    byte_slice bytes = byte_slice_from("\x01\x02\x03", 3);
+    Result(byte_slice) tail = byte_slice_sub(bytes, 1, 3);
+    TEST_CHECK(is_ok(tail) && tail.value.length == 2);
+    TEST_CHECK(tail.value.data[0] == 2);
+    TEST_CHECK(byte_slice_sub(bytes, 0, 4).error == ERR(SliceOutOfBounds));
+}
+
+static void test_take(void)
+{
+    str_slice rest = str_slice_from_cstr("GET /");
+
+    Result(str_slice) method = str_slice_take(&rest, 3);
+    TEST_CHECK(is_ok(method) && IS(method.value, "GET") && IS(rest, " /"));
+
+    /* Out of bounds leaves the rest untouched */
+    const char* data = rest.data;
+    TEST_CHECK(str_slice_take(&rest, 3).error == ERR(SliceOutOfBounds));
+    TEST_CHECK(rest.data == data && rest.length == 2);
+
+    TEST_CHECK(is_ok(str_slice_take(&rest, 2)) && rest.length == 0);
+    TEST_CHECK(is_ok(str_slice_take(&rest, 0)) && rest.length == 0);
+
+    byte_slice bytes = byte_slice_from("\x00\x10\x20\x30", 4);
+    Result(byte_slice) header = byte_slice_take(&bytes, 2);
+    TEST_CHECK(is_ok(header) && header.value.length == 2);
+    TEST_CHECK(header.value.data[1] == 0x10 && bytes.data[0] == 0x20);
+
+    const uint8_t* before = bytes.data;
+    Result(byte_slice) long_header = byte_slice_take(&bytes, 3);
+    TEST_CHECK(long_header.error == ERR(SliceOutOfBounds));
+    TEST_CHECK(bytes.data == before && bytes.length == 2);
+}
+
+static void test_trim(void)
+{
+    TEST_CHECK(IS(str_slice_trim(str_slice_from_cstr(" \t a b \r\n")), "a b"));
+    TEST_CHECK(IS(str_slice_trim(str_slice_from_cstr("ab")), "ab"));
+    TEST_CHECK(str_slice_trim(str_slice_from_cstr(" \v\f ")).length == 0);
+    TEST_CHECK(str_slice_trim(str_slice_from_cstr("")).length == 0);
+}
+
+static void test_search(void)
+{
+    str_slice path = str_slice_from_cstr("/usr/lib/libresult.so");
+
+    TEST_CHECK(str_slice_starts_with(path, str_slice_from_cstr("/usr")));
+    TEST_CHECK(!str_slice_starts_with(path, str_slice_from_cstr("/lib")));
+    TEST_CHECK(str_slice_starts_with(path, str_slice_from_cstr("")));
+    TEST_CHECK(str_slice_ends_with(path, str_slice_from_cstr(".so")));
+    TEST_CHECK(!str_slice_ends_with(path, str_slice_from_cstr(".a")));
+    TEST_CHECK(str_slice_ends_with(path, path));
+    TEST_CHECK(!str_slice_ends_with(str_slice_from_cstr("so"),
+                                    str_slice_from_cstr(".so")));
+
+    TEST_CHECK(str_slice_find(path, '/') == 0);
+    TEST_CHECK(str_slice_find(path, '.') == 18);
+    TEST_CHECK(str_slice_find(path, '#') == path.length);
+}
+
+/* A slice over no memory, like the rest after the last token */
+static void test_null_data(void)
+{
+    str_slice none = str_slice_from(NULL, 0);
+
+    TEST_CHECK(str_slice_find(none, ',') == 0);
+    TEST_CHECK(str_slice_trim(none).data == NULL);
+    TEST_CHECK(str_slice_equal(none, str_slice_from_cstr("")));
+    TEST_CHECK(str_slice_starts_with(none, none));
+    TEST_CHECK(str_slice_ends_with(none, none));
+
+    Result(str_slice) empty = str_slice_sub(none, 0, 0);
+    TEST_CHECK(is_ok(empty) && empty.value.data == NULL);
+    TEST_CHECK(str_slice_sub(none, 0, 1).error == ERR(SliceOutOfBounds));
+
+    TEST_CHECK(is_ok(str_slice_take(&none, 0)) && none.data == NULL);
+
+    byte_slice no_bytes = byte_slice_from(NULL, 0);
+    TEST_CHECK(is_ok(byte_slice_take(&no_bytes, 0)) && no_bytes.data == NULL);
+}
+
+int main(void)
+{
+    test_split();
+    test_sub();
+    test_take();
+    test_trim();
+    test_search();
+    test_null_data();
+
+    return TEST_EXIT_STATUS();
+}
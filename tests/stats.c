@@ -0,0 +1,123 @@
+/*
+    STATS.C - Tests of the shared error counters and their reader
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stats.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "test.h"
+
+ERROR_DEFINE(TestFailure, OtherErrorExitCode, "The test failed on purpose.")
+
+static uint64_t count_of(const ResultStatsMap* map, const Error* error)
+{
+    for (size_t i = 0; i < RESULT_STATS_ERRORS; i++)
+        if (atomic_load(&map->errors[i].key) == (uint64_t) (uintptr_t) error)
+            return atomic_load(&map->errors[i].count);
+
+    return 0;
+}
+
+static void test_export(void)
+{
+    char name[64];
+    ResultStatsReader reader;
+
+    snprintf(name, sizeof(name), "/result-test-%d", (int) getpid());
+    TEST_CHECK(is_ok(result_stats_export(name)));
+
+    for (int i = 0; i < 3; i++) result_ERR(int, TestFailure);
+
+    TEST_CHECK(is_ok(result_stats_attach(&reader, name)));
+    TEST_CHECK(reader.map->pid == (int64_t) getpid());
+    TEST_CHECK(count_of(reader.map, ERR(TestFailure)) == 3);
+    TEST_CHECK(result_stats_has(&reader, exit_codes));
+
+    result_stats_detach(&reader);
+    result_stats_unexport();
+}
+
+/* Writes a map header of the version and size to a file of file_size bytes */
+static void write_map(const char* path, uint16_t major, uint16_t minor,
+                      size_t size, size_t file_size)
+{
+    ResultStatsMap* map = calloc(1, file_size > sizeof(*map)
+                                    ? file_size : sizeof(*map));
+    FILE* file = fopen(path, "wb");
+
+    atomic_init(&map->magic, RESULT_STATS_MAGIC);
+    map->major = major;
+    map->minor = minor;
+    map->size = (uint32_t) size;
+    map->errors_size = RESULT_STATS_ERRORS;
+    map->exit_codes_size = RESULT_STATS_EXIT_CODES;
+
+    fwrite(map, 1, file_size, file);
+    fclose(file);
+    free(map);
+}
+
+static void test_versions(void)
+{
+    char path[] = "/tmp/result-stats-test-XXXXXX";
+    int descriptor = mkstemp(path);
+    ResultStatsReader reader;
+
+    TEST_CHECK(descriptor >= 0);
+    close(descriptor);
+
+    /* A later minor version adds fields at the end, it's read like 1.0 */
+    size_t later = RESULT_STATS_SIZE_1_0 + 64;
+    write_map(path, RESULT_STATS_MAJOR, RESULT_STATS_MINOR + 1, later, later);
+    TEST_CHECK(is_ok(result_stats_attach(&reader, path)));
+    TEST_CHECK(reader.map->minor == RESULT_STATS_MINOR + 1);
+    result_stats_detach(&reader);
+
+    write_map(path, RESULT_STATS_MAJOR + 1, 0, later, later);
+    TEST_CHECK(result_stats_attach(&reader, path).error
+               == ERR(StatsLayoutMismatch));
+
+    /* Smaller than 1.0, or claiming more than the file holds */
+    write_map(path, RESULT_STATS_MAJOR, 0, RESULT_STATS_SIZE_1_0 - 8,
+              RESULT_STATS_SIZE_1_0 - 8);
+    TEST_CHECK(result_stats_attach(&reader, path).error
+               == ERR(StatsLayoutMismatch));
+
+    write_map(path, RESULT_STATS_MAJOR, 0, later, RESULT_STATS_SIZE_1_0);
+    TEST_CHECK(result_stats_attach(&reader, path).error
+               == ERR(StatsLayoutMismatch));
+
+    unlink(path);
+
+    /* The reader has errors of its own, it doesn't bind errno like the ports */
+    Result(void) missing = result_stats_attach(&reader, path);
+    TEST_CHECK(missing.error == ERR(StatsNotFound));
+    TEST_CHECK(result_is_kind(missing, FileOperationFailed));
+    TEST_CHECK(result_stats_attach(&reader, "/result-stats-missing").error
+               == ERR(StatsNotFound));
+}
+
+int main(void)
+{
+    test_export();
+    test_versions();
+
+    return TEST_EXIT_STATUS();
+}
@@ -0,0 +1,45 @@
+/*
+    TEST.H - Checks shared by the test programs
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ___RESULT__TEST___
+#define ___RESULT__TEST___
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+    Every test is a program of its own, meson runs them and reads the exit
+    status. Failed checks are printed and counted, the program keeps going.
+*/
+static int ___test_failures = 0;
+
+#define TEST_CHECK(condition)                                                   \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,    \
+                    #condition);                                                \
+            ___test_failures++;                                                 \
+        }                                                                       \
+    } while (0)
+
+#define TEST_CHECK_STR_CONTAINS(text, part)                                     \
+    TEST_CHECK((text) != NULL && strstr((text), (part)) != NULL)
+
+#define TEST_EXIT_STATUS() (___test_failures == 0 ? 0 : 1)
+
+#endif
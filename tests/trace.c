@@ -0,0 +1,196 @@
+/*
+    TRACE.C - Tests of the sampled tracer
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <trace.h>
+
+#include <ctype.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "test.h"
+
+ERROR_DEFINE(TestFailure, OtherErrorExitCode, "The test \"failed\" on purpose.")
+
+/* A strict JSON reader, it only tells if the text is one valid value */
+static bool parse_value(const char** text);
+
+static void skip_space(const char** text)
+{
+    while (isspace((unsigned char) **text)) (*text)++;
+}
+
+static bool parse_string(const char** text)
+{
+    if (*(*text)++ != '"') return false;
+
+    for (; **text != '"'; (*text)++) {
+        if ((unsigned char) **text < 0x20) return false;
+        if (**text == '\\' && *++(*text) == '\0') return false;
+    }
+
+    (*text)++;
+    return true;
+}
+
+static bool parse_number(const char** text)
+{
+    char* end;
+
+    strtod(*text, &end);
+    if (end == *text) return false;
+
+    *text = end;
+    return true;
+}
+
+static bool parse_list(const char** text, char close, bool keys)
+{
+    (*text)++;
+    skip_space(text);
+    if (**text == close) {
+        (*text)++;
+        return true;
+    }
+
+    for (;;) {
+        if (keys) {
+            skip_space(text);
+            if (!parse_string(text)) return false;
+            skip_space(text);
+            if (*(*text)++ != ':') return false;
+        }
+
+        if (!parse_value(text)) return false;
+
+        skip_space(text);
+        if (**text == close) {
+            (*text)++;
+            return true;
+        }
+        if (*(*text)++ != ',') return false;
+    }
+}
+
+static bool parse_value(const char** text)
+{
+    skip_space(text);
+
+    switch (**text) {
+    case '{': return parse_list(text, '}', true);
+    case '[': return parse_list(text, ']', false);
+    case '"': return parse_string(text);
+    default: return parse_number(text);
+    }
+}
+
+static char* read_file(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char* text = calloc(1, (size_t) size + 1);
+    if (fread(text, 1, (size_t) size, file) != (size_t) size) text[0] = '\0';
+
+    fclose(file);
+    return text;
+}
+
+static void* create_errors(void* count)
+{
+    for (long i = 0; i < (long) (intptr_t) count; i++)
+        result_ERR(int, TestFailure);
+
+    return NULL;
+}
+
+static void test_rate_and_dump(void)
+{
+    char path[] = "/tmp/result-trace-test-XXXXXX";
+    int descriptor = mkstemp(path);
+    pthread_t thread;
+
+    close(descriptor);
+
+    /* Every thread counts its own errors, the first one is recorded */
+    result_trace_start(4);
+    create_errors((void*) (intptr_t) 400);
+    pthread_create(&thread, NULL, &create_errors, (void*) (intptr_t) 41);
+    pthread_join(thread, NULL);
+    result_trace_stop();
+
+    /* Stopped, nothing more is recorded */
+    create_errors((void*) (intptr_t) 100);
+
+    TEST_CHECK(is_ok(result_trace_dump(path)));
+
+    char* text = read_file(path);
+    TEST_CHECK(text != NULL);
+    if (text == NULL) return;
+
+    const char* end = text;
+    TEST_CHECK(parse_value(&end));
+    skip_space(&end);
+    TEST_CHECK(*end == '\0');
+
+    /* One event per line, 100 of the first thread and 11 of the other one */
+    int events = 0;
+    long first_tid = -1, other_tids = 0;
+    double last_ts = 0;
+
+    for (char* line = strstr(text, "\n{"); line != NULL;
+         line = strstr(line + 1, "\n{")) {
+        char* ts = strstr(line, "\"ts\":");
+        char* tid = strstr(line, "\"tid\":");
+
+        TEST_CHECK(strncmp(strstr(line, "\"ph\":"), "\"ph\":\"i\"", 8) == 0);
+        TEST_CHECK(strstr(line, "\\\"failed\\\"") != NULL);
+        TEST_CHECK(ts != NULL && tid != NULL);
+        if (ts == NULL || tid == NULL) break;
+
+        /* The events are sorted by their time */
+        double time = strtod(ts + 5, NULL);
+        TEST_CHECK(time >= last_ts);
+        last_ts = time;
+
+        long id = strtol(tid + 6, NULL, 10);
+        if (first_tid < 0) first_tid = id;
+        if (id != first_tid) other_tids++;
+
+        events++;
+    }
+
+    TEST_CHECK(events == 111);
+    TEST_CHECK(other_tids == 11);
+
+    free(text);
+    unlink(path);
+}
+
+int main(void)
+{
+    test_rate_and_dump();
+
+    return TEST_EXIT_STATUS();
+}
@@ -0,0 +1,269 @@
+/*
+    VALIDATE.C - Tests of the text validation
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <ports/text/validate.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include "test.h"
+
+/* Longer texts go through the vector kernels, in blocks of 64 bytes */
+#define TEXT_SIZE 512
+
+/* Decodes every code point, the kernels are checked against it */
+static size_t reference_utf8(const unsigned char* text, size_t length)
+{
+    static const uint32_t smallest[] = { 0, 0, 0x80, 0x800, 0x10000 };
+    size_t i = 0;
+
+    while (i < length) {
+        unsigned char lead = text[i];
+        uint32_t code_point;
+        size_t size;
+
+        if (lead < 0x80) {
+            i++;
+            continue;
+        } else if ((lead & 0xE0) == 0xC0) {
+            size = 2;
+            code_point = lead & 0x1F;
+        } else if ((lead & 0xF0) == 0xE0) {
+            size = 3;
+            code_point = lead & 0x0F;
+        } else if ((lead & 0xF8) == 0xF0) {
+            size = 4;
+            code_point = lead & 0x07;
+        } else return i;
+
+        if (length - i < size) return i;
+
+        for (size_t j = 1; j < size; j++) {
+            if ((text[i + j] & 0xC0) != 0x80) return i;
+            code_point = code_point << 6 | (text[i + j] & 0x3F);
+        }
+
+        if (code_point < smallest[size] || code_point > 0x10FFFF ||
+            (code_point >= 0xD800 && code_point <= 0xDFFF))
+            return i;
+
+        i += size;
+    }
+
+    return length;
+}
+
+static size_t validate_utf8(const unsigned char* text, size_t length)
+{
+    Result(size_t) valid = text_validate_utf8((const char*) text, length);
+
+    TEST_CHECK(is_ok(valid) ? valid.value == length
+                            : valid.error == ERR(InvalidUtf8));
+    return valid.value;
+}
+
+static const struct {
+    const char* bytes;
+    size_t offset;
+} cases[] = {
+    /* The boundaries of every length */
+    { "\x7F", 1 },
+    { "\xC2\x80", 2 },
+    { "\xDF\xBF", 2 },
+    { "\xE0\xA0\x80", 3 },
+    { "\xEF\xBF\xBF", 3 },
+    { "\xF0\x90\x80\x80", 4 },
+    { "\xF4\x8F\xBF\xBF", 4 },
+    { "\xF4\x90\x80\x80", 0 },
+    { "\xF5\x80\x80\x80", 0 },
+    { "\xFF", 0 },
+
+    /* Overlong forms */
+    { "\xC0\x80", 0 },
+    { "\xC1\xBF", 0 },
+    { "\xE0\x80\x80", 0 },
+    { "\xE0\x9F\xBF", 0 },
+    { "\xF0\x80\x80\x80", 0 },
+    { "\xF0\x8F\xBF\xBF", 0 },
+
+    /* Surrogates, and the code points around them */
+    { "\xED\x9F\xBF", 3 },
+    { "\xED\xA0\x80", 0 },
+    { "\xED\xBF\xBF", 0 },
+    { "\xEE\x80\x80", 3 },
+
+    /* Truncated sequences, and continuations without a lead */
+    { "\xC2", 0 },
+    { "\xE0\xA0", 0 },
+    { "\xF0\x90\x80", 0 },
+    { "\xC2\x41", 0 },
+    { "\xE2\x82\x41", 0 },
+    { "\xF0\x90\x80\x41", 0 },
+    { "\x80", 0 },
+    { "\xBF\x80", 0 },
+    { "\xC2\x80\x80", 2 },
+};
+
+#define CASES (sizeof(cases) / sizeof(*cases))
+
+static void test_cases(void)
+{
+    for (size_t c = 0; c < CASES; c++) {
+        const unsigned char* bytes = (const unsigned char*) cases[c].bytes;
+        size_t length = strlen(cases[c].bytes);
+
+        TEST_CHECK(reference_utf8(bytes, length) ==
+                   (cases[c].offset == length ? length : cases[c].offset));
+        TEST_CHECK(validate_utf8(bytes, length) ==
+                   reference_utf8(bytes, length));
+    }
+}
+
+/*
+    Puts every case at every offset of a longer text, over ASCII and over
+    two byte sequences, so it falls on both sides of the block boundaries
+*/
+static void test_positions(void)
+{
+    unsigned char text[TEXT_SIZE];
+
+    for (size_t c = 0; c < CASES; c++) {
+        size_t length = strlen(cases[c].bytes);
+
+        for (size_t offset = 0; offset + length + 8 <= 200; offset++) {
+            for (int filler = 0; filler < 2; filler++) {
+                for (size_t i = 0; i < sizeof(text); i++)
+                    text[i] = filler ? (i % 2 ? 0xA9 : 0xC3) : 'a';
+
+                /* The case starts right after a whole two byte sequence */
+                size_t start = filler ? offset & ~(size_t) 1 : offset;
+                memcpy(text + start, cases[c].bytes, length);
+                if (filler && (length % 2)) text[start + length] = 'a';
+
+                TEST_CHECK(validate_utf8(text, sizeof(text)) ==
+                           reference_utf8(text, sizeof(text)));
+                TEST_CHECK(validate_utf8(text, start + length) ==
+                           reference_utf8(text, start + length));
+            }
+        }
+    }
+}
+
+static size_t encode(unsigned char* text, uint32_t code_point)
+{
+    if (code_point < 0x80) {
+        text[0] = (unsigned char) code_point;
+        return 1;
+    }
+
+    size_t size = code_point < 0x800 ? 2 : code_point < 0x10000 ? 3 : 4;
+    static const unsigned char leads[] = { 0, 0, 0xC0, 0xE0, 0xF0 };
+
+    for (size_t i = size - 1; i > 0; i--, code_point >>= 6)
+        text[i] = (unsigned char) (0x80 | (code_point & 0x3F));
+    text[0] = (unsigned char) (leads[size] | code_point);
+
+    return size;
+}
+
+/* Random texts, mostly valid, with a malformed byte here and there */
+static void test_random(void)
+{
+    static const uint32_t code_points[] = {
+        0x24, 0x7F, 0xA2, 0x7FF, 0x800, 0x20AC, 0xD7FF, 0xE000, 0xFFFF,
+        0x10000, 0x1F600, 0x10FFFF,
+    };
+    unsigned char text[TEXT_SIZE + 4];
+    uint64_t state = 0x9E3779B97F4A7C15u;
+
+    for (int round = 0; round < 5000; round++) {
+        size_t length = 0;
+
+        state = state * 6364136223846793005u + 1442695040888963407u;
+        size_t size = (size_t) (state >> 33) % TEXT_SIZE;
+
+        while (length < size) {
+            state = state * 6364136223846793005u + 1442695040888963407u;
+            uint32_t choice = (uint32_t) (state >> 33);
+
+            if (choice % 512 == 0) {
+                text[length++] = (unsigned char) (choice >> 9);
+                continue;
+            }
+
+            if (choice % 4) {
+                text[length++] = (unsigned char) ('a' + choice % 26);
+                continue;
+            }
+
+            length += encode(text + length, code_points[
+                (choice >> 9) % (sizeof(code_points) / sizeof(*code_points))]);
+        }
+
+        /* Cutting the text can also leave a sequence truncated */
+        TEST_CHECK(validate_utf8(text, size) == reference_utf8(text, size));
+    }
+}
+
+static void test_ascii_and_nul(void)
+{
+    char text[TEXT_SIZE];
+
+    TEST_CHECK(text_validate_ascii("", 0).value == 0);
+    TEST_CHECK(text_validate_no_nul("", 0).value == 0);
+
+    for (size_t offset = 0; offset < sizeof(text); offset += 7) {
+        memset(text, 'a', sizeof(text));
+        text[offset] = (char) 0x80;
+
+        Result(size_t) ascii = text_validate_ascii(text, sizeof(text));
+        TEST_CHECK(ascii.error == ERR(NonAsciiCharacter) &&
+                   ascii.value == offset);
+        TEST_CHECK(text_validate_ascii(text, offset).value == offset);
+        TEST_CHECK(is_ok(text_validate_ascii(text, offset)));
+
+        text[offset] = '\0';
+
+        Result(size_t) nul = text_validate_no_nul(text, sizeof(text));
+        TEST_CHECK(nul.error == ERR(UnexpectedNulByte) && nul.value == offset);
+        TEST_CHECK(is_ok(text_validate_no_nul(text, offset)));
+    }
+}
+
+static void test_location(void)
+{
+    int line = __LINE__ + 1;
+    Result(size_t) invalid = text_validate_utf8("\xC0\x80", 2);
+    Result(size_t) valid = text_validate_ascii("text", 4);
+
+    TEST_CHECK(invalid.src_line == line);
+    TEST_CHECK(strcmp(invalid.src_file, __FILE__) == 0);
+    TEST_CHECK(strcmp(invalid.src_function, __func__) == 0);
+    TEST_CHECK(valid.src_line == line + 1 && valid.value == 4);
+}
+
+int main(void)
+{
+    test_cases();
+    test_positions();
+    test_random();
+    test_ascii_and_nul();
+    test_location();
+
+    return TEST_EXIT_STATUS();
+}
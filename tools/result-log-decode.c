@@ -0,0 +1,286 @@
+/*
+    RESULT-LOG-DECODE.C - Decoding binary logs of errors
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+    result-log-decode [--json] [log]
+
+    Prints the records of a log written by result_log_start, one per line,
+    as text or as JSON objects. Reads the standard input without a log.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logformat.h"
+
+typedef struct {
+    uint64_t    id;
+    int32_t     exit_code;
+    char*       text;
+} Definition;
+
+static Definition* definitions = NULL;
+static size_t definitions_size = 0;
+static size_t definitions_count = 0;
+
+static size_t slot_of(uint64_t id)
+{
+    size_t mask = definitions_size - 1;
+    size_t slot = (id * 0x9e3779b97f4a7c15u) >> 32 & mask;
+
+    while (definitions[slot].id != 0 && definitions[slot].id != id)
+        slot = (slot + 1) & mask;
+
+    return slot;
+}
+
+static const Definition* find(uint64_t id)
+{
+    if (id == 0 || definitions_size == 0) return NULL;
+
+    const Definition* definition = &definitions[slot_of(id)];
+    return definition->id == id ? definition : NULL;
+}
+
+static void define(uint64_t id, int32_t exit_code, char* text)
+{
+    if (id == 0) {
+        free(text);
+        return;
+    }
+
+    if ((definitions_count + 1) * 2 > definitions_size) {
+        Definition* old = definitions;
+        size_t old_size = definitions_size;
+
+        definitions_size = old_size ? old_size * 2 : 256;
+        definitions = calloc(definitions_size, sizeof(*definitions));
+        if (definitions == NULL) {
+            fprintf(stderr, "result-log-decode: out of memory\n");
+            exit(1);
+        }
+
+        for (size_t i = 0; i < old_size; i++)
+            if (old[i].id != 0) definitions[slot_of(old[i].id)] = old[i];
+
+        free(old);
+    }
+
+    Definition* definition = &definitions[slot_of(id)];
+
+    if (definition->id == id) free(definition->text);
+    else definitions_count++;
+
+    *definition = (Definition) {
+        .id = id,
+        .exit_code = exit_code,
+        .text = text,
+    };
+}
+
+static bool read_exactly(FILE* file, void* data, size_t size)
+{
+    return fread(data, 1, size, file) == size;
+}
+
+static char* read_text(FILE* file)
+{
+    uint32_t length;
+    if (!read_exactly(file, &length, sizeof(length))) return NULL;
+
+    char* text = malloc((size_t) length + 1);
+    if (text == NULL || !read_exactly(file, text, length)) {
+        free(text);
+        return NULL;
+    }
+
+    text[length] = '\0';
+    return text;
+}
+
+static void print_json_string(const char* string)
+{
+    putchar('"');
+
+    for (; string != NULL && *string != '\0'; string++) {
+        unsigned char c = (unsigned char) *string;
+
+        if (c == '"' || c == '\\') printf("\\%c", c);
+        else if (c < 0x20) printf("\\u%04x", c);
+        else putchar(c);
+    }
+
+    putchar('"');
+}
+
+static const char* text_of(uint64_t id)
+{
+    const Definition* definition = find(id);
+    return definition ? definition->text : NULL;
+}
+
+static bool print_record(FILE* file, bool json)
+{
+    struct {
+        uint64_t timestamp_ns, error, file, function;
+        uint32_t line, thread, count;
+    } record;
+    uint64_t arguments[256];
+
+    if (!read_exactly(file, &record.timestamp_ns, 8)
+        || !read_exactly(file, &record.error, 8)
+        || !read_exactly(file, &record.file, 8)
+        || !read_exactly(file, &record.function, 8)
+        || !read_exactly(file, &record.line, 4)
+        || !read_exactly(file, &record.thread, 4)
+        || !read_exactly(file, &record.count, 4)
+        || record.count > 256
+        || !read_exactly(file, arguments, record.count * sizeof(uint64_t)))
+        return false;
+
+    const Definition* error = find(record.error);
+    const char* message = error ? error->text : "unknown error";
+    const char* source = text_of(record.file);
+    const char* function = text_of(record.function);
+
+    if (json) {
+        printf("{\"timestamp_ns\":%llu,\"thread\":%lu,\"message\":",
+               (unsigned long long) record.timestamp_ns,
+               (unsigned long) record.thread);
+        print_json_string(message);
+        printf(",\"exit_code\":%d", error ? error->exit_code : 0);
+
+        if (source != NULL) {
+            printf(",\"file\":");
+            print_json_string(source);
+            printf(",\"line\":%d", (int32_t) record.line);
+        }
+        if (function != NULL) {
+            printf(",\"function\":");
+            print_json_string(function);
+        }
+
+        printf(",\"arguments\":[");
+        for (uint32_t i = 0; i < record.count; i++)
+            printf("%s%llu", i ? "," : "", (unsigned long long) arguments[i]);
+        printf("]}\n");
+    } else {
+        printf("%llu.%09llu [%lu] %s",
+               (unsigned long long) (record.timestamp_ns / 1000000000u),
+               (unsigned long long) (record.timestamp_ns % 1000000000u),
+               (unsigned long) record.thread, message);
+
+        if (function != NULL || source != NULL)
+            printf(" (from %s at %s:%d)", function ? function : "?",
+                   source ? source : "?", (int32_t) record.line);
+
+        for (uint32_t i = 0; i < record.count; i++)
+            printf("%s%llu", i ? ", " : " [", (unsigned long long) arguments[i]);
+        printf("%s\n", record.count ? "]" : "");
+    }
+
+    return true;
+}
+
+static bool print_dropped(FILE* file, bool json)
+{
+    uint32_t thread;
+    uint64_t dropped;
+
+    if (!read_exactly(file, &thread, sizeof(thread))
+        || !read_exactly(file, &dropped, sizeof(dropped)))
+        return false;
+
+    if (json)
+        printf("{\"thread\":%lu,\"dropped\":%llu}\n", (unsigned long) thread,
+               (unsigned long long) dropped);
+    else
+        printf("[%lu] %llu records dropped\n", (unsigned long) thread,
+               (unsigned long long) dropped);
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    bool json = false;
+    const char* path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) json = true;
+        else if (path == NULL) path = argv[i];
+        else {
+            fprintf(stderr, "usage: result-log-decode [--json] [log]\n");
+            return 2;
+        }
+    }
+
+    FILE* file = path ? fopen(path, "rb") : stdin;
+    if (file == NULL) {
+        perror(path);
+        return 1;
+    }
+
+    char magic[sizeof(___RESULT_LOG_MAGIC) - 1];
+    if (!read_exactly(file, magic, sizeof(magic))
+        || memcmp(magic, ___RESULT_LOG_MAGIC, sizeof(magic)) != 0) {
+        fprintf(stderr, "result-log-decode: not a result log\n");
+        return 1;
+    }
+
+    for (int tag; (tag = fgetc(file)) != EOF;) {
+        bool complete = true;
+        uint64_t id;
+        int32_t exit_code = 0;
+        char* text;
+
+        switch (tag) {
+        case ___RESULT_LOG_ERROR:
+            complete = read_exactly(file, &id, sizeof(id))
+                       && read_exactly(file, &exit_code, sizeof(exit_code))
+                       && (text = read_text(file)) != NULL;
+            if (complete) define(id, exit_code, text);
+            break;
+        case ___RESULT_LOG_STRING:
+            complete = read_exactly(file, &id, sizeof(id))
+                       && (text = read_text(file)) != NULL;
+            if (complete) define(id, 0, text);
+            break;
+        case ___RESULT_LOG_RECORD:
+            complete = print_record(file, json);
+            break;
+        case ___RESULT_LOG_DROPPED:
+            complete = print_dropped(file, json);
+            break;
+        default:
+            fprintf(stderr, "result-log-decode: unknown entry '%c'\n", tag);
+            return 1;
+        }
+
+        /* A log cut short, like one of a crashed process */
+        if (!complete) {
+            fprintf(stderr, "result-log-decode: the log ends mid entry\n");
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,173 @@
+/*
+    RESULT-STATS.C - Prints the error rates of running processes
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+    result-stats [-i seconds] [-n count] stats...
+
+    Attaches read-only to the counters exported with result_stats_export, by
+    their names or paths (like /proc/<pid>/fd/<fd>), and prints the error
+    rates every interval (1 second), count times (0 - forever). The first
+    rates are averages since the process started counting.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <statsmap.h>
+
+typedef struct {
+    const char*         name;
+    ResultStatsReader   reader;
+    uint64_t            total;
+    uint64_t            errors[RESULT_STATS_ERRORS];
+    uint64_t            exit_codes[RESULT_STATS_EXIT_CODES];
+} Target;
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+static double rate(uint64_t count, uint64_t previous, double seconds)
+{
+    return seconds > 0 ? (double) (count - previous) / seconds : 0;
+}
+
+static void print_target(Target* target, double seconds)
+{
+    const ResultStatsMap* map = target->reader.map;
+    uint64_t dropped = atomic_load_explicit(&map->dropped,
+                                            memory_order_relaxed);
+    uint64_t total = dropped;
+
+    for (size_t i = 0; i < RESULT_STATS_ERRORS; i++)
+        total += atomic_load_explicit(&map->errors[i].count,
+                                      memory_order_relaxed);
+
+    printf("%s (pid %lld): %.1f errors/s, %llu total, %llu dropped\n",
+           target->name, (long long) map->pid,
+           rate(total, target->total, seconds), (unsigned long long) total,
+           (unsigned long long) dropped);
+    target->total = total;
+
+    for (size_t i = 0; i < RESULT_STATS_ERRORS; i++) {
+        const ResultStatsError* error = &map->errors[i];
+
+        if (!atomic_load_explicit(&error->ready, memory_order_acquire))
+            continue;
+
+        uint64_t count = atomic_load_explicit(&error->count,
+                                              memory_order_relaxed);
+
+        printf("  %12.1f/s %12llu  exit %4d  %.*s\n",
+               rate(count, target->errors[i], seconds),
+               (unsigned long long) count, error->exit_code,
+               RESULT_STATS_MESSAGE_SIZE, error->message);
+        target->errors[i] = count;
+    }
+
+    for (size_t i = 0; i < RESULT_STATS_EXIT_CODES; i++) {
+        const ResultStatsExitCode* code = &map->exit_codes[i];
+        uint64_t key = atomic_load_explicit(&code->key, memory_order_acquire);
+
+        if (key == 0) continue;
+
+        uint64_t count = atomic_load_explicit(&code->count,
+                                              memory_order_relaxed);
+
+        printf("  %12.1f/s %12llu  exit %4d  (all errors)\n",
+               rate(count, target->exit_codes[i], seconds),
+               (unsigned long long) count, (int32_t) (uint32_t) key);
+        target->exit_codes[i] = count;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double interval = 1;
+    long samples = 0;
+    int first = 1;
+
+    for (; first + 1 < argc && argv[first][0] == '-'; first += 2) {
+        if (strcmp(argv[first], "-i") == 0)
+            interval = atof(argv[first + 1]);
+        else if (strcmp(argv[first], "-n") == 0)
+            samples = atol(argv[first + 1]);
+        else
+            break;
+    }
+
+    if (first >= argc || argv[first][0] == '-' || interval <= 0) {
+        fprintf(stderr,
+                "usage: result-stats [-i seconds] [-n count] stats...\n");
+        return 2;
+    }
+
+    size_t count = (size_t) (argc - first);
+    Target* targets = calloc(count, sizeof(*targets));
+    if (targets == NULL) {
+        fprintf(stderr, "result-stats: out of memory\n");
+        return 1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        targets[i].name = argv[first + (int) i];
+
+        Result(void) attached = result_stats_attach(&targets[i].reader,
+                                                    targets[i].name);
+        if (is_err(attached)) {
+            fprintf(stderr, "result-stats: %s: %s\n", targets[i].name,
+                    attached.error->message);
+            return 1;
+        }
+    }
+
+    struct timespec pause = {
+        .tv_sec = (time_t) interval,
+        .tv_nsec = (long) ((interval - (double) (time_t) interval) * 1e9),
+    };
+    uint64_t previous = 0;
+
+    for (long sample = 0; samples == 0 || sample < samples; sample++) {
+        uint64_t now = now_ns();
+
+        for (size_t i = 0; i < count; i++) {
+            uint64_t since = previous ? previous
+                                      : targets[i].reader.map->started_ns;
+
+            print_target(&targets[i], (double) (now - since) / 1e9);
+        }
+
+        previous = now;
+        fflush(stdout);
+
+        if (samples == 0 || sample + 1 < samples) nanosleep(&pause, NULL);
+    }
+
+    for (size_t i = 0; i < count; i++) result_stats_detach(&targets[i].reader);
+    free(targets);
+
+    return 0;
+}
@@ -0,0 +1,214 @@
+/*
+    RESULT-SYMBOLIZE.C - Offline symbolization of result backtraces
+
+    Copyright (C) 2024 Mariusz Łapkowski
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+    result-symbolize [-d debug-dir]... [file...]
+
+    Copies the panic output (or anything else) from the files, or the
+    standard input, and follows every frame printed by result_backtrace_print
+    with its functions, inlined ones included, and source lines. The debug
+    files are found by the build-id in the debug directories given, then in
+    /usr/lib/debug, the modules themselves are used otherwise. The lines
+    come from addr2line, or the one set in the ADDR2LINE variable
+    (eu-addr2line, llvm-addr2line).
+*/
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <unistd.h>
+
+#define ___SYMBOLIZE_MAX_DIRECTORIES 16
+#define ___SYMBOLIZE_PATH_SIZE 4096
+
+typedef struct {
+    const char*     addr2line;
+    const char*     directories[___SYMBOLIZE_MAX_DIRECTORIES];
+    size_t          directories_count;
+} ___SYMBOLIZE_OPTIONS;
+
+/* Single quotes for the shell, the paths come from the backtraces */
+static void ___symbolize_quote(FILE* out, const char* text)
+{
+    fputc('\'', out);
+
+    for (; *text != '\0'; text++) {
+        if (*text == '\'') fputs("'\\''", out);
+        else fputc(*text, out);
+    }
+
+    fputc('\'', out);
+}
+
+static bool ___symbolize_debug_file(const ___SYMBOLIZE_OPTIONS* options,
+                                    const char* build_id, char* path,
+                                    size_t size)
+{
+    if (strlen(build_id) < 3) return false;
+
+    for (size_t i = 0; i < options->directories_count; i++) {
+        snprintf(path, size, "%s/.build-id/%.2s/%s.debug",
+                 options->directories[i], build_id, build_id + 2);
+
+        if (access(path, R_OK) == 0) return true;
+    }
+
+    return false;
+}
+
+static void ___symbolize_frame(const ___SYMBOLIZE_OPTIONS* options,
+                               const char* module, unsigned long long offset,
+                               const char* build_id)
+{
+    char debug_file[___SYMBOLIZE_PATH_SIZE];
+    char* command = NULL;
+    size_t command_size = 0;
+
+    if (build_id[0] != '\0'
+        && ___symbolize_debug_file(options, build_id, debug_file,
+                                   sizeof(debug_file)))
+        module = debug_file;
+
+    FILE* text = open_memstream(&command, &command_size);
+    if (text == NULL) return;
+
+    /* Return addresses point past the calls, one byte back is inside them */
+    fprintf(text, "%s -f -C -i -p -e ", options->addr2line);
+    ___symbolize_quote(text, module);
+    fprintf(text, " 0x%llx 2>/dev/null", offset > 0 ? offset - 1 : 0);
+    fclose(text);
+
+    FILE* lines = popen(command, "r");
+    free(command);
+    if (lines == NULL) return;
+
+    char line[___SYMBOLIZE_PATH_SIZE];
+    while (fgets(line, sizeof(line), lines) != NULL)
+        printf("        %s", line);
+
+    pclose(lines);
+}
+
+/* The last occurrence of the needle, the module paths may contain it too */
+static char* ___symbolize_last(char* text, const char* needle)
+{
+    char* last = NULL;
+
+    for (char* found = strstr(text, needle); found != NULL;
+         found = strstr(found + 1, needle))
+        last = found;
+
+    return last;
+}
+
+static void ___symbolize_line(const ___SYMBOLIZE_OPTIONS* options,
+                              const char* line)
+{
+    char module[___SYMBOLIZE_PATH_SIZE + 256];
+    char build_id[128] = "";
+    unsigned int frame;
+    unsigned long long address, offset;
+    int consumed = -1;
+
+    fputs(line, stdout);
+
+    /*
+        "#<frame> 0x<address> <module>+0x<offset> (build-id <hex>)", the
+        module path runs to the offset and may contain spaces
+    */
+    sscanf(line, " #%u 0x%llx %n", &frame, &address, &consumed);
+    if (consumed < 0) return;
+
+    snprintf(module, sizeof(module), "%s", line + consumed);
+    module[strcspn(module, "\n")] = '\0';
+
+    char* suffix = ___symbolize_last(module, " (build-id ");
+    if (suffix != NULL
+        && sscanf(suffix, " (build-id %127[0-9a-f])", build_id) == 1)
+        *suffix = '\0';
+
+    char* plus = ___symbolize_last(module, "+0x");
+    if (plus == NULL || plus == module
+        || sscanf(plus, "+0x%llx", &offset) != 1)
+        return;
+    *plus = '\0';
+
+    ___symbolize_frame(options, module, offset, build_id);
+}
+
+static int ___symbolize_file(const ___SYMBOLIZE_OPTIONS* options, FILE* file)
+{
+    char line[___SYMBOLIZE_PATH_SIZE + 256];
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        ___symbolize_line(options, line);
+        fflush(stdout);
+    }
+
+    return ferror(file) ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+    ___SYMBOLIZE_OPTIONS options = {
+        .addr2line = getenv("ADDR2LINE"),
+    };
+    int option;
+
+    if (options.addr2line == NULL || options.addr2line[0] == '\0')
+        options.addr2line = "addr2line";
+
+    while ((option = getopt(argc, argv, "d:")) != -1) {
+        /* One directory is left for /usr/lib/debug */
+        if (option == 'd'
+            && options.directories_count < ___SYMBOLIZE_MAX_DIRECTORIES - 1) {
+            options.directories[options.directories_count++] = optarg;
+            continue;
+        }
+
+        fprintf(stderr, "usage: %s [-d debug-dir]... [file...]\n", argv[0]);
+        return 2;
+    }
+
+    options.directories[options.directories_count++] = "/usr/lib/debug";
+
+    if (optind == argc) return ___symbolize_file(&options, stdin);
+
+    int status = 0;
+
+    for (int i = optind; i < argc; i++) {
+        FILE* file = fopen(argv[i], "r");
+
+        if (file == NULL) {
+            perror(argv[i]);
+            status = 1;
+            continue;
+        }
+
+        status |= ___symbolize_file(&options, file);
+        fclose(file);
+    }
+
+    return status;
+}